@@ -23,11 +23,13 @@
 
 
 #include <stdlib.h>
+#include <stddef.h>
 #include <math.h>
 #include "Arduino.h"
 #include "pins_arduino.h"
 #include "GpsDataType.h"
 #include "AQMath.h"
+#include "BiquadFilter.h"
 #include "Receiver.h"
 
 // Flight Software Version
@@ -73,20 +75,56 @@ byte safetyCheck = OFF;
 byte maxLimit = OFF;
 byte minLimit = OFF;
 float filteredAccel[3] = {0.0,0.0,0.0};
+#if defined(FixedPointKernels)
+  BiquadCascadeFixed<AccelLowPass100Hz, 3> accelFilter; // meterPerSecSec to filteredAccel
+#else
+  BiquadCascade<AccelLowPass100Hz, 3> accelFilter; // meterPerSecSec to filteredAccel
+#endif
 boolean inFlight = false; // true when motor are armed and that the user pass one time the min throttle
 float rotationSpeedFactor = 1.0;
+unsigned int gyroCalibrationTime = 0; // ms the boot gyro calibration took until the craft was still
+unsigned int gyroCalibrationAttempts = 0;
 
 // main loop time variable
 unsigned long previousTime = 0;
 unsigned long currentTime = 0;
 unsigned long deltaTime = 0;
 // sub loop time variable
-unsigned long oneHZpreviousTime = 0;
 unsigned long tenHZpreviousTime = 0;
 unsigned long lowPriorityTenHZpreviousTime = 0;
-unsigned long lowPriorityTenHZpreviousTime2 = 0;
 unsigned long fiftyHZpreviousTime = 0;
 unsigned long hundredHZpreviousTime = 0;
+// the periodic tasks run from the task table of the scheduler in AeroQuad.ino
+void initializeSchedulerTasks();
+boolean isHundredHzTaskDue();
+void runControlTasks();
+
+// With AeroQuadRTOS the sensors, the control loop, telemetry, GPS and OSD are FreeRTOS tasks,
+// see AeroQuad32/AeroQuadRTOS.h. RTOS_LOCK() keeps the other tasks out of short sections
+// that use data of another task, interrupts keep running.
+#if defined(AeroQuadRTOS)
+  #include <MapleFreeRTOS.h>
+  #define RTOS_LOCK()   vTaskSuspendAll()
+  #define RTOS_UNLOCK() xTaskResumeAll()
+  void printRTOSTaskStatistics();
+#else
+  #define RTOS_LOCK()
+  #define RTOS_UNLOCK()
+#endif
+
+// inner rate loop, the rate PIDs and the motor output run at RateLoopFrequency when defined,
+// otherwise with the 100Hz task
+#if defined(RateLoopFrequency)
+  #if !defined(AeroQuadSTM32) && !defined(AeroQuadSIL)
+    #error "RateLoopFrequency needs an STM32 board, the AVR boards have no time for the rate PIDs above 100Hz"
+  #endif
+  #define RATE_LOOP_PERIOD (1000000 / RateLoopFrequency)
+  unsigned long rateLoopPreviousTime = 0;
+  #define isRateLoopDue() (currentTime - rateLoopPreviousTime >= RATE_LOOP_PERIOD)
+#else
+  #define RATE_LOOP_PERIOD 10000
+  #define isRateLoopDue() isHundredHzTaskDue()
+#endif
 
 
 
@@ -330,9 +368,39 @@ typedef struct {
   float SERVOTXCHANNELS_ADR;
   // GPS mission storing
   float GPS_MISSION_NB_POINT_ADR;
-  GeodeticPosition WAYPOINT_ADR[MAX_WAYPOINTS];
+  #if !defined (__AVR_ATmega328P__) && !defined(__AVR_ATmegaUNO__)
+    // no GPS navigator on the 328p, without the waypoints two records fit in its 1KB EEPROM
+    // and the RAM copy of the record is 192 bytes smaller
+    GeodeticPosition WAYPOINT_ADR[MAX_WAYPOINTS];
+  #endif
 } t_NVR_Data;  
 
+// The configuration is stored as one record, a header followed by t_NVR_Data, in two slots
+// written in turn, see ConfigStore.h
+// New fields go to the end of t_NVR_Data, a changed layout increments NVR_LAYOUT_VERSION
+// and gets a migration function in DataStorage.h
+#define NVR_MAGIC 0x5141 // "AQ"
+#define NVR_LAYOUT_VERSION 1
+
+typedef struct {
+  unsigned short crc;     // CRC-16-CCITT of the record from size on, written last
+  unsigned short size;    // bytes of t_NVR_Data stored
+  unsigned short magic;
+  unsigned short version; // layout version
+  uint32_t sequence;      // incremented by every record write, the newer valid slot is loaded
+} t_NVR_Header;
+
+typedef struct {
+  t_NVR_Header header;
+  t_NVR_Data data;
+} t_NVR_Record;
+
+#define NVR_DATA_SIZE sizeof(t_NVR_Data)
+#if defined (__AVR_ATmega328P__) || defined(__AVR_ATmegaUNO__)
+  #define NVR_SLOT_SIZE 512
+#else
+  #define NVR_SLOT_SIZE 1024 // slot 1 starts behind the AeroQuad 3.2 configuration at address 0
+#endif
 
 void readEEPROM(); 
 void initSensorsZeroFromEEPROM();
@@ -346,7 +414,7 @@ void nvrWriteLong(long value, int address); // defined in DataStorage.h
 void nvrReadPID(unsigned char IDPid, unsigned int IDEeprom);
 void nvrWritePID(unsigned char IDPid, unsigned int IDEeprom);
 
-#define GET_NVR_OFFSET(param) ((int)&(((t_NVR_Data*) 0)->param))
+#define GET_NVR_OFFSET(param) ((int)(intptr_t)&(((t_NVR_Data*) 0)->param))
 #define readFloat(addr) nvrReadFloat(GET_NVR_OFFSET(addr))
 #define writeFloat(value, addr) nvrWriteFloat(value, GET_NVR_OFFSET(addr))
 #define readLong(addr) nvrReadLong(GET_NVR_OFFSET(addr))
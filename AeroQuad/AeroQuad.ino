@@ -28,6 +28,10 @@
 
 #include "UserConfiguration.h" // Edit this file first before uploading to the AeroQuad
 
+#ifdef AeroQuadSIL
+  #include "SILConfiguration.h" // Linux host build, replaces the board selected above
+#endif
+
 //
 // Define Security Checks
 //
@@ -58,7 +62,7 @@
 #include "AeroQuad.h"
 #include "PID.h"
 #include <AQMath.h>
-#include <FourtOrderFilter.h>
+#include <BiquadFilter.h>
 #ifdef BattMonitor
   #include <BatteryMonitorTypes.h>
 #endif
@@ -382,7 +386,7 @@
    * Measure critical sensors
    */
   void measureCriticalSensors() {
-    if (deltaTime >= 10000) {
+    if (isHundredHzTaskDue()) {
       measureGyro();
       measureAccel();
     }
@@ -754,7 +758,7 @@
    * Measure critical sensors
    */
   void measureCriticalSensors() {
-    if (deltaTime >= 10000) {
+    if (isHundredHzTaskDue()) {
       readWiiSensors();
       measureGyro();
       measureAccel();
@@ -844,7 +848,7 @@
    * Measure critical sensors
    */
   void measureCriticalSensors() {
-    if (deltaTime >= 10000) {
+    if (isHundredHzTaskDue()) {
       readWiiSensors();
       measureGyro();
       measureAccel();
@@ -942,7 +946,7 @@
    * Measure critical sensors
    */
   void measureCriticalSensors() {
-    if (deltaTime >= 10000) {
+    if (isHundredHzTaskDue()) {
       chr6dm.read();
       measureGyro();
       measureAccel();
@@ -1045,7 +1049,7 @@
    * Measure critical sensors
    */
   void measureCriticalSensors() {
-    if (deltaTime >= 10000) {
+    if (isHundredHzTaskDue()) {
       chr6dm.read();
       measureGyro();
       measureAccel();
@@ -1063,6 +1067,10 @@
   #include "AeroQuad_STM32.h"
 #endif
 
+#ifdef AeroQuadSIL
+  #include "AeroQuad_SIL.h"
+#endif
+
 // default to 10bit ADC (AVR)
 #ifndef ADC_NUMBER_OF_BITS
 #define ADC_NUMBER_OF_BITS 10
@@ -1108,6 +1116,8 @@
   #include <Receiver_STM32PPM.h>  
 #elif defined(RECEIVER_STM32)
   #include <Receiver_STM32.h>  
+#elif defined(RECEIVER_SIL)
+  #include <Receiver_SIL.h>
 #endif
 
 #if defined(UseAnalogRSSIReader) 
@@ -1127,6 +1137,8 @@
   #if defined (MOTOR_STM32)
     #define MOTORS_STM32_TRI
     #include <Motors_STM32.h>    
+  #elif defined (MOTOR_SIL)
+    #include <Motors_SIL.h>
   #else
     #include <Motors_Tri.h>
   #endif
@@ -1140,6 +1152,8 @@
   #include <Motors_I2C.h>
 #elif defined(MOTOR_STM32)
   #include <Motors_STM32.h>    
+#elif defined(MOTOR_SIL)
+  #include <Motors_SIL.h>
 #endif
 
 //********************************************************
@@ -1279,6 +1293,8 @@
 #include "FlightControlProcessor.h"
 #include "FlightCommandProcessor.h"
 #include "HeadingHoldProcessor.h"
+#include "TaskProfiler.h"
+#include "TaskScheduler.h"
 #include "DataStorage.h"
 
 #if defined(UseGPS) || defined(BattMonitor)
@@ -1305,13 +1321,18 @@ void setup() {
 
   initCommunication();
   
-  readEEPROM(); // defined in DataStorage.h
+  byte configState = loadConfigStore(); // defined in DataStorage.h
+  readEEPROM();
   boolean firstTimeBoot = false;
-  if (readFloat(SOFTWARE_VERSION_ADR) != SOFTWARE_VERSION) { // If we detect the wrong soft version, we init all parameters
+  if (configState == CONFIG_STORE_DEFAULTS) { // If there is no valid configuration, we init all parameters
     initializeEEPROM();
     writeEEPROM();
     firstTimeBoot = true;
   }
+  else if (configState == CONFIG_STORE_MIGRATED) {
+    writeFloat(SOFTWARE_VERSION, SOFTWARE_VERSION_ADR);
+    flushConfigStore();
+  }
   
   initPlatform();
   
@@ -1330,13 +1351,20 @@ void setup() {
   // If sensors have a common initialization routine
   // insert it into the gyro class because it executes first
   initializeGyro(); // defined in Gyro.h
-  while (!calibrateGyro()); // this make sure the craft is still befor to continue init process
+  unsigned long gyroCalibrationStart = millis();
+  do { // this make sure the craft is still befor to continue init process
+    gyroCalibrationAttempts++;
+  } while (!calibrateGyro());
+  gyroCalibrationTime = millis() - gyroCalibrationStart;
   initializeAccel(); // defined in Accel.h
   if (firstTimeBoot) {
     computeAccelBias();
+    storeSensorsZeroToEEPROM();
     writeEEPROM();
+    flushConfigStore();
   }
-  setupFourthOrder();
+  const float accelAtRest[3] = {0.0, 0.0, -9.8065};
+  accelFilter.initialize(accelAtRest);
   initSensorsZeroFromEEPROM();
   
   // Integral Limit for attitude mode
@@ -1406,28 +1434,81 @@ void setup() {
      initSlowTelemetry();
   #endif
 
+  #ifdef TaskProfiler
+    initializeTaskProfiler();
+  #endif
+
+  #ifdef MPU6000_BATCH
+    resetMPU6000Batch();
+  #endif
+
   previousTime = micros();
+  initializeSchedulerTasks();
   digitalWrite(LED_Green, HIGH);
   safetyCheck = 0;
 }
 
 
+/*******************************************************************
+ * Rate loop task, runs at RateLoopFrequency
+ ******************************************************************/
+#if defined(RateLoopFrequency)
+  // gyro rates of the rate loop cycles of one 100Hz frame, averaged for the kinematics
+  float rateLoopGyroSum[3] = {0.0,0.0,0.0};
+  byte rateLoopCount = 0;
+
+  void processRateLoopTask() {
+    rateLoopPreviousTime = currentTime;
+
+    RTOS_LOCK();
+    evaluateGyroRate();
+    RTOS_UNLOCK();
+    for (byte axis = XAXIS; axis <= ZAXIS; axis++) {
+      rateLoopGyroSum[axis] += gyroRate[axis];
+    }
+    rateLoopCount++;
+
+    processRateControl();
+  }
+#endif
+
 /*******************************************************************
  * 100Hz task
  ******************************************************************/
-void process100HzTask() {
+byte process100HzTask(byte slice, unsigned long now) {
   
-  G_Dt = (currentTime - hundredHZpreviousTime) / 1000000.0;
-  hundredHZpreviousTime = currentTime;
+  frameCounter++;
+  if (frameCounter >= 100) {
+    frameCounter = 0;
+  }
+  previousTime = now;
+
+  G_Dt = (now - hundredHZpreviousTime) / 1000000.0;
+  hundredHZpreviousTime = now;
   
-  evaluateGyroRate();
+  #if defined(RateLoopFrequency)
+    float kinematicsGyro[3];
+    for (byte axis = XAXIS; axis <= ZAXIS; axis++) {
+      kinematicsGyro[axis] = rateLoopCount ? rateLoopGyroSum[axis] / rateLoopCount : gyroRate[axis];
+      rateLoopGyroSum[axis] = 0.0;
+    }
+    rateLoopCount = 0;
+    RTOS_LOCK();
+  #else
+    RTOS_LOCK();
+    evaluateGyroRate();
+    float *kinematicsGyro = gyroRate;
+  #endif
   evaluateMetersPerSec();
+  RTOS_UNLOCK();
 
-  for (int axis = XAXIS; axis <= ZAXIS; axis++) {
-    filteredAccel[axis] = computeFourthOrder(meterPerSecSec[axis], &fourthOrder[axis]);
-  }
+  accelFilter.filter(meterPerSecSec, filteredAccel);
     
-  calculateKinematics(gyroRate[XAXIS], gyroRate[YAXIS], gyroRate[ZAXIS], filteredAccel[XAXIS], filteredAccel[YAXIS], filteredAccel[ZAXIS], G_Dt);
+  #if defined(FixedPointKernels) && defined(KINEMATICS_FIXED_ACCEL)
+    calculateKinematicsFixed(kinematicsGyro[XAXIS], kinematicsGyro[YAXIS], kinematicsGyro[ZAXIS], accelFilter.fixedOutput(), G_Dt);
+  #else
+    calculateKinematics(kinematicsGyro[XAXIS], kinematicsGyro[YAXIS], kinematicsGyro[ZAXIS], filteredAccel[XAXIS], filteredAccel[YAXIS], filteredAccel[ZAXIS], G_Dt);
+  #endif
   
   #if defined AltitudeHoldBaro || defined AltitudeHoldRangeFinder
     zVelocity = (filteredAccel[ZAXIS] * (1 - accelOneG * invSqrt(isq(filteredAccel[XAXIS]) + isq(filteredAccel[YAXIS]) + isq(filteredAccel[ZAXIS])))) - runTimeAccelBias[ZAXIS] - runtimeZBias;
@@ -1445,6 +1526,9 @@ void process100HzTask() {
       evaluateBaroAltitude();
     }
   #endif
+
+  // receiver at the control rate, the stick functions stay in the 50Hz task
+  readReceiver();
         
   processFlightControl();
   
@@ -1460,27 +1544,28 @@ void process100HzTask() {
     updateSlowTelemetry100Hz();
   #endif
 
-  #if defined(UseGPS)
+  #if defined(UseGPS) && !defined(AeroQuadRTOS)
     updateGps();
   #endif      
   
   #if defined(CameraControl)
-    moveCamera(kinematicsAngle[YAXIS],kinematicsAngle[XAXIS],kinematicsAngle[ZAXIS]);
+    moveCamera(getKinematicsAngle(YAXIS),getKinematicsAngle(XAXIS),getKinematicsAngle(ZAXIS));
     #if defined CameraTXControl
       processCameraTXControl();
     #endif
   #endif       
 
+  return TASK_DONE;
 }
 
 /*******************************************************************
  * 50Hz task
  ******************************************************************/
-void process50HzTask() {
-  G_Dt = (currentTime - fiftyHZpreviousTime) / 1000000.0;
-  fiftyHZpreviousTime = currentTime;
+byte process50HzTask(byte slice, unsigned long now) {
+  G_Dt = (now - fiftyHZpreviousTime) / 1000000.0;
+  fiftyHZpreviousTime = now;
 
-  // Reads external pilot commands and performs functions based on stick configuration
+  // Performs functions based on stick configuration
   readPilotCommands(); 
   
   #if defined(UseAnalogRSSIReader) || defined(UseEzUHFRSSIReader) || defined(UseSBUSRSSIReader)
@@ -1496,129 +1581,187 @@ void process50HzTask() {
       initHomeBase();
     }
   #endif      
+  return TASK_DONE;
 }
 
 /*******************************************************************
  * 10Hz task
  ******************************************************************/
-void process10HzTask1() {
+byte process10HzTask1(byte slice, unsigned long now) {
   
   #if defined(HeadingMagHold)
   
-    G_Dt = (currentTime - tenHZpreviousTime) / 1000000.0;
-    tenHZpreviousTime = currentTime;
+    G_Dt = (now - tenHZpreviousTime) / 1000000.0;
+    tenHZpreviousTime = now;
      
-    measureMagnetometer(kinematicsAngle[XAXIS], kinematicsAngle[YAXIS]);
+    measureMagnetometer(getKinematicsAngle(XAXIS), getKinematicsAngle(YAXIS));
     
     calculateHeading();
     
   #endif
+  return TASK_DONE;
 }
 
 /*******************************************************************
- * low priority 10Hz task 2
+ * low priority 10Hz task 2, commands and telemetry in two slices
+ * The low priority tasks keep their own time, with AeroQuadRTOS they run
+ * beside the control task and must not touch its currentTime and G_Dt
  ******************************************************************/
-void process10HzTask2() {
-  G_Dt = (currentTime - lowPriorityTenHZpreviousTime) / 1000000.0;
-  lowPriorityTenHZpreviousTime = currentTime;
-  
-  #if defined(BattMonitor)
-    measureBatteryVoltage(G_Dt*1000.0);
-  #endif
+byte process10HzTask2(byte slice, unsigned long now) {
+  if (slice == 0) {
+    #if defined(BattMonitor)
+      measureBatteryVoltage((now - lowPriorityTenHZpreviousTime) / 1000.0);
+    #endif
+    lowPriorityTenHZpreviousTime = now;
 
-  // Listen for configuration commands and reports telemetry
-  readSerialCommand();
+    // Listen for configuration commands
+    RTOS_LOCK();
+    readSerialCommand();
+    RTOS_UNLOCK();
+    return TASK_CONTINUE;
+  }
+
+  // Reports telemetry
   sendSerialTelemetry();
+  return TASK_DONE;
 }
 
 /*******************************************************************
- * low priority 10Hz task 3
+ * low priority 10Hz task 3, OSD menu, OSD and status in three slices
  ******************************************************************/
-void process10HzTask3() {
-    G_Dt = (currentTime - lowPriorityTenHZpreviousTime2) / 1000000.0;
-    lowPriorityTenHZpreviousTime2 = currentTime;
-
+byte process10HzTask3(byte slice, unsigned long now) {
+  switch (slice) {
+  case 0:
     #ifdef OSD_SYSTEM_MENU
+      RTOS_LOCK();
       updateOSDMenu();
+      RTOS_UNLOCK();
     #endif
+    return TASK_CONTINUE;
 
+  case 1:
     #ifdef MAX7456_OSD
       updateOSD();
     #endif
+    return TASK_CONTINUE;
+  }
     
-    #if defined(UseGPS) || defined(BattMonitor)
-      processLedStatus();
-    #endif
+  #if defined(UseGPS) || defined(BattMonitor)
+    processLedStatus();
+  #endif
     
-    #ifdef SlowTelemetry
-      updateSlowTelemetry10Hz();
-    #endif
+  #ifdef SlowTelemetry
+    updateSlowTelemetry10Hz();
+  #endif
+  return TASK_DONE;
 }
 
 /*******************************************************************
  * 1Hz task 
  ******************************************************************/
-void process1HzTask() {
+byte process1HzTask(byte slice, unsigned long now) {
   #ifdef MavLink
-    G_Dt = (currentTime - oneHZpreviousTime) / 1000000.0;
-    oneHZpreviousTime = currentTime;
-    
     sendSerialHeartbeat();   
   #endif
+  return TASK_DONE;
 }
 
 /*******************************************************************
- * Main loop funtions
+ * 10Hz configuration store task, one changed EEPROM unit per slice
  ******************************************************************/
-void loop () {
-  
-  currentTime = micros();
-  deltaTime = currentTime - previousTime;
+byte processConfigStoreTask(byte slice, unsigned long now) {
+  return writeConfigStoreUnit() ? TASK_CONTINUE : TASK_DONE;
+}
 
-  measureCriticalSensors();
+/*******************************************************************
+ * Task table, offsets put the 10Hz and 1Hz tasks into separate 100Hz frames
+ * With AeroQuadRTOS the low priority tasks run in their own RTOS tasks
+ ******************************************************************/
+enum {
+  SCHEDULER_100HZ_TASK = 0,
+  SCHEDULER_50HZ_TASK,
+  SCHEDULER_10HZ_1_TASK,
+  #if !defined(AeroQuadRTOS)
+    SCHEDULER_10HZ_2_TASK,
+    SCHEDULER_10HZ_3_TASK,
+    SCHEDULER_1HZ_TASK,
+    SCHEDULER_CONFIG_STORE_TASK,
+  #endif
+  LAST_SCHEDULER_TASK
+};
+
+struct SchedulerTask schedulerTasks[LAST_SCHEDULER_TASK] = {
+  // function              period  offset budget  priority  profiler
+  {process100HzTask,         10000,      0,  5000, 0, TASK_100HZ_IDX},
+  {process50HzTask,          20000,      0,  2000, 1, TASK_50HZ_IDX},
+  {process10HzTask1,        100000,      0,  2000, 2, TASK_10HZ_1_IDX},
+#if !defined(AeroQuadRTOS)
+  {process10HzTask2,        100000,  10000,  2000, 3, TASK_10HZ_2_IDX},
+  {process10HzTask3,        100000,  20000,  2000, 4, TASK_10HZ_3_IDX},
+  {process1HzTask,         1000000,  30000,  2000, 5, TASK_1HZ_IDX},
+  {processConfigStoreTask,  100000,  40000,  4000, 6, TASK_CONFIG_STORE_IDX},
+#endif
+};
+
+void initializeSchedulerTasks() {
+  initializeTaskScheduler(schedulerTasks, LAST_SCHEDULER_TASK, previousTime);
+}
+
+boolean isHundredHzTaskDue() {
+  return isSchedulerTaskDue(&schedulerTasks[SCHEDULER_100HZ_TASK], currentTime);
+}
 
+/*******************************************************************
+ * Rate loop and scheduled tasks, run after each sensor reading
+ ******************************************************************/
+void runControlTasks() {
   // ================================================================
-  // 100Hz task loop
+  // Rate loop, ahead of the 100Hz task so that it gets the new samples
   // ================================================================
-  if (deltaTime >= 10000) {
-    
-    frameCounter++;
-    
-    process100HzTask();
-
-    // ================================================================
-    // 50Hz task loop
-    // ================================================================
-    if (frameCounter % TASK_50HZ == 0) {  //  50 Hz tasks
-      process50HzTask();
+  #if defined(RateLoopFrequency)
+    if (isRateLoopDue() && gyroSampleCount > 0) {
+      TASK_PROFILER_BEGIN(TASK_RATE_IDX);
+      processRateLoopTask();
+      TASK_PROFILER_END(TASK_RATE_IDX);
     }
+  #endif
 
-    // ================================================================
-    // 10Hz task loop
-    // ================================================================
-    if (frameCounter % TASK_10HZ == 0) {  //   10 Hz tasks
-      process10HzTask1();
-    }
-    else if ((currentTime - lowPriorityTenHZpreviousTime) > 100000) {
-      process10HzTask2();
-    }
-    else if ((currentTime - lowPriorityTenHZpreviousTime2) > 100000) {
-      process10HzTask3();
+  // ================================================================
+  // Scheduled tasks, a 100Hz frame starts with each release of the 100Hz task
+  // ================================================================
+  #ifdef TaskProfiler
+    boolean frameStart = isHundredHzTaskDue() && !schedulerTasks[SCHEDULER_100HZ_TASK].pending;
+    if (frameStart) {
+      TASK_PROFILER_BEGIN(TASK_FRAME_IDX);
     }
-    
-    // ================================================================
-    // 1Hz task loop
-    // ================================================================
-    if (frameCounter % TASK_1HZ == 0) {  //   1 Hz tasks
-      process1HzTask();
+  #endif
+
+  runTaskScheduler(schedulerTasks, LAST_SCHEDULER_TASK, currentTime);
+
+  #ifdef TaskProfiler
+    if (frameStart) {
+      TASK_PROFILER_END(TASK_FRAME_IDX);
     }
-    
-    previousTime = currentTime;
-  }
+  #endif
+}
+
+/*******************************************************************
+ * Main loop funtions
+ ******************************************************************/
+void loop () {
   
-  if (frameCounter >= 100) {
-      frameCounter = 0;
-  }
+  currentTime = micros();
+  deltaTime = currentTime - previousTime;
+
+  #ifdef I2C_QUEUE
+    processI2CQueue();
+  #endif
+
+  TASK_PROFILER_BEGIN(TASK_SENSORS_IDX);
+  measureCriticalSensors();
+  TASK_PROFILER_END(TASK_SENSORS_IDX);
+
+  runControlTasks();
 }
 
 
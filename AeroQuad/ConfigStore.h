@@ -0,0 +1,296 @@
+/*
+  AeroQuad v3.0.1 - February 2012
+  www.AeroQuad.com
+  Copyright (c) 2012 Ted Carancho.  All rights reserved.
+  An Open Source Arduino based multicopter.
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef _AQ_CONFIG_STORE_H_
+#define _AQ_CONFIG_STORE_H_
+
+// The EEPROM side of DataStorage.h, it only needs t_NVR_Record and EEPROM so that
+// AeroQuadSIL/FlashEEPROM/ConfigStoreBench.cpp can run it on the STM32 flash emulation
+
+// Utilities for writing and reading from the EEPROM
+// The configuration record (t_NVR_Record in AeroQuad.h) is loaded into RAM at boot with one block read,
+// values are read and changed in RAM and processConfigStoreTask() writes the changes to the EEPROM later
+// The EEPROM is read and written in units, bytes on AVR and 16 bit words on STM32
+#ifdef EEPROM_USES_16BIT_WORDS
+  typedef unsigned short t_NVR_Unit;
+#else
+  typedef byte t_NVR_Unit;
+#endif
+#define NVR_UNIT_SIZE      ((int)sizeof(t_NVR_Unit))
+#define NVR_FIELD_SIZE     4 // float or long
+#define NVR_DATA_ADDRESS   ((int)sizeof(t_NVR_Header))
+#define NVR_FIELDS         ((int)((NVR_DATA_ADDRESS + NVR_DATA_SIZE) / NVR_FIELD_SIZE))
+#define NVR_CRC_FIELD      ((int)offsetof(t_NVR_Header, crc) / NVR_FIELD_SIZE)
+#define NVR_SEQUENCE_FIELD ((int)offsetof(t_NVR_Header, sequence) / NVR_FIELD_SIZE)
+#define NVR_CRC_START      ((int)offsetof(t_NVR_Header, crc) + (int)sizeof(unsigned short))
+#define NVR_SLOTS          2
+
+// compile time check that a record fits into its slot, the array size is negative otherwise
+typedef char nvrRecordFitsSlot[NVR_DATA_ADDRESS + (int)NVR_DATA_SIZE <= NVR_SLOT_SIZE ? 1 : -1];
+
+// Configuration store
+// The EEPROM holds two record slots NVR_SLOT_SIZE apart, the one with the newest valid record is loaded
+// A changed value marks its field dirty, processConfigStoreTask() writes one changed EEPROM unit of the
+// dirty fields per slice into the other slot, then the incremented sequence number and the CRC last,
+// so a parameter change does not stall the loop and a power loss while writing leaves the last record intact
+// The written slot holds the newest record from then on and the next changes go to the other one, which also
+// gets the fields changed in between, a field is dirty for each slot until it is written there
+// A value changed again before it is written costs no extra write, units already holding the new value are skipped
+t_NVR_Record nvrRecord;
+byte nvrDirtyField[NVR_SLOTS][(NVR_FIELDS + 7) / 8];
+byte nvrActiveSlot = 0;            // slot of the newest valid record, never written
+boolean nvrCommitPending = false;  // the other slot is behind the RAM record
+boolean nvrCrcDirty = false;       // a field changed since the CRC was computed
+unsigned long configStoreUnitWrites = 0; // EEPROM units written since boot
+
+enum {
+  CONFIG_STORE_LOADED = 0,
+  CONFIG_STORE_MIGRATED, // from an older layout version
+  CONFIG_STORE_DEFAULTS  // no valid record, setup() writes the defaults
+};
+byte configStoreState = CONFIG_STORE_DEFAULTS;
+
+unsigned short nvrCrc16(const byte *data, int size) {
+  unsigned short crc = 0xFFFF;
+  for (int i = 0; i < size; i++) {
+    crc ^= (unsigned short)data[i] << 8;
+    for (byte bit = 0; bit < 8; bit++) {
+      crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : crc << 1;
+    }
+  }
+  return crc;
+}
+
+// CRC of the record from the size field on, header fields and data
+unsigned short nvrRecordCrc(const t_NVR_Record *record) {
+  return nvrCrc16((const byte *)record + NVR_CRC_START, NVR_DATA_ADDRESS - NVR_CRC_START + record->header.size);
+}
+
+int nvrSlotAddress(byte slot) {
+  return slot * NVR_SLOT_SIZE;
+}
+
+// copied bytewise, the units fill fields of other types
+void nvrReadBlock(int address, void *data, int size) {
+  byte *block = (byte *)data;
+  for (int i = 0; i + NVR_UNIT_SIZE <= size; i += NVR_UNIT_SIZE) {
+    t_NVR_Unit unit = EEPROM.read(address + i);
+    memcpy(block + i, &unit, NVR_UNIT_SIZE);
+  }
+}
+
+boolean isNvrFieldDirty(byte slot, int field) {
+  return nvrDirtyField[slot][field / 8] & (1 << (field % 8));
+}
+
+void markNvrSlotFieldDirty(byte slot, int field) {
+  nvrDirtyField[slot][field / 8] |= 1 << (field % 8);
+}
+
+// a changed field is written to both slots
+void markNvrFieldDirty(int field) {
+  if (field >= NVR_FIELDS) {
+    return; // not stored on this board
+  }
+  for (byte slot = 0; slot < NVR_SLOTS; slot++) {
+    markNvrSlotFieldDirty(slot, field);
+  }
+}
+
+void markConfigStoreDirty() {
+  for (int field = 0; field < NVR_FIELDS; field++) {
+    markNvrFieldDirty(field);
+  }
+  nvrCrcDirty = true;
+  nvrCommitPending = true;
+}
+
+// the sequence number and then the CRC last, once all other fields are written
+int findDirtyNvrField(byte slot) {
+  for (int field = 0; field < NVR_FIELDS; field++) {
+    if (field != NVR_CRC_FIELD && field != NVR_SEQUENCE_FIELD && isNvrFieldDirty(slot, field)) {
+      return field;
+    }
+  }
+  if (isNvrFieldDirty(slot, NVR_SEQUENCE_FIELD)) {
+    return NVR_SEQUENCE_FIELD;
+  }
+  return isNvrFieldDirty(slot, NVR_CRC_FIELD) ? NVR_CRC_FIELD : -1;
+}
+
+// fields still to write for the pending changes
+int countDirtyNvrFields() {
+  if (!nvrCommitPending) {
+    return 0;
+  }
+  int count = 0;
+  for (int field = 0; field < NVR_FIELDS; field++) {
+    if (isNvrFieldDirty(nvrActiveSlot ^ 1, field)) {
+      count++;
+    }
+  }
+  return count;
+}
+
+// writes the first unit of the field that differs from the EEPROM slot, false when there is none
+boolean nvrWriteChangedUnit(byte slot, int field) {
+  for (byte i = 0; i < NVR_FIELD_SIZE / NVR_UNIT_SIZE; i++) {
+    int offset = field * NVR_FIELD_SIZE + NVR_UNIT_SIZE*i;
+    int address = nvrSlotAddress(slot) + offset;
+    t_NVR_Unit value;
+    memcpy(&value, (const byte *)&nvrRecord + offset, NVR_UNIT_SIZE);
+    if (EEPROM.read(address) != value) {
+      cli(); // Needed so that APM sensor data does not overflow
+      EEPROM.write(address, value);
+      sei();
+      configStoreUnitWrites++;
+      return true;
+    }
+  }
+  return false;
+}
+
+// writes one changed EEPROM unit of the dirty fields to the other slot, the CRC last,
+// false when everything is written
+boolean writeConfigStoreUnit() {
+  for (;;) {
+    RTOS_LOCK();
+    if (!nvrCommitPending) {
+      RTOS_UNLOCK();
+      return false;
+    }
+    byte slot = nvrActiveSlot ^ 1;
+    int field = findDirtyNvrField(slot);
+    if ((field < 0 || field == NVR_SEQUENCE_FIELD || field == NVR_CRC_FIELD) && nvrCrcDirty) {
+      // all data written, a newer sequence number and the CRC close the record
+      nvrRecord.header.sequence++;
+      nvrRecord.header.crc = nvrRecordCrc(&nvrRecord);
+      markNvrSlotFieldDirty(slot, NVR_SEQUENCE_FIELD);
+      markNvrSlotFieldDirty(slot, NVR_CRC_FIELD);
+      nvrCrcDirty = false;
+      RTOS_UNLOCK();
+      continue;
+    }
+    if (field < 0) {
+      // the slot holds the newest record, the next changes go to the other one
+      nvrActiveSlot = slot;
+      nvrCommitPending = false;
+      RTOS_UNLOCK();
+      return false;
+    }
+    // cleared before writing, a change meanwhile marks it again
+    nvrDirtyField[slot][field / 8] &= ~(1 << (field % 8));
+    RTOS_UNLOCK();
+
+    if (nvrWriteChangedUnit(slot, field)) {
+      RTOS_LOCK();
+      markNvrSlotFieldDirty(slot, field); // the other units are checked in the next slice
+      RTOS_UNLOCK();
+      return true;
+    }
+  }
+}
+
+// writes all changes now
+void flushConfigStore() {
+  while (writeConfigStoreUnit());
+}
+
+void nvrReadField(void *value, int address) {
+  RTOS_LOCK();
+  memcpy(value, (const byte *)&nvrRecord.data + address, NVR_FIELD_SIZE);
+  RTOS_UNLOCK();
+}
+
+void nvrWriteField(const void *value, int address) {
+  byte *field = (byte *)&nvrRecord.data + address;
+  RTOS_LOCK();
+  if (memcmp(field, value, NVR_FIELD_SIZE) != 0) {
+    memcpy(field, value, NVR_FIELD_SIZE);
+    markNvrFieldDirty((NVR_DATA_ADDRESS + address) / NVR_FIELD_SIZE);
+    nvrCrcDirty = true;
+    nvrCommitPending = true;
+  }
+  RTOS_UNLOCK();
+}
+
+float nvrReadFloat(int address) {
+  float value;
+  nvrReadField(&value, address);
+  return value;
+}
+
+void nvrWriteFloat(float value, int address) {
+  nvrWriteField(&value, address);
+}
+
+long nvrReadLong(int address) {
+  int32_t value;
+  nvrReadField(&value, address);
+  return value;
+}
+
+void nvrWriteLong(long value, int address) {
+  int32_t longIn = value;
+  nvrWriteField(&longIn, address);
+}
+
+boolean isNvrHeaderValid(const t_NVR_Header *header) {
+  return header->magic == NVR_MAGIC && header->version != 0 && header->version <= NVR_LAYOUT_VERSION &&
+         header->size <= NVR_DATA_SIZE;
+}
+
+boolean loadConfigSlot(byte slot) {
+  nvrReadBlock(nvrSlotAddress(slot), &nvrRecord, NVR_DATA_ADDRESS + nvrRecord.header.size);
+  return nvrRecordCrc(&nvrRecord) == nvrRecord.header.crc;
+}
+
+// loads the newest slot with a valid record, false when there is none
+// The headers decide which slot is read first, normally one block read is enough
+boolean loadConfigRecord() {
+  t_NVR_Header header[NVR_SLOTS];
+  for (byte slot = 0; slot < NVR_SLOTS; slot++) {
+    nvrReadBlock(nvrSlotAddress(slot), &header[slot], sizeof(t_NVR_Header));
+  }
+  byte newest = isNvrHeaderValid(&header[1]) &&
+                (!isNvrHeaderValid(&header[0]) || (int32_t)(header[1].sequence - header[0].sequence) > 0) ? 1 : 0;
+
+  memset(nvrDirtyField, 0, sizeof(nvrDirtyField));
+  nvrCommitPending = false;
+  nvrCrcDirty = false;
+  for (byte i = 0; i < NVR_SLOTS; i++) {
+    byte slot = newest ^ i;
+    nvrRecord.header = header[slot];
+    if (isNvrHeaderValid(&header[slot]) && loadConfigSlot(slot)) {
+      // content of the other slot unknown, every field is checked when it is written next
+      nvrActiveSlot = slot;
+      for (int field = 0; field < NVR_FIELDS; field++) {
+        markNvrSlotFieldDirty(slot ^ 1, field);
+      }
+      return true;
+    }
+  }
+  // the first record goes to slot 1, slot 0 may hold a record of AeroQuad 3.2 to migrate
+  nvrActiveSlot = 0;
+  nvrRecord.header.sequence = 0;
+  return false;
+}
+
+#endif // _AQ_CONFIG_STORE_H_
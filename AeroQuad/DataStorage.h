@@ -24,84 +24,55 @@
 #ifndef _AQ_DATA_STORAGE_H_
 #define _AQ_DATA_STORAGE_H_
 
-// Utilities for writing and reading from the EEPROM
-float nvrReadFloat(int address) {
-  union floatStore {
-    byte floatByte[4];
-    unsigned short floatUShort[2];
-    float floatVal;
-  } floatOut;
-
-#ifdef EEPROM_USES_16BIT_WORDS
-  for (int i = 0; i < 2; i++) {
-    floatOut.floatUShort[i] = EEPROM.read(address + 2*i);
-  }
-#else
-  for (int i = 0; i < 4; i++) {
-    floatOut.floatByte[i] = EEPROM.read(address + i);
-  }
-#endif
+#include "ConfigStore.h"
 
-  return floatOut.floatVal;
-}
+// Layout versions and migration
+// Version 0 is the t_NVR_Data of AeroQuad 3.2 at EEPROM address 0 without header, only accepted when
+// its SOFTWARE_VERSION_ADR is 3.2, older versions had other layouts and start from the defaults
+// Version 1 moved it behind the header, the fields are the same
+// Migration functions convert the record in RAM from one version to the next, fields added
+// to the end of t_NVR_Data must get their default value there
+#define NVR_LEGACY_SOFTWARE_VERSION 3.2
 
-void nvrWriteFloat(float value, int address) {
-  union floatStore {
-    byte floatByte[4];
-    unsigned short floatUShort[2];
-    float floatVal;
-  } floatIn;
-
-  floatIn.floatVal = value;
-#ifdef EEPROM_USES_16BIT_WORDS
-  for (int i = 0; i < 2; i++) {
-    EEPROM.write(address + 2*i, floatIn.floatUShort[i]);
-  }
-#else
-  for (int i = 0; i < 4; i++) {
-    EEPROM.write(address + i, floatIn.floatByte[i]);
-  }
-#endif
+void migrateConfigFromVersion0() {
 }
 
-long nvrReadLong(int address) {
-  union longStore {
-    byte longByte[4];
-    unsigned short longUShort[2];
-    long longVal;
-  } longOut;  
+void (*const nvrMigration[NVR_LAYOUT_VERSION])() = {
+  migrateConfigFromVersion0,
+};
 
-#ifdef EEPROM_USES_16BIT_WORDS
-  for (int i = 0; i < 2; i++) {
-    longOut.longUShort[i] = EEPROM.read(address + 2*i);
-  }
-#else
-  for (byte i = 0; i < 4; i++) {
-    longOut.longByte[i] = EEPROM.read(address + i);
-  }
-#endif
-    
-  return longOut.longVal;
+boolean loadLegacyConfigRecord() {
+  nvrReadBlock(0, &nvrRecord.data, NVR_DATA_SIZE);
+  return nvrRecord.data.SOFTWARE_VERSION_ADR == (float)NVR_LEGACY_SOFTWARE_VERSION;
 }
 
-void nvrWriteLong(long value, int address) {
-  union longStore {
-    byte longByte[4];
-    unsigned short longUShort[2];
-    long longVal;
-  } longIn;  
+// loads the configuration record into RAM, returns the CONFIG_STORE state
+byte loadConfigStore() {
+  byte version;
+  if (loadConfigRecord()) {
+    version = nvrRecord.header.version;
+    configStoreState = version == NVR_LAYOUT_VERSION ? CONFIG_STORE_LOADED : CONFIG_STORE_MIGRATED;
+  }
+  else if (loadLegacyConfigRecord()) {
+    version = 0;
+    configStoreState = CONFIG_STORE_MIGRATED;
+  }
+  else {
+    version = NVR_LAYOUT_VERSION;
+    configStoreState = CONFIG_STORE_DEFAULTS;
+  }
 
-  longIn.longVal = value;
-  
-#ifdef EEPROM_USES_16BIT_WORDS
-  for (int i = 0; i < 2; i++) {
-    EEPROM.write(address + 2*i, longIn.longUShort[i]);
+  for (; version < NVR_LAYOUT_VERSION; version++) {
+    nvrMigration[version]();
   }
-#else
-  for (int i = 0; i < 4; i++) {
-    EEPROM.write(address + i, longIn.longByte[i]);
+
+  if (configStoreState != CONFIG_STORE_LOADED) {
+    nvrRecord.header.magic = NVR_MAGIC;
+    nvrRecord.header.version = NVR_LAYOUT_VERSION;
+    nvrRecord.header.size = NVR_DATA_SIZE;
+    markConfigStoreDirty();
   }
-#endif
+  return configStoreState;
 }
 
 void nvrReadPID(unsigned char IDPid, unsigned int IDEeprom) {
@@ -353,8 +324,8 @@ void readEEPROM() {
   #endif   
 }
 
+// queues the values that differ from the EEPROM, see Configuration store
 void writeEEPROM(){
-  cli(); // Needed so that APM sensor data does not overflow
   writePID(XAXIS, ROLL_PID_GAIN_ADR);
   writePID(YAXIS, PITCH_PID_GAIN_ADR);
   writePID(ATTITUDE_XAXIS_PID_IDX, LEVELROLL_PID_GAIN_ADR);
@@ -460,7 +431,6 @@ void writeEEPROM(){
       writeFloat(servoTXChannels, SERVOTXCHANNELS_ADR);
     #endif
   #endif 
-  sei(); // Restart interrupts
 }
 
 void initSensorsZeroFromEEPROM() {
@@ -237,13 +237,11 @@ void processZeroThrottleFunctionFromReceiverCommand() {
 /**
  * readPilotCommands
  * 
- * This function is responsible to read receiver
- * and process command from the users
+ * This function is responsible to process command from the users,
+ * the receiver itself is read by the 100Hz task
  */
 void readPilotCommands() {
 
-  readReceiver(); 
-  
   if (receiverCommand[THROTTLE] < MINCHECK) {
     processZeroThrottleFunctionFromReceiverCommand();
   }
@@ -27,36 +27,60 @@
 
 #define ATTITUDE_SCALING (0.75 * PWM2RAD)
 
+// set by the outer loop, used by the rate loop
+float rateTarget[3] = {0.0,0.0,0.0};  // roll, pitch and yaw rate commands
+byte rateXAxisPID = RATE_XAXIS_PID_IDX;
+byte rateYAxisPID = RATE_YAXIS_PID_IDX;
+float rateGyroScale = 1.0;            // rotationSpeedFactor in rate mode
+
 
 /**
  * calculateFlightError
  *
- * Calculate roll/pitch axis error with gyro/accel data to
- * compute motor command thrust so used command are executed
+ * Outer loop, calculate the roll/pitch rate commands from the
+ * attitude error or directly from the sticks in rate mode
  */
 void calculateFlightError()
 {
   #if defined (UseGPSNavigator)
     if (navigationState == ON || positionHoldState == ON) {
-      float rollAttitudeCmd  = updatePID((receiverCommand[XAXIS] - receiverZero[XAXIS] + gpsRollAxisCorrection) * ATTITUDE_SCALING, kinematicsAngle[XAXIS], &PID[ATTITUDE_XAXIS_PID_IDX]);
-      float pitchAttitudeCmd = updatePID((receiverCommand[YAXIS] - receiverZero[YAXIS] + gpsPitchAxisCorrection) * ATTITUDE_SCALING, -kinematicsAngle[YAXIS], &PID[ATTITUDE_YAXIS_PID_IDX]);
-      motorAxisCommandRoll   = updatePID(rollAttitudeCmd, gyroRate[XAXIS], &PID[ATTITUDE_GYRO_XAXIS_PID_IDX]);
-      motorAxisCommandPitch  = updatePID(pitchAttitudeCmd, -gyroRate[YAXIS], &PID[ATTITUDE_GYRO_YAXIS_PID_IDX]);
+      rateTarget[XAXIS] = updatePID((receiverCommand[XAXIS] - receiverZero[XAXIS] + gpsRollAxisCorrection) * ATTITUDE_SCALING, getKinematicsAngle(XAXIS), &PID[ATTITUDE_XAXIS_PID_IDX]);
+      rateTarget[YAXIS] = updatePID((receiverCommand[YAXIS] - receiverZero[YAXIS] + gpsPitchAxisCorrection) * ATTITUDE_SCALING, -getKinematicsAngle(YAXIS), &PID[ATTITUDE_YAXIS_PID_IDX]);
+      rateXAxisPID = ATTITUDE_GYRO_XAXIS_PID_IDX;
+      rateYAxisPID = ATTITUDE_GYRO_YAXIS_PID_IDX;
+      rateGyroScale = 1.0;
     }
     else
   #endif
   if (flightMode == ATTITUDE_FLIGHT_MODE) {
-    float rollAttitudeCmd  = updatePID((receiverCommand[XAXIS] - receiverZero[XAXIS]) * ATTITUDE_SCALING, kinematicsAngle[XAXIS], &PID[ATTITUDE_XAXIS_PID_IDX]);
-    float pitchAttitudeCmd = updatePID((receiverCommand[YAXIS] - receiverZero[YAXIS]) * ATTITUDE_SCALING, -kinematicsAngle[YAXIS], &PID[ATTITUDE_YAXIS_PID_IDX]);
-    motorAxisCommandRoll   = updatePID(rollAttitudeCmd, gyroRate[XAXIS], &PID[ATTITUDE_GYRO_XAXIS_PID_IDX]);
-    motorAxisCommandPitch  = updatePID(pitchAttitudeCmd, -gyroRate[YAXIS], &PID[ATTITUDE_GYRO_YAXIS_PID_IDX]);
+    rateTarget[XAXIS] = updatePID((receiverCommand[XAXIS] - receiverZero[XAXIS]) * ATTITUDE_SCALING, getKinematicsAngle(XAXIS), &PID[ATTITUDE_XAXIS_PID_IDX]);
+    rateTarget[YAXIS] = updatePID((receiverCommand[YAXIS] - receiverZero[YAXIS]) * ATTITUDE_SCALING, -getKinematicsAngle(YAXIS), &PID[ATTITUDE_YAXIS_PID_IDX]);
+    rateXAxisPID = ATTITUDE_GYRO_XAXIS_PID_IDX;
+    rateYAxisPID = ATTITUDE_GYRO_YAXIS_PID_IDX;
+    rateGyroScale = 1.0;
   }
   else {
-    motorAxisCommandRoll = updatePID(getReceiverSIData(XAXIS), gyroRate[XAXIS]*rotationSpeedFactor, &PID[RATE_XAXIS_PID_IDX]);
-    motorAxisCommandPitch = updatePID(getReceiverSIData(YAXIS), -gyroRate[YAXIS]*rotationSpeedFactor, &PID[RATE_YAXIS_PID_IDX]);
+    rateTarget[XAXIS] = getReceiverSIData(XAXIS);
+    rateTarget[YAXIS] = getReceiverSIData(YAXIS);
+    rateXAxisPID = RATE_XAXIS_PID_IDX;
+    rateYAxisPID = RATE_YAXIS_PID_IDX;
+    rateGyroScale = rotationSpeedFactor;
   }
 }
 
+/**
+ * calculateRateError
+ *
+ * Inner loop, compute the axis motor commands from the rate
+ * commands and the gyro
+ */
+void calculateRateError()
+{
+  motorAxisCommandRoll  = updatePID(rateTarget[XAXIS], gyroRate[XAXIS]*rateGyroScale, &PID[rateXAxisPID]);
+  motorAxisCommandPitch = updatePID(rateTarget[YAXIS], -gyroRate[YAXIS]*rateGyroScale, &PID[rateYAxisPID]);
+  motorAxisCommandYaw   = updatePID(rateTarget[ZAXIS], gyroRate[ZAXIS], &PID[ZAXIS_PID_IDX]);
+}
+
 /**
  * processCalibrateESC
  * 
@@ -195,7 +219,7 @@ void processThrottleCorrection() {
   int throttleAdjust = 0;
   #if defined UseGPSNavigator
     if (navigationState == ON || positionHoldState == ON) {
-      throttleAdjust = throttle / (cos (kinematicsAngle[XAXIS]*0.55) * cos (kinematicsAngle[YAXIS]*0.55));
+      throttleAdjust = throttle / (fastCos(getKinematicsAngle(XAXIS)*0.55) * fastCos(getKinematicsAngle(YAXIS)*0.55));
       throttleAdjust = constrain ((throttleAdjust - throttle), 0, 50); //compensate max  +/- 25 deg XAXIS or YAXIS or  +/- 18 ( 18(XAXIS) + 18(YAXIS))
     }
   #endif
@@ -265,6 +289,54 @@ void processMinMaxCommand()
   }
 }
 
+/**
+ * processRateControl
+ *
+ * Rate loop and motor output, called from processFlightControl() or
+ * at RateLoopFrequency when it is defined
+ */
+void processRateControl() {
+
+  // ********************** Calculate Rate Error *****************************
+  calculateRateError();
+
+  // ********************** Calculate Motor Commands *************************
+  if (motorArmed && safetyCheck) {
+    applyMotorCommand();
+  } 
+
+  // *********************** process min max motor command *******************
+  processMinMaxCommand();
+
+  // If throttle in minimum position, don't apply yaw
+  if (receiverCommand[THROTTLE] < MINCHECK) {
+    for (byte motor = 0; motor < LASTMOTOR; motor++) {
+      motorMinCommand[motor] = minArmedThrottle;
+      if (inFlight && flightMode == RATE_FLIGHT_MODE) {
+        motorMaxCommand[motor] = MAXCOMMAND;
+      }
+      else {
+        motorMaxCommand[motor] = minArmedThrottle;
+      }
+    }
+  }
+  
+  // Apply limits to motor commands
+  for (byte motor = 0; motor < LASTMOTOR; motor++) {
+    motorCommand[motor] = constrain(motorCommand[motor], motorMinCommand[motor], motorMaxCommand[motor]);
+  }
+
+  // ESC Calibration
+  if (motorArmed == OFF) {
+    processCalibrateESC();
+  }
+  
+  // *********************** Command Motors **********************
+  if (motorArmed == ON && safetyCheck == ON) {
+    writeMotors();
+  }
+}
+
 /**
  * processFlightControl
  *
@@ -308,41 +380,9 @@ void processFlightControl() {
     processThrottleCorrection();
   }
 
-  // ********************** Calculate Motor Commands *************************
-  if (motorArmed && safetyCheck) {
-    applyMotorCommand();
-  } 
-
-  // *********************** process min max motor command *******************
-  processMinMaxCommand();
-
-  // If throttle in minimum position, don't apply yaw
-  if (receiverCommand[THROTTLE] < MINCHECK) {
-    for (byte motor = 0; motor < LASTMOTOR; motor++) {
-      motorMinCommand[motor] = minArmedThrottle;
-      if (inFlight && flightMode == RATE_FLIGHT_MODE) {
-        motorMaxCommand[motor] = MAXCOMMAND;
-      }
-      else {
-        motorMaxCommand[motor] = minArmedThrottle;
-      }
-    }
-  }
-  
-  // Apply limits to motor commands
-  for (byte motor = 0; motor < LASTMOTOR; motor++) {
-    motorCommand[motor] = constrain(motorCommand[motor], motorMinCommand[motor], motorMaxCommand[motor]);
-  }
-
-  // ESC Calibration
-  if (motorArmed == OFF) {
-    processCalibrateESC();
-  }
-  
-  // *********************** Command Motors **********************
-  if (motorArmed == ON && safetyCheck == ON) {
-    writeMotors();
-  }
+  #if !defined(RateLoopFrequency)
+    processRateControl();
+  #endif
 }
 
 #endif //#define _AQ_PROCESS_FLIGHT_CONTROL_H_
@@ -111,8 +111,8 @@ void processHeading()
     float receiverSiData = (receiverCommand[ZAXIS] - receiverZero[ZAXIS]) * (2.5 * PWM2RAD);
   #endif
   
-  const float commandedYaw = constrain(receiverSiData + radians(headingHold), -PI, PI);
-  motorAxisCommandYaw = updatePID(commandedYaw, gyroRate[ZAXIS], &PID[ZAXIS_PID_IDX]);
+  // yaw rate command of the rate loop, see calculateRateError()
+  rateTarget[ZAXIS] = constrain(receiverSiData + radians(headingHold), -PI, PI);
 }
 
 #endif
@@ -44,7 +44,7 @@ void updateOSD() {
         if (ON == positionHoldState) extendedFlightMode = 2;
         if (ON == navigationState) extendedFlightMode = 3;
       #endif
-      displayArtificialHorizon(kinematicsAngle[XAXIS], kinematicsAngle[YAXIS], extendedFlightMode);
+      displayArtificialHorizon(getKinematicsAngle(XAXIS), getKinematicsAngle(YAXIS), extendedFlightMode);
     }
   #endif
 
@@ -51,7 +51,7 @@ struct PIDdata {
   float P, I, D;
   float lastError;
   // AKA experiments with PID
-  float previousPIDTime;
+  unsigned long previousPIDTime;
   float integratedError;
   float windupGuard; // Thinking about having individual wind up guards for each PID
 } PID[LAST_PID_IDX];
@@ -230,6 +230,12 @@ void readSerialCommand() {
       #endif
       break;
 
+    case 'R': // Reset task profiler
+      #ifdef TaskProfiler
+        resetTaskProfiler();
+      #endif
+      break;
+
     case 'U': // Range Finder
       #if defined (AltitudeHoldRangeFinder)
         maxRangeFinderRange = readFloatSerial();
@@ -574,15 +580,15 @@ void sendSerialTelemetry() {
     break;
 
   case 'r': // Vehicle attitude
-    PrintValueComma(kinematicsAngle[XAXIS]);
-    PrintValueComma(kinematicsAngle[YAXIS]);
+    PrintValueComma(getKinematicsAngle(XAXIS));
+    PrintValueComma(getKinematicsAngle(YAXIS));
     SERIAL_PRINTLN(getHeading());
     break;
 
   case 's': // Send all flight data
     PrintValueComma(motorArmed);
-    PrintValueComma(kinematicsAngle[XAXIS]);
-    PrintValueComma(kinematicsAngle[YAXIS]);
+    PrintValueComma(getKinematicsAngle(XAXIS));
+    PrintValueComma(getKinematicsAngle(YAXIS));
     PrintValueComma(getHeading());
     #if defined AltitudeHoldBaro || defined AltitudeHoldRangeFinder
       #if defined AltitudeHoldBaro
@@ -644,6 +650,37 @@ void sendSerialTelemetry() {
     SERIAL_PRINTLN();
     queryType = 'X';
     break;
+  case 'w': // Send task profiler values, one line per task
+    #ifdef TaskProfiler
+      for (byte task = 0; task < LAST_TASK_IDX; task++) {
+        PrintValueComma(task);
+        PrintValueComma(getTaskMinTime(task));
+        PrintValueComma(getTaskAverageTime(task));
+        PrintValueComma(getTaskMaxTime(task));
+        PrintValueComma(taskProfile[task].count);
+        PrintValueComma((unsigned long)taskProfile[task].overruns);
+        for (byte bin = 0; bin < TASK_LATENCY_BINS - 1; bin++) {
+          PrintValueComma((unsigned long)taskProfile[task].latencyHistogram[bin]);
+        }
+        SERIAL_PRINTLN(taskProfile[task].latencyHistogram[TASK_LATENCY_BINS - 1]);
+      }
+    #else
+      PrintDummyValues(13);
+      SERIAL_PRINTLN();
+    #endif
+    queryType = 'X';
+    break;
+
+  case '@': // Send RTOS task statistics, one line per task
+    #ifdef AeroQuadRTOS
+      printRTOSTaskStatistics();
+    #else
+      PrintDummyValues(4);
+      SERIAL_PRINTLN();
+    #endif
+    queryType = 'X';
+    break;
+
   case 'y': // send GPS info
     #if defined (UseGPS)
       PrintValueComma(gpsData.state);
@@ -849,7 +886,7 @@ void fastTelemetry()
          sendBinaryFloat(0.0);
        #endif
         for (byte axis = XAXIS; axis <= ZAXIS; axis++) {
-          sendBinaryFloat(kinematicsAngle[axis]);
+          sendBinaryFloat(getKinematicsAngle(axis));
         }
         printInt(32767); // Stop word of 0x7FFF
     #else
@@ -870,7 +907,7 @@ void fastTelemetry()
          sendBinaryFloat(getGyroUnbias(axis));
        }
        for (byte axis = XAXIS; axis <= ZAXIS; axis++) {
-         sendBinaryFloat(kinematicsAngle[axis]);
+         sendBinaryFloat(getKinematicsAngle(axis));
        }
        printInt(32767); // Stop word of 0x7FFF
     #endif
@@ -890,7 +927,7 @@ void printVehicleState(const char *sensorName, unsigned long state, const char *
 
 void reportVehicleState() {
   // Tell Configurator how many vehicle state values to expect
-  SERIAL_PRINTLN(15);
+  SERIAL_PRINTLN(16);
   SERIAL_PRINT("Software Version: ");
   SERIAL_PRINTLN(SOFTWARE_VERSION, 1);
   SERIAL_PRINT("Board Type: ");
@@ -924,6 +961,8 @@ void reportVehicleState() {
     SERIAL_PRINTLN("Mini");
   #elif defined(AeroQuadSTM32)
     SERIAL_PRINTLN(STM32_BOARD_TYPE);
+  #elif defined(AeroQuadSIL)
+    SERIAL_PRINTLN(SIL_BOARD_TYPE);
   #endif
 
   SERIAL_PRINT("Flight Config: ");
@@ -956,6 +995,11 @@ void reportVehicleState() {
   SERIAL_PRINTLN(LASTMOTOR);
 
   printVehicleState("Gyroscope", GYRO_DETECTED, "Detected");
+  SERIAL_PRINT("Gyro Calibration: ");
+  SERIAL_PRINT(gyroCalibrationTime);
+  SERIAL_PRINT(" ms, ");
+  SERIAL_PRINT(gyroCalibrationAttempts);
+  SERIAL_PRINTLN(" attempts");
   printVehicleState("Accelerometer", ACCEL_DETECTED, "Detected");
   printVehicleState("Barometer", BARO_DETECTED, "Detected");
   printVehicleState("Magnetometer", MAG_DETECTED, "Detected");
@@ -0,0 +1,194 @@
+/*
+  AeroQuad v3.x
+  www.AeroQuad.com
+  Copyright (c) 2012 Ted Carancho.  All rights reserved.
+  An Open Source Arduino based multicopter.
+ 
+  This program is free software: you can redistribute it and/or modify 
+  it under the terms of the GNU General Public License as published by 
+  the Free Software Foundation, either version 3 of the License, or 
+  (at your option) any later version. 
+
+  This program is distributed in the hope that it will be useful, 
+  but WITHOUT ANY WARRANTY; without even the implied warranty of 
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the 
+  GNU General Public License for more details. 
+
+  You should have received a copy of the GNU General Public License 
+  along with this program. If not, see <http://www.gnu.org/licenses/>. 
+*/
+
+// Task Profiler measures execution time and start latency of the scheduler tasks in loop()
+// Execution time is measured with the Cortex-M3/M4 cycle counter on STM32 and with micros() elsewhere
+// Start latency is how much later than its nominal period a task started, it is collected in a histogram
+// A task overrun is a start latency of a whole 100Hz frame or more, i.e. at least one slot was missed
+// A frame is the scheduler pass that releases the 100Hz task, a frame overrun is one longer than the 10ms frame budget
+// A task split into slices by the scheduler is one run, its execution time is the sum of its slices
+
+#ifndef _AQ_TASK_PROFILER_H_
+#define _AQ_TASK_PROFILER_H_
+
+enum {
+  TASK_SENSORS_IDX = 0,  // measureCriticalSensors()
+  TASK_100HZ_IDX,
+  TASK_50HZ_IDX,
+  TASK_10HZ_1_IDX,
+  TASK_10HZ_2_IDX,
+  TASK_10HZ_3_IDX,
+  TASK_1HZ_IDX,
+  TASK_FRAME_IDX,        // scheduler pass releasing the 100Hz task
+  TASK_RATE_IDX,         // rate loop, only with RateLoopFrequency
+  TASK_CONFIG_STORE_IDX, // EEPROM writes of changed configuration values
+  LAST_TASK_IDX
+};
+
+#if defined(TaskProfiler)
+
+#define TASK_FRAME_PERIOD 10000 // us
+#define TASK_LATENCY_BINS 8
+
+// nominal period of each task in us, 0 when the task is not periodic
+const unsigned long taskPeriod[LAST_TASK_IDX] = {0, 10000, 20000, 100000, 100000, 100000, 1000000, TASK_FRAME_PERIOD, RATE_LOOP_PERIOD, 100000};
+
+// upper limit in us of each start latency histogram bin, the last bin takes everything above
+const unsigned int taskLatencyBinLimit[TASK_LATENCY_BINS - 1] = {100, 250, 500, 1000, 2500, 5000, 10000};
+
+#if defined(AeroQuadSTM32)
+  // DWT cycle counter of the Cortex-M core
+  #define DWT_CTRL   (*(volatile uint32_t *)0xE0001000)
+  #define DWT_CYCCNT (*(volatile uint32_t *)0xE0001004)
+  #define SCB_DEMCR  (*(volatile uint32_t *)0xE000EDFC)
+  #define TASK_PROFILER_TICKS_PER_US CYCLES_PER_MICROSECOND
+
+  void initTaskProfilerTimer() {
+    SCB_DEMCR |= 0x01000000; // TRCENA
+    DWT_CYCCNT = 0;
+    DWT_CTRL |= 1;           // CYCCNTENA
+  }
+
+  unsigned long getTaskProfilerTicks() {
+    return DWT_CYCCNT;
+  }
+#else
+  #define TASK_PROFILER_TICKS_PER_US 1
+
+  void initTaskProfilerTimer() {
+  }
+
+  unsigned long getTaskProfilerTicks() {
+    return micros();
+  }
+#endif
+
+struct TaskProfileData {
+  unsigned long startTicks;
+  unsigned long sliceTicks;  // execution time of the earlier slices of the current run
+  unsigned long previousStartTicks;
+  unsigned long minTicks;
+  unsigned long maxTicks;
+  uint64_t sumTicks;
+  unsigned long count;
+  unsigned int overruns;
+  unsigned int latencyHistogram[TASK_LATENCY_BINS];
+} taskProfile[LAST_TASK_IDX];
+
+void resetTaskProfiler() {
+  for (byte task = 0; task < LAST_TASK_IDX; task++) {
+    memset(&taskProfile[task], 0, sizeof(struct TaskProfileData));
+    taskProfile[task].minTicks = 0xFFFFFFFF;
+  }
+}
+
+void initializeTaskProfiler() {
+  initTaskProfilerTimer();
+  resetTaskProfiler();
+}
+
+void taskProfilerBegin(byte task) {
+  struct TaskProfileData *profile = &taskProfile[task];
+  profile->startTicks = getTaskProfilerTicks();
+  profile->sliceTicks = 0;
+
+  if (taskPeriod[task] == 0 || profile->previousStartTicks == 0) {
+    profile->previousStartTicks = profile->startTicks;
+    return;
+  }
+  unsigned long interval = (profile->startTicks - profile->previousStartTicks) / TASK_PROFILER_TICKS_PER_US;
+  profile->previousStartTicks = profile->startTicks;
+  unsigned long latency = interval > taskPeriod[task] ? interval - taskPeriod[task] : 0;
+
+  byte bin = 0;
+  while (bin < TASK_LATENCY_BINS - 1 && latency >= taskLatencyBinLimit[bin]) {
+    bin++;
+  }
+  if (profile->latencyHistogram[bin] < 0xFFFF) {
+    profile->latencyHistogram[bin]++;
+  }
+  if (task != TASK_FRAME_IDX && latency >= TASK_FRAME_PERIOD) {
+    profile->overruns++;
+  }
+}
+
+// end of a slice of a task split by the scheduler, the run goes on with a later slice
+void taskProfilerPause(byte task) {
+  taskProfile[task].sliceTicks += getTaskProfilerTicks() - taskProfile[task].startTicks;
+}
+
+// start of a later slice, counts the execution time only
+void taskProfilerResume(byte task) {
+  taskProfile[task].startTicks = getTaskProfilerTicks();
+}
+
+void taskProfilerEnd(byte task) {
+  struct TaskProfileData *profile = &taskProfile[task];
+  unsigned long ticks = profile->sliceTicks + getTaskProfilerTicks() - profile->startTicks;
+
+  if (ticks < profile->minTicks) {
+    profile->minTicks = ticks;
+  }
+  if (ticks > profile->maxTicks) {
+    profile->maxTicks = ticks;
+  }
+  profile->sumTicks += ticks;
+  profile->count++;
+  if (task == TASK_FRAME_IDX && ticks >= (unsigned long)TASK_FRAME_PERIOD * TASK_PROFILER_TICKS_PER_US) {
+    profile->overruns++;
+  }
+}
+
+float getTaskMinTime(byte task) {
+  if (taskProfile[task].count == 0) {
+    return 0.0;
+  }
+  return (float)taskProfile[task].minTicks / TASK_PROFILER_TICKS_PER_US;
+}
+
+float getTaskAverageTime(byte task) {
+  if (taskProfile[task].count == 0) {
+    return 0.0;
+  }
+  return (float)taskProfile[task].sumTicks / taskProfile[task].count / TASK_PROFILER_TICKS_PER_US;
+}
+
+float getTaskMaxTime(byte task) {
+  return (float)taskProfile[task].maxTicks / TASK_PROFILER_TICKS_PER_US;
+}
+
+// share of the 100Hz frame budget used on average, 0 to 1000 as in MAVLink SYS_STATUS load
+int getTaskFrameLoad() {
+  float load = getTaskAverageTime(TASK_FRAME_IDX) * 1000.0 / TASK_FRAME_PERIOD;
+  return load > 1000.0 ? 1000 : (int)load;
+}
+
+  #define TASK_PROFILER_BEGIN(task)  taskProfilerBegin(task)
+  #define TASK_PROFILER_PAUSE(task)  taskProfilerPause(task)
+  #define TASK_PROFILER_RESUME(task) taskProfilerResume(task)
+  #define TASK_PROFILER_END(task)    taskProfilerEnd(task)
+#else
+  #define TASK_PROFILER_BEGIN(task)
+  #define TASK_PROFILER_PAUSE(task)
+  #define TASK_PROFILER_RESUME(task)
+  #define TASK_PROFILER_END(task)
+#endif
+
+#endif
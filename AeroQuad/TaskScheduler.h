@@ -0,0 +1,152 @@
+/*
+  AeroQuad v3.x
+  www.AeroQuad.com
+  Copyright (c) 2012 Ted Carancho.  All rights reserved.
+  An Open Source Arduino based multicopter.
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+// Task Scheduler runs the periodic tasks of loop() from a static task table
+// A task is released every period, the first time offset us after the scheduler start so that
+// tasks of the same rate fall into different 100Hz frames, and has to finish before its next release
+// Pending tasks run in deadline order, equal deadlines in priority order (0 first)
+// A task is called with its slice number and the time the slice starts
+// A task returning TASK_CONTINUE has more work to do, it is called again with the next slice number
+// in a later pass so that the sensors and the rate loop can run in between
+// A scheduler pass stops starting tasks after TASK_SCHEDULER_PASS_BUDGET us, the rest waits for the next pass
+// A slice running longer than the task budget is an overrun, a task finishing after its deadline
+// or a release lost because the loop stalled for a whole period is a miss
+// The caller passes in the time of the scheduler pass, the end of each slice is read with micros(),
+// so the scheduler runs the same on the board and on the scripted clock of AeroQuadSIL/Scheduler/SchedulerBench.cpp
+
+#ifndef _AQ_TASK_SCHEDULER_H_
+#define _AQ_TASK_SCHEDULER_H_
+
+#define TASK_DONE     0
+#define TASK_CONTINUE 1
+
+#ifndef TASK_SCHEDULER_PASS_BUDGET
+  #define TASK_SCHEDULER_PASS_BUDGET 5000 // us
+#endif
+
+struct SchedulerTask {
+  byte (*function)(byte slice, unsigned long now);
+  unsigned long period;   // us
+  unsigned long offset;   // us, first release after the scheduler start
+  unsigned long budget;   // us, execution time allowed to one slice
+  byte priority;
+  byte profilerIndex;     // TaskProfiler entry
+  // state
+  unsigned long release;  // next release time
+  unsigned long deadline;
+  byte slice;
+  boolean pending;
+  unsigned int overruns;
+  unsigned int misses;
+};
+
+void initializeTaskScheduler(struct SchedulerTask *tasks, byte count, unsigned long now) {
+  for (byte index = 0; index < count; index++) {
+    tasks[index].release = now + tasks[index].offset;
+    tasks[index].deadline = tasks[index].release + tasks[index].period;
+    tasks[index].slice = 0;
+    tasks[index].pending = false;
+    tasks[index].overruns = 0;
+    tasks[index].misses = 0;
+  }
+}
+
+// true when the task is pending or will be released by the next scheduler pass at now
+boolean isSchedulerTaskDue(struct SchedulerTask *task, unsigned long now) {
+  return task->pending || (long)(now - task->release) >= 0;
+}
+
+void releaseSchedulerTasks(struct SchedulerTask *tasks, byte count, unsigned long now) {
+  for (byte index = 0; index < count; index++) {
+    struct SchedulerTask *task = &tasks[index];
+    if ((long)(now - task->release) < 0) {
+      continue;
+    }
+    if (!task->pending) {
+      task->pending = true;
+      task->slice = 0;
+      task->deadline = task->release + task->period;
+    }
+    task->release += task->period;
+    if ((long)(now - task->release) >= 0) {
+      // a whole period lost, restart the release grid from now
+      task->misses++;
+      task->release = now + task->period;
+    }
+  }
+}
+
+void runSchedulerTasks(struct SchedulerTask *tasks, byte count, unsigned long now) {
+  unsigned long start = now;
+  unsigned int ranThisPass = 0;
+
+  while (start - now < TASK_SCHEDULER_PASS_BUDGET) {
+    struct SchedulerTask *next = 0;
+    byte nextIndex = 0;
+    for (byte index = 0; index < count; index++) {
+      struct SchedulerTask *task = &tasks[index];
+      if (!task->pending || (ranThisPass & (1 << index))) {
+        continue;
+      }
+      if (next == 0 ||
+          (long)(task->deadline - next->deadline) < 0 ||
+          (task->deadline == next->deadline && task->priority < next->priority)) {
+        next = task;
+        nextIndex = index;
+      }
+    }
+    if (next == 0) {
+      return;
+    }
+    ranThisPass |= 1 << nextIndex;
+
+    if (next->slice == 0) {
+      TASK_PROFILER_BEGIN(next->profilerIndex);
+    }
+    else {
+      TASK_PROFILER_RESUME(next->profilerIndex);
+    }
+    byte result = next->function(next->slice, start);
+    unsigned long finish = micros();
+
+    if (finish - start > next->budget) {
+      next->overruns++;
+    }
+    if (result == TASK_CONTINUE) {
+      TASK_PROFILER_PAUSE(next->profilerIndex);
+      next->slice++;
+    }
+    else {
+      TASK_PROFILER_END(next->profilerIndex);
+      next->pending = false;
+      if ((long)(finish - next->deadline) > 0) {
+        next->misses++;
+      }
+    }
+    start = finish;
+  }
+}
+
+void runTaskScheduler(struct SchedulerTask *tasks, byte count, unsigned long now) {
+  releaseSchedulerTasks(tasks, count, now);
+  runSchedulerTasks(tasks, count, now);
+}
+
+#endif
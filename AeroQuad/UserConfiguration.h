@@ -49,6 +49,7 @@
 
 // STM32 processor
 //#define AeroQuadSTM32        // Baloo board
+//#define AeroQuadRTOS         // EXPERIMENTAL Runs sensors, control loop, telemetry, GPS and OSD as FreeRTOS tasks, AeroQuad32 only
 
 
 /****************************************************************************
@@ -73,6 +74,9 @@
 //#define CHANGE_YAW_DIRECTION	// only needed if you want to reverse the yaw correction direction
 
 #define USE_400HZ_ESC			// For ESC that support 400Hz update rate, ESC OR PLATFORM MAY NOT SUPPORT IT
+//#define RateLoopFrequency 400	// EXPERIMENTAL Runs the rate PIDs and motor output at this rate in Hz instead of 100Hz, attitude/altitude/navigation keep their rates, STM32 only
+//#define FixedPointKernels	// EXPERIMENTAL Runs the accel filter, receiver scaling and ARG kinematics in fixed point instead of software float, for the v1/v2 ATmega boards
+//#define FastTrigonometry	// Polynomial atan2, asin, sin, cos and sqrt for the attitude angles, compass heading and throttle correction instead of libm, errors listed in AQ_Math/FastTrigonometry.h
 
 
 //
@@ -129,6 +133,8 @@
 //#define ReceiverHWPPM		// Use a PPM receiver with HW timer (less jitter on channel values than PPM), needs a HW modification (see wiki)
 #define ReceiverTimerPWM	// Use a normal PWM receiver with timer to measure pulse widths with a timer one at a time
 //#define ReceiverHWPWM		// Use a normal PWM receiver with timer to measure pulse widths rather than micros()
+//#define ReceiverInterpolation	// Ramp the sticks from one receiver frame to the next at the 100Hz control rate, adds up to one frame of latency
+                                // With a PWM receiver the worst stick to setpoint latency grows from 31 to 39ms (make receiverbench), use PPM or SBUS with it
 
 // You need to select one of these channel order definitions for PPM receiver
 //#define SKETCH_SERIAL_SUM_PPM SERIAL_SUM_PPM_1	//For Graupner/Spektrum (DEFAULT)
@@ -159,9 +165,13 @@
 //#define MavLink               // Enables the MavLink protocol
 //#define MAV_SYSTEM_ID 100		// Needs to be enabled when using MavLink, used to identify each of your copters using MavLink
 								// If you've only got one, leave the default value unchanged, otherwise make sure that each copter has a different ID 
+//#define MAVLINK_LINK_BAUD 57600	// MavLink telemetry is limited to 80% of this link speed, defaults to the serial baudrate, set it to the air rate of slower radios
 
 //#define CONFIG_BAUDRATE 19200 // overrides default baudrate for serial port (Configurator/MavLink/WirelessTelemetry)
 
+//#define TaskProfiler          // Measures execution time and jitter of the loop() tasks, query with 'w' (Configurator) or DEBUG_VECT (MavLink)
+                                // Uses about 300 bytes of RAM, not recommended on the Atmega328p
+
 //
 // *******************************************************************************************************************************
 // Optional audio channel telemetry (for ground station tracking purposes)
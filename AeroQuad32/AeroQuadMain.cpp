@@ -15,11 +15,18 @@ extern "C"{
 	void _init(){}; // dummy _init function for support of GNU toolchain from https://launchpad.net/gcc-arm-embedded
 }*/
 
+#ifdef AeroQuadRTOS
+void startAeroQuadTasks();
+#endif
+
 int main(void)
 {
 	//init();
   	setup();
 
+#ifdef AeroQuadRTOS
+	startAeroQuadTasks();
+#endif
 	for (;;)
 		loop();
 
@@ -29,3 +36,7 @@ int main(void)
 
 #include "../AeroQuad/AeroQuad.ino"
 
+#ifdef AeroQuadRTOS
+	#include "AeroQuadRTOS.h"
+#endif
+
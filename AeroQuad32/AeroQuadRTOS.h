@@ -0,0 +1,234 @@
+/*
+  AeroQuad v3.x
+  www.AeroQuad.com
+  Copyright (c) 2012 Ted Carancho.  All rights reserved.
+  An Open Source Arduino based multicopter.
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+// FreeRTOS build of the flight software, enabled with AeroQuadRTOS
+// Instead of the bare loop() the work is split in prioritized tasks:
+//   sensors   - reads the gyro and accel every 1ms tick, then posts the sample time to sensorQueue
+//   control   - waits on sensorQueue and runs the rate loop and the 100Hz, 50Hz and 10Hz task table,
+//               it owns currentTime and G_Dt, the other tasks pass their own time to the task functions
+//   gps       - parses the GPS serial data every 10ms
+//   telemetry - serial commands, telemetry and configuration EEPROM writes at 10Hz,
+//               heartbeat and load statistics at 1Hz
+//   osd       - OSD menu, OSD, status LEDs and slow telemetry at 10Hz
+// A slow serial or SPI consumer only delays its own task, the sensors and the control loop preempt it.
+// Data shared between tasks is changed under RTOS_LOCK(), see AeroQuad.h.
+// CPU load per task comes from the FreeRTOS run time counters, stack use from the stack high water mark.
+
+#ifndef _AEROQUAD_RTOS_H_
+#define _AEROQUAD_RTOS_H_
+
+#if !defined(BOARD_aeroquad32) || defined(MPU6000_I2C)
+  // the sensor task must have its own bus, the baro and mag stay on I2C in the control task
+  #error "AeroQuadRTOS needs the SPI MPU6000 of the AeroQuad32 board"
+#endif
+
+#define RTOS_SENSOR_PRIORITY    (tskIDLE_PRIORITY + 4)
+#define RTOS_CONTROL_PRIORITY   (tskIDLE_PRIORITY + 3)
+#define RTOS_GPS_PRIORITY       (tskIDLE_PRIORITY + 2)
+#define RTOS_TELEMETRY_PRIORITY (tskIDLE_PRIORITY + 1)
+#define RTOS_OSD_PRIORITY       (tskIDLE_PRIORITY + 1)
+
+#define RTOS_SENSOR_QUEUE_LENGTH 4
+
+xQueueHandle sensorQueue;
+unsigned long rtosSensorQueueOverflows = 0; // samples the control task was too late for
+
+void sensorTask(void *parameters) {
+  portTickType wakeTime = xTaskGetTickCount();
+  for (;;) {
+    vTaskDelayUntil(&wakeTime, 1);
+
+    TASK_PROFILER_BEGIN(TASK_SENSORS_IDX);
+    measureGyroSum();
+    measureAccelSum();
+    TASK_PROFILER_END(TASK_SENSORS_IDX);
+
+    unsigned long sampleTime = micros();
+    if (xQueueSend(sensorQueue, &sampleTime, 0) != pdPASS) {
+      rtosSensorQueueOverflows++;
+    }
+  }
+}
+
+void controlTask(void *parameters) {
+  unsigned long sampleTime;
+  for (;;) {
+    xQueueReceive(sensorQueue, &sampleTime, portMAX_DELAY);
+
+    currentTime = micros();
+    deltaTime = currentTime - previousTime;
+
+    #ifdef I2C_QUEUE
+      processI2CQueue();
+    #endif
+
+    runControlTasks();
+  }
+}
+
+#if defined(UseGPS)
+  void gpsTask(void *parameters) {
+    portTickType wakeTime = xTaskGetTickCount();
+    for (;;) {
+      vTaskDelayUntil(&wakeTime, 10 / portTICK_RATE_MS);
+      updateGps();
+    }
+  }
+#endif
+
+void updateRTOSTaskLoad();
+
+void telemetryTask(void *parameters) {
+  portTickType wakeTime = xTaskGetTickCount();
+  byte oneHzCount = 0;
+  for (;;) {
+    vTaskDelayUntil(&wakeTime, 100 / portTICK_RATE_MS);
+
+    // own time, currentTime and G_Dt belong to the control task
+    unsigned long now = micros();
+    TASK_PROFILER_BEGIN(TASK_10HZ_2_IDX);
+    for (byte slice = 0; process10HzTask2(slice, now) == TASK_CONTINUE; slice++);
+    TASK_PROFILER_END(TASK_10HZ_2_IDX);
+
+    TASK_PROFILER_BEGIN(TASK_CONFIG_STORE_IDX);
+    for (byte slice = 0; processConfigStoreTask(slice, micros()) == TASK_CONTINUE; slice++);
+    TASK_PROFILER_END(TASK_CONFIG_STORE_IDX);
+
+    if (++oneHzCount >= 10) {
+      oneHzCount = 0;
+      TASK_PROFILER_BEGIN(TASK_1HZ_IDX);
+      process1HzTask(0, micros());
+      TASK_PROFILER_END(TASK_1HZ_IDX);
+      updateRTOSTaskLoad();
+    }
+  }
+}
+
+void osdTask(void *parameters) {
+  portTickType wakeTime = xTaskGetTickCount();
+  for (;;) {
+    vTaskDelayUntil(&wakeTime, 100 / portTICK_RATE_MS);
+
+    unsigned long now = micros();
+    TASK_PROFILER_BEGIN(TASK_10HZ_3_IDX);
+    for (byte slice = 0; process10HzTask3(slice, now) == TASK_CONTINUE; slice++);
+    TASK_PROFILER_END(TASK_10HZ_3_IDX);
+  }
+}
+
+enum {
+  RTOS_SENSOR_TASK = 0,
+  RTOS_CONTROL_TASK,
+  RTOS_GPS_TASK,
+  RTOS_TELEMETRY_TASK,
+  RTOS_OSD_TASK,
+  LAST_RTOS_TASK
+};
+
+struct RTOSTaskData {
+  const char *name;
+  pdTASK_CODE code;
+  unsigned short stackSize; // words
+  unsigned portBASE_TYPE priority;
+  xTaskHandle handle;
+  unsigned long previousRunTime;
+  unsigned int load; // 0 to 1000 of the CPU time over the last second
+} rtosTask[LAST_RTOS_TASK] = {
+  {"sensors",   sensorTask,    256, RTOS_SENSOR_PRIORITY},
+  {"control",   controlTask,   768, RTOS_CONTROL_PRIORITY},
+  #if defined(UseGPS)
+    {"gps",     gpsTask,       256, RTOS_GPS_PRIORITY},
+  #else
+    {"gps",     NULL,            0, RTOS_GPS_PRIORITY},
+  #endif
+  {"telemetry", telemetryTask, 768, RTOS_TELEMETRY_PRIORITY},
+  {"osd",       osdTask,       512, RTOS_OSD_PRIORITY},
+};
+
+unsigned long rtosLoadTime = 0;
+unsigned int rtosIdleLoad = 0;
+
+// called once per second from the telemetry task
+void updateRTOSTaskLoad() {
+  unsigned long now = micros();
+  unsigned long intervalMillis = (now - rtosLoadTime) / 1000;
+  rtosLoadTime = now;
+  if (intervalMillis == 0) {
+    return;
+  }
+
+  unsigned int busy = 0;
+  for (byte task = 0; task < LAST_RTOS_TASK; task++) {
+    if (rtosTask[task].handle == NULL) {
+      continue;
+    }
+    unsigned long runTime = ulTaskGetRunTimeCounter(rtosTask[task].handle);
+    rtosTask[task].load = (runTime - rtosTask[task].previousRunTime) / intervalMillis;
+    rtosTask[task].previousRunTime = runTime;
+    busy += rtosTask[task].load;
+  }
+  rtosIdleLoad = busy < 1000 ? 1000 - busy : 0;
+}
+
+#if !defined(MavLink)
+// one line per task: name, priority, stack size, unused stack (words), load 0-1000
+// then idle load and sensor queue overflows
+void printRTOSTaskStatistics() {
+  for (byte task = 0; task < LAST_RTOS_TASK; task++) {
+    if (rtosTask[task].handle == NULL) {
+      continue;
+    }
+    SERIAL_PRINT(rtosTask[task].name);
+    comma();
+    PrintValueComma((unsigned long)rtosTask[task].priority);
+    PrintValueComma((unsigned long)rtosTask[task].stackSize);
+    PrintValueComma((unsigned long)uxTaskGetStackHighWaterMark(rtosTask[task].handle));
+    SERIAL_PRINTLN(rtosTask[task].load);
+  }
+  SERIAL_PRINT("idle,");
+  PrintValueComma((unsigned long)rtosIdleLoad);
+  SERIAL_PRINTLN(rtosSensorQueueOverflows);
+}
+#endif
+
+// a synchronous Wire transfer, e.g. a calibration started from the telemetry task,
+// blocks its task tick by tick so the lower priority tasks run meanwhile
+void rtosWireWait() {
+  vTaskDelay(1);
+}
+
+// called after setup(), does not return
+void startAeroQuadTasks() {
+  sensorQueue = xQueueCreate(RTOS_SENSOR_QUEUE_LENGTH, sizeof(unsigned long));
+
+  for (byte task = 0; task < LAST_RTOS_TASK; task++) {
+    if (rtosTask[task].code == NULL) {
+      continue;
+    }
+    xTaskCreate(rtosTask[task].code, (const signed char *)rtosTask[task].name, rtosTask[task].stackSize,
+                NULL, rtosTask[task].priority, &rtosTask[task].handle);
+  }
+
+  Wire.onWait(rtosWireWait);
+  rtosLoadTime = micros();
+  vTaskStartScheduler();
+}
+
+#endif
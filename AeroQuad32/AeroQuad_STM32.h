@@ -7,6 +7,10 @@
 
 	#define ADC_NUMBER_OF_BITS	12
 
+	// the I2C sensors share the bus through the transaction queue, the hardware I2C
+	// driver runs the transfers in the background (I2C_Queue.h)
+	#define I2C_QUEUE
+
 	// Receiver Declaration
 	#if defined (ReceiverPPM) || defined (ReceiverHWPPM)
 		#undef ReceiverPPM
@@ -1,5 +1,6 @@
 #include "wirish.h"
 #include "EEPROM.h"
+#include <string.h>
 
 /**
   * @brief  Check page for blank
@@ -279,12 +280,77 @@ uint16 EEPROMClass::EE_VerifyPageFullWriteVariable(uint16 Address, uint16 Data)
 	return EE_PageTransfer(newPage, pageBase, Address);
 }
 
+/**
+  * @brief  Scan the valid page from begin to end once and store the last value
+  *			of each cached virtual address in RAM
+  * @retval None, CacheValid is cleared if no valid page was found
+  */
+void EEPROMClass::EE_BuildCache(void)
+{
+	uint32 pageBase, pageEnd;
+	uint16 address;
+
+	CacheValid = 0;
+	memset(CacheUsed, 0, sizeof(CacheUsed));
+
+	pageBase = EE_FindValidPage();
+	if (pageBase == 0)
+		return;
+
+	pageEnd = pageBase + PageSize;
+	for (pageBase += 4; pageBase < pageEnd; pageBase += 4)
+	{
+		if ((*(__io uint32*)pageBase) == 0xFFFFFFFF)	// First empty slot, variables are written in order
+			break;
+		address = (*(__io uint16*)(pageBase + 2));
+		if (address >= EEPROM_CACHE_SIZE)			// also 0xFFFF: power off after write data
+			continue;
+		CacheData[address] = (*(__io uint16*)pageBase);	// a later slot overrides an earlier one
+		CacheUsed[address >> 3] |= 1 << (address & 7);
+	}
+	CacheValid = 1;
+}
+
+/**
+  * @brief	Search the valid page from end to begin for the last stored data of a variable
+  * @param  Address: Variable virtual address
+  * @param  Data: Pointer to data variable
+  * @retval Success or error status:
+  *           - EEPROM_OK: if variable was found
+  *           - EEPROM_BAD_ADDRESS: if the variable was not found
+  *           - EEPROM_NO_VALID_PAGE: if no valid page was found.
+  */
+uint16 EEPROMClass::EE_ReadVariable(uint16 Address, uint16 *Data)
+{
+	uint32 pageBase, pageEnd;
+
+	// Get active Page for read operation
+	pageBase = EE_FindValidPage();
+	if (pageBase == 0)
+		return  EEPROM_NO_VALID_PAGE;
+
+	// Get the valid Page end Address
+	pageEnd = pageBase + ((uint32)(PageSize - 2));
+	
+	// Check each active page address starting from end
+	for (pageBase += 6; pageEnd >= pageBase; pageEnd -= 4)
+		if ((*(__io uint16*)pageEnd) == Address)		// Compare the read address with the virtual address
+		{
+			*Data = (*(__io uint16*)(pageEnd - 2));		// Get content of Address-2 which is variable value
+			return EEPROM_OK;
+		}
+
+	// Return ReadStatus value: (0: variable exist, 1: variable doesn't exist)
+	return EEPROM_BAD_ADDRESS;
+}
+
 EEPROMClass::EEPROMClass(void)
 {
 	PageBase0 = EEPROM_PAGE0_BASE;
 	PageBase1 = EEPROM_PAGE1_BASE;
 	PageSize = EEPROM_PAGE_SIZE;
 	Status = EEPROM_NOT_INIT;
+	CacheValid = 0;
 }
 
 uint16 EEPROMClass::init(uint32 pageBase0, uint32 pageBase1, uint32 pageSize)
@@ -302,6 +368,7 @@ uint16 EEPROMClass::init(void)
 
 	FLASH_Unlock();
 	Status = EEPROM_NO_VALID_PAGE;
+	CacheValid = 0;
 
 	status0 = (*(__io uint16 *)PageBase0);
 	status1 = (*(__io uint16 *)PageBase1);
@@ -388,6 +455,8 @@ uint16 EEPROMClass::init(void)
 		}
 		break;
 	}
+	if (Status == EEPROM_OK)
+		EE_BuildCache();
 	return Status;
 }
 
@@ -402,6 +471,7 @@ uint16 EEPROMClass::format(void)
 	FLASH_Status FlashStatus;
 
 	FLASH_Unlock();
+	CacheValid = 0;
 
 	// Erase Page0
 	status = EE_CheckErasePage(PageBase0, EEPROM_VALID_PAGE);
@@ -466,8 +536,6 @@ uint16 EEPROMClass::read (uint16 Address)
   */
 uint16 EEPROMClass::read(uint16 Address, uint16 *Data)
 {
-	uint32 pageBase, pageEnd;
-
 	// Set default data (empty EEPROM)
 	*Data = EEPROM_DEFAULT_DATA;
 
@@ -475,24 +543,20 @@ uint16 EEPROMClass::read(uint16 Address, uint16 *Data)
 		if (init() != EEPROM_OK)
 			return Status;
 
-	// Get active Page for read operation
-	pageBase = EE_FindValidPage();
-	if (pageBase == 0)
-		return  EEPROM_NO_VALID_PAGE;
+	if (Address >= EEPROM_CACHE_SIZE)
+		return EE_ReadVariable(Address, Data);
 
-	// Get the valid Page end Address
-	pageEnd = pageBase + ((uint32)(PageSize - 2));
-	
-	// Check each active page address starting from end
-	for (pageBase += 6; pageEnd >= pageBase; pageEnd -= 4)
-		if ((*(__io uint16*)pageEnd) == Address)		// Compare the read address with the virtual address
-		{
-			*Data = (*(__io uint16*)(pageEnd - 2));		// Get content of Address-2 which is variable value
-			return EEPROM_OK;
-		}
+	if (!CacheValid)
+	{
+		EE_BuildCache();
+		if (!CacheValid)
+			return EEPROM_NO_VALID_PAGE;
+	}
 
-	// Return ReadStatus value: (0: variable exist, 1: variable doesn't exist)
-	return EEPROM_BAD_ADDRESS;
+	if (!(CacheUsed[Address >> 3] & (1 << (Address & 7))))
+		return EEPROM_BAD_ADDRESS;
+	*Data = CacheData[Address];
+	return EEPROM_OK;
 }
 
 /**
@@ -516,8 +580,19 @@ uint16 EEPROMClass::write(uint16 Address, uint16 Data)
 	if (Address == 0xFFFF)
 		return EEPROM_BAD_ADDRESS;
 
+	bool cached = (Address < EEPROM_CACHE_SIZE) && CacheValid;
+	if (cached && (CacheUsed[Address >> 3] & (1 << (Address & 7))) && CacheData[Address] == Data)
+		return EEPROM_OK;		// Same value already stored
+
 	// Write the variable virtual address and value in the EEPROM
 	uint16 status = EE_VerifyPageFullWriteVariable(Address, Data);
+	if (status != EEPROM_OK)
+		CacheValid = 0;			// Flash content unknown, rebuild on next read
+	else if (cached)
+	{
+		CacheData[Address] = Data;
+		CacheUsed[Address >> 3] |= 1 << (Address & 7);
+	}
 	return status;
 }
 
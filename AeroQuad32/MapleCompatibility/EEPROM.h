@@ -60,6 +60,12 @@ enum //: uint16
 
 #define EEPROM_DEFAULT_DATA		0xFFFF
 
+/* Virtual addresses 0 .. EEPROM_CACHE_SIZE-1 are mirrored in RAM (2 bytes + 1 bit each),
+   higher addresses are read from flash, 2048 covers both AeroQuad configuration slots */
+#ifndef EEPROM_CACHE_SIZE
+	#define EEPROM_CACHE_SIZE		2048
+#endif
+
 
 class EEPROMClass
 {
@@ -92,6 +98,12 @@ private:
 	uint16 EE_GetVariablesCount(uint32, uint16);
 	uint16 EE_PageTransfer(uint32, uint32, uint16);
 	uint16 EE_VerifyPageFullWriteVariable(uint16, uint16);
+	uint16 EE_ReadVariable(uint16, uint16 *);
+	void EE_BuildCache(void);
+
+	uint8 CacheValid;
+	uint16 CacheData[EEPROM_CACHE_SIZE];
+	uint8 CacheUsed[(EEPROM_CACHE_SIZE + 7) / 8];
 };
 
 extern EEPROMClass EEPROM;
@@ -29,6 +29,7 @@
 				#define SERIAL_VAR Serial1
 			#endif
 			typedef HardwareSerial tSerial;
+			#define SERIAL_AVAILABLE_FOR_WRITE
 		#endif
 
 		extern tSerial &Serial;
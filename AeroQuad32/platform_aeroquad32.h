@@ -58,6 +58,8 @@ static byte __attribute__((unused)) stm32_motor_mapping_tri[] = {
 
 #include <Device_I2C.h>
 
+//#define MPU6000_FIFO // drain the MPU6000 FIFO with SPI DMA bursts in the background
+//#define MPU6000_INT_PIN // pin of the MPU6000 INT output, samples are read by its data ready interrupt
 #include <Gyroscope_MPU6000.h>
 #include <Accelerometer_MPU6000.h>
 
@@ -142,12 +144,27 @@ void initializePlatformSpecificAccelCalibration() {
 
 unsigned long previousMeasureCriticalSensorsTime = 0;
 void measureCriticalSensors() {
-  // read sensors not faster than every 1 ms
-  if (currentTime - previousMeasureCriticalSensorsTime >= 1000) {
-    measureGyroSum();
-    measureAccelSum();
-    previousMeasureCriticalSensorsTime = currentTime;
-  }
+  #ifdef MPU6000_BATCH
+    #ifdef MPU6000_FIFO_DMA
+      // start the next FIFO burst every 1 ms, the DMA clocks it while the loop goes on
+      if (currentTime - previousMeasureCriticalSensorsTime >= 1000) {
+        pollMPU6000Fifo();
+        previousMeasureCriticalSensorsTime = currentTime;
+      }
+    #endif
+    // the MPU6000 samples on its own, take the batch once per rate loop cycle
+    if (isRateLoopDue()) {
+      measureGyroSum();
+      measureAccelSum();
+    }
+  #else
+    // read sensors not faster than every 1 ms
+    if (currentTime - previousMeasureCriticalSensorsTime >= 1000) {
+      measureGyroSum();
+      measureAccelSum();
+      previousMeasureCriticalSensorsTime = currentTime;
+    }
+  #endif
 }
 
 #endif
@@ -0,0 +1,137 @@
+// Linux host (software in the loop) build of the AeroQuad flight software.
+// Runs setup() and the loop() scheduler on a virtual clock, see BuildSIL/ReadMe.txt
+
+#include <time.h>
+#include <unistd.h>
+
+#include <../AeroQuad/UserConfiguration.h>
+#include <WProgram.h>
+
+#include "../AeroQuad/AeroQuad.ino"
+
+static double hostSeconds() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void usage(const char *name) {
+  fprintf(stderr,
+    "usage: %s [-t seconds] [-l us] [-e eeprom.bin] [-c commands] [-s]\n"
+    "  -t  simulated flight time after setup() (default 10)\n"
+    "  -l  virtual time charged for one loop() pass (default 100)\n"
+    "  -e  EEPROM image, loaded at start when present and saved at exit\n"
+    "  -c  text queued on the serial port as if sent by the Configurator\n"
+    "  -s  echo serial port output to stdout\n",
+    name);
+}
+
+int main(int argc, char **argv)
+{
+  double simSeconds = 10.0;
+  unsigned long loopTime = 100;
+  const char *eepromFile = NULL;
+  const char *commands = NULL;
+  bool echoSerial = false;
+
+  int opt;
+  while ((opt = getopt(argc, argv, "t:l:e:c:sh")) != -1) {
+    switch (opt) {
+      case 't': simSeconds = atof(optarg); break;
+      case 'l': loopTime = strtoul(optarg, NULL, 10); break;
+      case 'e': eepromFile = optarg; break;
+      case 'c': commands = optarg; break;
+      case 's': echoSerial = true; break;
+      default:
+        usage(argv[0]);
+        return 1;
+    }
+  }
+
+  init();
+  if (eepromFile) {
+    EEPROM.silLoad(eepromFile);
+  }
+  if (echoSerial) {
+    SERIAL_PORT.silEcho = stdout;
+  }
+  if (commands) {
+    SERIAL_PORT.silInject(commands);
+  }
+
+  double hostStart = hostSeconds();
+  setup();
+  unsigned long setupTime = micros();
+  unsigned long setupEEPROMWrites = EEPROM.silWriteCount;
+
+  unsigned long endTime = setupTime + (unsigned long)(simSeconds * 1000000.0);
+  unsigned long loopCount = 0;
+  while (micros() < endTime) {
+    loop();
+    silAdvanceMicros(loopTime);
+    loopCount++;
+  }
+  double hostTime = hostSeconds() - hostStart;
+  double simTime = micros() / 1000000.0;
+
+  if (echoSerial) {
+    fflush(stdout);
+  }
+  fprintf(stderr, "simulated time   : %.3f s (setup %.3f s)\n", simTime, setupTime / 1000000.0);
+  fprintf(stderr, "host time        : %.3f s, %.1fx real time\n", hostTime, hostTime > 0 ? simTime / hostTime : 0.0);
+  fprintf(stderr, "loop passes      : %lu\n", loopCount);
+  fprintf(stderr, "motor updates    : %lu\n", silMotorWriteCount);
+  fprintf(stderr, "I2C transactions : %lu, %lu us on the bus\n", Wire.silTransactions, Wire.silBusTimeMicros);
+  #ifdef I2C_QUEUE
+    for (byte priority = 0; priority < I2C_PRIORITIES; priority++) {
+      I2CQueueStatistics *statistics = &i2cQueueStatistics[priority];
+      fprintf(stderr, "I2C queue prio %d : %lu transactions, wait avg %.1f max %lu us, %lu promoted, %lu failed\n",
+              priority, statistics->count, statistics->count ? (float)statistics->waitSum / statistics->count : 0.0,
+              statistics->waitMax, statistics->promoted, statistics->failed);
+    }
+  #endif
+  #ifdef MPU6000_FIFO
+    fprintf(stderr, "MPU6000 FIFO     : %lu samples, %lu overflows\n", MPU6000FifoSamples, MPU6000FifoOverflows);
+  #endif
+  fprintf(stderr, "serial tx        : %lu bytes, %lu us blocked\n", SERIAL_PORT.silTxCount, SERIAL_PORT.silTxBlockedTime);
+  #ifdef MavLink
+    fprintf(stderr, "MavLink          : %lu messages dropped on a full TX buffer\n", mavlinkTxDropped);
+  #endif
+  fprintf(stderr, "EEPROM writes    : %lu in setup, %lu after, %d fields pending\n", setupEEPROMWrites,
+          EEPROM.silWriteCount - setupEEPROMWrites, countDirtyNvrFields());
+  fprintf(stderr, "gyro calibration : %u ms, %u attempts\n", gyroCalibrationTime, gyroCalibrationAttempts);
+  fprintf(stderr, "configuration    : %s\n", configStoreState == CONFIG_STORE_LOADED ? "loaded" :
+          configStoreState == CONFIG_STORE_MIGRATED ? "migrated" : "defaults");
+  fprintf(stderr, "vehicle state    : 0x%lX\n", vehicleState);
+  fprintf(stderr, "attitude         : roll %.2f pitch %.2f deg\n", degrees(getKinematicsAngle(XAXIS)), degrees(getKinematicsAngle(YAXIS)));
+  #ifdef HeadingMagHold
+    fprintf(stderr, "heading          : %.2f deg\n", degrees(trueNorthHeading));
+  #endif
+  fprintf(stderr, "motors           :");
+  for (int motor = 0; motor < LASTMOTOR; motor++) {
+    fprintf(stderr, " %d", silMotorOutput[motor]);
+  }
+  fprintf(stderr, "\n");
+  fprintf(stderr, "scheduler        : misses/overruns");
+  for (byte task = 0; task < LAST_SCHEDULER_TASK; task++) {
+    fprintf(stderr, " %u/%u", schedulerTasks[task].misses, schedulerTasks[task].overruns);
+  }
+  fprintf(stderr, "\n");
+  #ifdef TaskProfiler
+    fprintf(stderr, "task profile     : min/avg/max us, count, overruns, start latency histogram\n");
+    for (byte task = 0; task < LAST_TASK_IDX; task++) {
+      fprintf(stderr, "  %d: %8.1f %8.1f %8.1f %7lu %4u  ", task, getTaskMinTime(task), getTaskAverageTime(task), getTaskMaxTime(task), taskProfile[task].count, taskProfile[task].overruns);
+      for (byte bin = 0; bin < TASK_LATENCY_BINS; bin++) {
+        fprintf(stderr, " %u", taskProfile[task].latencyHistogram[bin]);
+      }
+      fprintf(stderr, "\n");
+    }
+    fprintf(stderr, "frame load       : %d/1000\n", getTaskFrameLoad());
+  #endif
+
+  if (eepromFile && !EEPROM.silSave(eepromFile)) {
+    fprintf(stderr, "cannot write %s\n", eepromFile);
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,15 @@
+#ifndef _AEROQUAD_SIL_H_
+	#define _AEROQUAD_SIL_H_
+
+	// Linux host (software in the loop) build, see BuildSIL/ReadMe.txt
+
+	#define ADC_NUMBER_OF_BITS	10
+
+	// Receiver Declaration
+	#define RECEIVER_SIL
+
+	// Motor declaration
+	#define MOTOR_SIL
+
+	#include "platform_sil.h"
+#endif
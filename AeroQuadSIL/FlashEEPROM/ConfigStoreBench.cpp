@@ -0,0 +1,252 @@
+// Host test of the configuration store (AeroQuad/ConfigStore.h) on the STM32 flash EEPROM emulation
+// (AeroQuad32/MapleCompatibility/EEPROM.cpp) with a simulated flash page. Writes the defaults once,
+// then changes single parameters the way a MAVLink PARAM_SET or a Configurator command does and
+// checks the EEPROM units written, the flash half words programmed and the page erases of each
+// change against the bound of the design, that a reboot loads the last values and that a power
+// loss at any point of a record write boots with the record before or after the change.
+// Build and run with "make configstorebench" in BuildSIL.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <sys/mman.h>
+
+#include "EEPROM.h"
+
+typedef uint8_t byte;
+typedef bool boolean;
+
+static void cli() {}
+static void sei() {}
+#define RTOS_LOCK()
+#define RTOS_UNLOCK()
+
+// same header as AeroQuad.h, t_NVR_Data is about 680 bytes of floats and longs
+#define NVR_MAGIC 0x5141
+#define NVR_LAYOUT_VERSION 1
+#define BENCH_CONFIG_FLOATS 170
+
+typedef struct {
+  unsigned short crc;
+  unsigned short size;
+  unsigned short magic;
+  unsigned short version;
+  uint32_t sequence;
+} t_NVR_Header;
+
+typedef struct {
+  float value[BENCH_CONFIG_FLOATS];
+} t_NVR_Data;
+
+typedef struct {
+  t_NVR_Header header;
+  t_NVR_Data data;
+} t_NVR_Record;
+
+#define NVR_DATA_SIZE sizeof(t_NVR_Data)
+#define NVR_SLOT_SIZE 1024
+
+#include "../../AeroQuad/ConfigStore.h"
+
+#define BENCH_CHANGES 20000
+#define BENCH_POWER_LOSSES 2000
+
+static uint8 *flash;       // both pages, mapped below 4GB so that a uint32 holds the address
+static uint32 flashBase;
+static uint32 flashSize;
+static unsigned long flashPrograms;
+static unsigned long flashErases;
+
+// flash driver: erase sets all bits, programming can only clear bits like on the STM32
+extern "C" {
+  FLASH_Status FLASH_WaitForLastOperation(uint32 Timeout) {
+    return FLASH_COMPLETE;
+  }
+
+  FLASH_Status FLASH_ErasePage(uint32 Page_Address) {
+    if (Page_Address < flashBase || Page_Address + EEPROM_PAGE_SIZE > flashBase + flashSize) {
+      return FLASH_BAD_ADDRESS;
+    }
+    memset(flash + (Page_Address - flashBase), 0xFF, EEPROM_PAGE_SIZE);
+    flashErases++;
+    return FLASH_COMPLETE;
+  }
+
+  FLASH_Status FLASH_ProgramHalfWord(uint32 Address, uint16 Data) {
+    if (Address < flashBase || Address + 2 > flashBase + flashSize || (Address & 1)) {
+      return FLASH_BAD_ADDRESS;
+    }
+    *(uint16 *)(flash + (Address - flashBase)) &= Data;
+    flashPrograms++;
+    return FLASH_COMPLETE;
+  }
+
+  void FLASH_Unlock(void) {}
+  void FLASH_Lock(void) {}
+}
+
+static t_NVR_Data expected;
+
+// power cycle: EEPROM init and the boot time record load
+static int rebootMatches() {
+  EEPROM.init(flashBase, flashBase + EEPROM_PAGE_SIZE, EEPROM_PAGE_SIZE);
+  memset(&nvrRecord, 0, sizeof(nvrRecord));
+  return loadConfigRecord() && memcmp(&nvrRecord.data, &expected, sizeof(t_NVR_Data)) == 0;
+}
+
+// EEPROM units, flash half word programs and page erases of the flush after a change
+struct ChangeCost {
+  unsigned long units;
+  unsigned long programs;
+  unsigned long erases;
+};
+
+static struct ChangeCost flushCost() {
+  struct ChangeCost cost = {configStoreUnitWrites, flashPrograms, flashErases};
+  flushConfigStore();
+  cost.units = configStoreUnitWrites - cost.units;
+  cost.programs = flashPrograms - cost.programs;
+  cost.erases = flashErases - cost.erases;
+  return cost;
+}
+
+static float randomValue() {
+  return (rand() % 200001 - 100000) / 100.0;
+}
+
+int main() {
+  flashSize = 2 * EEPROM_PAGE_SIZE;
+  void *map = mmap(NULL, flashSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_32BIT, -1, 0);
+  if (map == MAP_FAILED) {
+    perror("mmap");
+    return 1;
+  }
+  flash = (uint8 *)map;
+  flashBase = (uint32)(uintptr_t)flash;
+  memset(flash, 0xFF, flashSize);
+  if (EEPROM.init(flashBase, flashBase + EEPROM_PAGE_SIZE, EEPROM_PAGE_SIZE) != EEPROM_OK) {
+    printf("init of the erased flash failed\n");
+    return 1;
+  }
+
+  // first boot, the defaults
+  for (int index = 0; index < BENCH_CONFIG_FLOATS; index++) {
+    expected.value[index] = randomValue();
+  }
+  nvrRecord.header.magic = NVR_MAGIC;
+  nvrRecord.header.version = NVR_LAYOUT_VERSION;
+  nvrRecord.header.size = sizeof(t_NVR_Data);
+  nvrRecord.data = expected;
+  markConfigStoreDirty();
+  struct ChangeCost defaults = flushCost();
+  int errors = !rebootMatches();
+  printf("defaults            %lu units, %lu half words programmed%s\n",
+         defaults.units, defaults.programs, errors ? "  not loaded after reboot" : "");
+
+  // the first change after the defaults also fills the other slot
+  expected.value[0] = randomValue();
+  nvrWriteFloat(expected.value[0], 0);
+  struct ChangeCost first = flushCost();
+  printf("first change        %lu units to fill the second slot\n", first.units);
+
+  // the slot written holds neither this change nor the one before, a float changes at most all
+  // its units, then the sequence number and the CRC unit, each emulated write programs the value
+  // and the virtual address
+  unsigned long unitBound = 2 * NVR_FIELD_SIZE / NVR_UNIT_SIZE + sizeof(uint32_t) / NVR_UNIT_SIZE + 1;
+  unsigned long programBound = 2 * unitBound;
+
+  // single parameter changes, each written before the next one
+  struct ChangeCost worst = {0, 0, 0};
+  struct ChangeCost total = {0, 0, 0};
+  unsigned long transfers = 0;
+  for (int change = 0; change < BENCH_CHANGES; change++) {
+    int index = rand() % BENCH_CONFIG_FLOATS;
+    expected.value[index] = randomValue();
+    nvrWriteFloat(expected.value[index], index * NVR_FIELD_SIZE);
+    struct ChangeCost cost = flushCost();
+    total.units += cost.units;
+    total.programs += cost.programs;
+    total.erases += cost.erases;
+    if (cost.units > worst.units) {
+      worst.units = cost.units;
+    }
+    // a page transfer copies all variables to the other page, counted apart
+    if (cost.erases) {
+      transfers++;
+    }
+    else if (cost.programs > worst.programs) {
+      worst.programs = cost.programs;
+    }
+  }
+  // the variables of the record stay in the page after a transfer, the rest takes new values
+  uint16 variables = 0;
+  EEPROM.count(&variables);
+  unsigned long eraseBound = total.units / (EEPROM.maxcount() - variables) + 1;
+  bool failed = worst.units > unitBound || worst.programs > programBound || total.erases > eraseBound;
+  errors += failed;
+  printf("single changes      %d changes, %.2f units and %.2f half words per change\n",
+         BENCH_CHANGES, (float)total.units / BENCH_CHANGES, (float)total.programs / BENCH_CHANGES);
+  printf("  worst change      %lu units (bound %lu), %lu half words without page transfer (bound %lu)%s\n",
+         worst.units, unitBound, worst.programs, programBound, failed ? "  too many" : "");
+  printf("  page erases       %lu in %lu transfers (bound %lu)\n", total.erases, transfers, eraseBound);
+
+  // a value changed several times before the store task runs is written once
+  int index = rand() % BENCH_CONFIG_FLOATS;
+  for (int change = 0; change < 10; change++) {
+    expected.value[index] = randomValue();
+    nvrWriteFloat(expected.value[index], index * NVR_FIELD_SIZE);
+  }
+  struct ChangeCost coalesced = flushCost();
+  failed = coalesced.units > unitBound;
+  errors += failed;
+  printf("coalesced changes   10 changes of one value, %lu units (bound %lu)%s\n",
+         coalesced.units, unitBound, failed ? "  too many" : "");
+
+  // writing the value already stored costs nothing
+  nvrWriteFloat(expected.value[index], index * NVR_FIELD_SIZE);
+  struct ChangeCost unchanged = flushCost();
+  failed = unchanged.units != 0 || unchanged.programs != 0;
+  errors += failed;
+  printf("unchanged value     %lu units%s\n", unchanged.units, failed ? "  written" : "");
+
+  if (!rebootMatches()) {
+    printf("values after reboot differ\n");
+    errors++;
+  }
+
+  // power loss after any number of units of a change, the reboot loads the record before or
+  // after the change and nothing else
+  int lostChanges = 0;
+  int failedBoots = 0;
+  for (int loss = 0; loss < BENCH_POWER_LOSSES; loss++) {
+    t_NVR_Data before = expected;
+    for (int change = 0; change < 1 + rand() % 3; change++) {
+      index = rand() % BENCH_CONFIG_FLOATS;
+      expected.value[index] = randomValue();
+      nvrWriteFloat(expected.value[index], index * NVR_FIELD_SIZE);
+    }
+    int units = rand() % (2 * unitBound);
+    for (int unit = 0; unit < units && writeConfigStoreUnit(); unit++);
+    if (rebootMatches()) {
+      continue;
+    }
+    if (loadConfigRecord() && memcmp(&nvrRecord.data, &before, sizeof(t_NVR_Data)) == 0) {
+      expected = before;
+      lostChanges++;
+      continue;
+    }
+    failedBoots++;
+    expected = nvrRecord.data;
+  }
+  errors += failedBoots;
+  printf("power losses        %d while writing, %d booted the record before the change, %d without a valid one\n",
+         BENCH_POWER_LOSSES, lostChanges, failedBoots);
+  if (errors) {
+    printf("%d checks failed\n", errors);
+    return 1;
+  }
+  printf("flash writes within their bounds, reboot loads the last values, power losses keep a valid record\n");
+  return 0;
+}
@@ -0,0 +1,169 @@
+// Host benchmark of the STM32 flash EEPROM emulation (AeroQuad32/MapleCompatibility/EEPROM.cpp)
+// Fills a simulated flash page the way repeated config writes do on the board, then times the
+// boot time config load (EEPROM init and one read per config word) against the page scan per
+// read the emulation used before the RAM cache, and checks both return the last written values.
+// Build and run with "make eeprombench" in BuildSIL.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <sys/mman.h>
+
+#include "EEPROM.h"
+
+// t_NVR_Data of AeroQuad.h is about 680 bytes, read in 16 bit words at even virtual addresses
+#define BENCH_CONFIG_WORDS 340
+#define BENCH_BOOTS        200
+
+static uint8 *flash;       // both pages, mapped below 4GB so that a uint32 holds the address
+static uint32 flashBase;
+static uint32 flashSize;
+
+// flash driver: erase sets all bits, programming can only clear bits like on the STM32
+extern "C" {
+  FLASH_Status FLASH_WaitForLastOperation(uint32 Timeout) {
+    return FLASH_COMPLETE;
+  }
+
+  FLASH_Status FLASH_ErasePage(uint32 Page_Address) {
+    if (Page_Address < flashBase || Page_Address + EEPROM_PAGE_SIZE > flashBase + flashSize) {
+      return FLASH_BAD_ADDRESS;
+    }
+    memset(flash + (Page_Address - flashBase), 0xFF, EEPROM_PAGE_SIZE);
+    return FLASH_COMPLETE;
+  }
+
+  FLASH_Status FLASH_ProgramHalfWord(uint32 Address, uint16 Data) {
+    if (Address < flashBase || Address + 2 > flashBase + flashSize || (Address & 1)) {
+      return FLASH_BAD_ADDRESS;
+    }
+    *(uint16 *)(flash + (Address - flashBase)) &= Data;
+    return FLASH_COMPLETE;
+  }
+
+  void FLASH_Unlock(void) {}
+  void FLASH_Lock(void) {}
+}
+
+static double hostSeconds() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// read of the emulation without the RAM cache: search the valid page backwards for the address
+static uint16 pageScanRead(uint16 address) {
+  uint32 pageBase = (*(__io uint16 *)EEPROM.PageBase0) == EEPROM_VALID_PAGE ? EEPROM.PageBase0 : EEPROM.PageBase1;
+  uint32 pageEnd = pageBase + EEPROM.PageSize - 2;
+  for (pageBase += 6; pageEnd >= pageBase; pageEnd -= 4) {
+    if ((*(__io uint16 *)pageEnd) == address) {
+      return *(__io uint16 *)(pageEnd - 2);
+    }
+  }
+  return EEPROM_DEFAULT_DATA;
+}
+
+static uint16 expected[BENCH_CONFIG_WORDS];
+
+static int checkValues(const char *when) {
+  int errors = 0;
+  for (int word = 0; word < BENCH_CONFIG_WORDS; word++) {
+    uint16 cached = EEPROM.read(2 * word);
+    uint16 scanned = pageScanRead(2 * word);
+    if (cached != expected[word] || scanned != expected[word]) {
+      if (errors++ < 5) {
+        printf("%s: address %d expected %04x, cached %04x, page scan %04x\n",
+               when, 2 * word, expected[word], cached, scanned);
+      }
+    }
+  }
+  return errors;
+}
+
+int main() {
+  flashSize = 2 * EEPROM_PAGE_SIZE;
+  void *map = mmap(NULL, flashSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_32BIT, -1, 0);
+  if (map == MAP_FAILED) {
+    perror("mmap");
+    return 1;
+  }
+  flash = (uint8 *)map;
+  flashBase = (uint32)(uintptr_t)flash;
+  memset(flash, 0xFF, flashSize);
+
+  if (EEPROM.init(flashBase, flashBase + EEPROM_PAGE_SIZE, EEPROM_PAGE_SIZE) != EEPROM_OK) {
+    printf("init of the erased flash failed\n");
+    return 1;
+  }
+
+  // defaults once, then changed values until the page has no free slot left
+  unsigned int slots = EEPROM.maxcount();
+  unsigned int written = 0;
+  unsigned int sequence = 0;
+  while (written < slots) {
+    int word = written < BENCH_CONFIG_WORDS ? written : rand() % BENCH_CONFIG_WORDS;
+    expected[word] = (uint16)(0x1000 + sequence++);
+    if (EEPROM.write(2 * word, expected[word]) != EEPROM_OK) {
+      printf("write %u failed\n", written);
+      return 1;
+    }
+    written++;
+  }
+  uint16 stored = 0;
+  EEPROM.count(&stored);
+  printf("page %u bytes, %u slots written, %u variables\n", (unsigned)EEPROM_PAGE_SIZE, written, stored);
+
+  int errors = checkValues("full page");
+
+  // init alone: page state checks and the one pass cache fill
+  double start = hostSeconds();
+  for (int boot = 0; boot < BENCH_BOOTS; boot++) {
+    EEPROM.init(flashBase, flashBase + EEPROM_PAGE_SIZE, EEPROM_PAGE_SIZE);
+  }
+  double initTime = (hostSeconds() - start) / BENCH_BOOTS;
+
+  // boot: init and config load, cached
+  volatile uint16 sink = 0;
+  start = hostSeconds();
+  for (int boot = 0; boot < BENCH_BOOTS; boot++) {
+    EEPROM.init(flashBase, flashBase + EEPROM_PAGE_SIZE, EEPROM_PAGE_SIZE);
+    for (int word = 0; word < BENCH_CONFIG_WORDS; word++) {
+      sink += EEPROM.read(2 * word);
+    }
+  }
+  double cachedTime = (hostSeconds() - start) / BENCH_BOOTS;
+
+  // same config load with a page scan per read
+  start = hostSeconds();
+  for (int boot = 0; boot < BENCH_BOOTS; boot++) {
+    EEPROM.init(flashBase, flashBase + EEPROM_PAGE_SIZE, EEPROM_PAGE_SIZE);
+    for (int word = 0; word < BENCH_CONFIG_WORDS; word++) {
+      sink += pageScanRead(2 * word);
+    }
+  }
+  double scanTime = (hostSeconds() - start) / BENCH_BOOTS;
+
+  printf("init %.1f us\n", initTime * 1e6);
+  printf("init and config load of %d words: cached %.1f us, page scan per read %.1f us\n",
+         BENCH_CONFIG_WORDS, cachedTime * 1e6, scanTime * 1e6);
+  printf("config reads alone: cached %.1f us, page scan per read %.1f us, %.1fx\n",
+         (cachedTime - initTime) * 1e6, (scanTime - initTime) * 1e6, (scanTime - initTime) / (cachedTime - initTime));
+
+  // the next write moves the variables to the other page, the cache has to follow
+  expected[7] ^= 0x5555;
+  if (EEPROM.write(2 * 7, expected[7]) != EEPROM_OK) {
+    printf("write with page transfer failed\n");
+    return 1;
+  }
+  errors += checkValues("after page transfer");
+  EEPROM.init(flashBase, flashBase + EEPROM_PAGE_SIZE, EEPROM_PAGE_SIZE);
+  errors += checkValues("after init");
+
+  if (errors) {
+    printf("%d read errors\n", errors);
+    return 1;
+  }
+  printf("reads match\n");
+  return 0;
+}
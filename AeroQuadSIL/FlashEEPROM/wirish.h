@@ -0,0 +1,15 @@
+#ifndef _WIRISH_H_
+#define _WIRISH_H_
+
+// The part of the Maple wirish.h used by the STM32 flash EEPROM emulation,
+// so that AeroQuad32/MapleCompatibility/EEPROM.cpp compiles on the host.
+
+#include <stdint.h>
+
+typedef uint8_t  uint8;
+typedef uint16_t uint16;
+typedef uint32_t uint32;
+
+#define __io volatile
+
+#endif
@@ -0,0 +1,4 @@
+#ifndef Arduino_h
+#define Arduino_h
+#include "WProgram.h"
+#endif
@@ -0,0 +1,49 @@
+// EEPROM of the host build, see EEPROM.h
+
+#include "EEPROM.h"
+
+// an AVR EEPROM byte write blocks for the erase/write cycle of the previous one
+#define SIL_EEPROM_WRITE_TIME 3400 // us
+
+EEPROMClass EEPROM;
+
+EEPROMClass::EEPROMClass() {
+  memset(data, 0xFF, sizeof(data));
+  silWriteCount = 0;
+}
+
+uint8_t EEPROMClass::read(int address) {
+  if (address < 0 || address >= SIL_EEPROM_SIZE) {
+    return 0xFF;
+  }
+  return data[address];
+}
+
+void EEPROMClass::write(int address, uint8_t value) {
+  if (address < 0 || address >= SIL_EEPROM_SIZE) {
+    return;
+  }
+  silAdvanceMicros(SIL_EEPROM_WRITE_TIME);
+  silWriteCount++;
+  data[address] = value;
+}
+
+bool EEPROMClass::silLoad(const char *fileName) {
+  FILE *f = fopen(fileName, "rb");
+  if (!f) {
+    return false;
+  }
+  size_t n = fread(data, 1, sizeof(data), f);
+  fclose(f);
+  return n == sizeof(data);
+}
+
+bool EEPROMClass::silSave(const char *fileName) {
+  FILE *f = fopen(fileName, "wb");
+  if (!f) {
+    return false;
+  }
+  size_t n = fwrite(data, 1, sizeof(data), f);
+  fclose(f);
+  return n == sizeof(data);
+}
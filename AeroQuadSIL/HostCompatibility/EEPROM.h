@@ -0,0 +1,28 @@
+#ifndef EEPROM_h
+#define EEPROM_h
+
+// EEPROM of the host build, a 4KB byte array like on the Mega 2560.
+// The content can be loaded from and saved to a file to keep the
+// configuration between two runs.
+
+#include "WProgram.h"
+
+#define SIL_EEPROM_SIZE 4096
+
+class EEPROMClass {
+public:
+  EEPROMClass();
+  uint8_t read(int address);
+  void write(int address, uint8_t value);
+
+  bool silLoad(const char *fileName);
+  bool silSave(const char *fileName);
+  unsigned long silWriteCount;
+
+private:
+  uint8_t data[SIL_EEPROM_SIZE];
+};
+
+extern EEPROMClass EEPROM;
+
+#endif
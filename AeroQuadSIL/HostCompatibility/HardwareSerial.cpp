@@ -0,0 +1,254 @@
+// Print and HardwareSerial for the Linux host build
+
+#include "WProgram.h"
+
+HardwareSerial Serial;
+HardwareSerial Serial1;
+HardwareSerial Serial2;
+HardwareSerial Serial3;
+
+size_t Print::write(const uint8_t *buffer, size_t size) {
+  size_t n = 0;
+  while (size--) {
+    n += write(*buffer++);
+  }
+  return n;
+}
+
+size_t Print::print(const char str[]) {
+  return write(str);
+}
+
+size_t Print::print(char c) {
+  return write((uint8_t)c);
+}
+
+size_t Print::print(unsigned char b, int base) {
+  return print((unsigned long)b, base);
+}
+
+size_t Print::print(int n, int base) {
+  return print((long)n, base);
+}
+
+size_t Print::print(unsigned int n, int base) {
+  return print((unsigned long)n, base);
+}
+
+size_t Print::print(long n, int base) {
+  if (base == 0) {
+    return write((uint8_t)n);
+  }
+  if (base == DEC && n < 0) {
+    size_t t = print('-');
+    return printNumber(-n, DEC) + t;
+  }
+  return printNumber(n, base);
+}
+
+size_t Print::print(unsigned long n, int base) {
+  if (base == 0) {
+    return write((uint8_t)n);
+  }
+  return printNumber(n, base);
+}
+
+size_t Print::print(double n, int digits) {
+  return printFloat(n, digits);
+}
+
+size_t Print::println(void) {
+  return write("\r\n");
+}
+
+size_t Print::println(const char str[]) {
+  size_t n = print(str);
+  return n + println();
+}
+
+size_t Print::println(char c) {
+  size_t n = print(c);
+  return n + println();
+}
+
+size_t Print::println(unsigned char b, int base) {
+  size_t n = print(b, base);
+  return n + println();
+}
+
+size_t Print::println(int num, int base) {
+  size_t n = print(num, base);
+  return n + println();
+}
+
+size_t Print::println(unsigned int num, int base) {
+  size_t n = print(num, base);
+  return n + println();
+}
+
+size_t Print::println(long num, int base) {
+  size_t n = print(num, base);
+  return n + println();
+}
+
+size_t Print::println(unsigned long num, int base) {
+  size_t n = print(num, base);
+  return n + println();
+}
+
+size_t Print::println(double num, int digits) {
+  size_t n = print(num, digits);
+  return n + println();
+}
+
+size_t Print::printNumber(unsigned long n, uint8_t base) {
+  char buf[8 * sizeof(long) + 1];
+  char *str = &buf[sizeof(buf) - 1];
+
+  *str = '\0';
+  if (base < 2) {
+    base = 10;
+  }
+  do {
+    unsigned long m = n;
+    n /= base;
+    char c = m - base * n;
+    *--str = c < 10 ? c + '0' : c + 'A' - 10;
+  } while(n);
+
+  return write(str);
+}
+
+// same rounding and format as the Arduino core so telemetry text is identical
+size_t Print::printFloat(double number, uint8_t digits) {
+  size_t n = 0;
+
+  if (isnan(number)) {
+    return print("nan");
+  }
+  if (isinf(number)) {
+    return print("inf");
+  }
+  if (number > 4294967040.0 || number < -4294967040.0) {
+    return print("ovf");
+  }
+
+  if (number < 0.0) {
+    n += print('-');
+    number = -number;
+  }
+
+  double rounding = 0.5;
+  for (uint8_t i = 0; i < digits; ++i) {
+    rounding /= 10.0;
+  }
+  number += rounding;
+
+  unsigned long int_part = (unsigned long)number;
+  double remainder = number - (double)int_part;
+  n += print(int_part);
+
+  if (digits > 0) {
+    n += print('.');
+  }
+  while (digits-- > 0) {
+    remainder *= 10.0;
+    int toPrint = int(remainder);
+    n += print(toPrint);
+    remainder -= toPrint;
+  }
+  return n;
+}
+
+HardwareSerial::HardwareSerial() {
+  silEcho = NULL;
+  silTxCount = 0;
+  silTxBlockedTime = 0;
+  byteTimeNanos = 0;
+  txDrainTimeNanos = 0;
+  rxHead = 0;
+  rxTail = 0;
+}
+
+void HardwareSerial::begin(unsigned long baud) {
+  byteTimeNanos = 10000000000UL / baud; // start + 8 data + stop bit
+  txDrainTimeNanos = micros() * 1000;
+}
+
+void HardwareSerial::end() {
+  flush();
+  byteTimeNanos = 0;
+}
+
+int HardwareSerial::available(void) {
+  return (SIL_SERIAL_RX_SIZE + rxHead - rxTail) % SIL_SERIAL_RX_SIZE;
+}
+
+// free space of the transmit buffer
+int HardwareSerial::availableForWrite(void) {
+  if (!byteTimeNanos) {
+    return SERIAL_BUFFER_SIZE;
+  }
+  unsigned long now = micros() * 1000;
+  if (txDrainTimeNanos <= now) {
+    return SERIAL_BUFFER_SIZE;
+  }
+  unsigned long pending = (txDrainTimeNanos - now + byteTimeNanos - 1) / byteTimeNanos;
+  return pending >= SERIAL_BUFFER_SIZE ? 0 : SERIAL_BUFFER_SIZE - pending;
+}
+
+int HardwareSerial::peek(void) {
+  if (rxHead == rxTail) {
+    return -1;
+  }
+  return rxBuffer[rxTail];
+}
+
+int HardwareSerial::read(void) {
+  if (rxHead == rxTail) {
+    return -1;
+  }
+  uint8_t c = rxBuffer[rxTail];
+  rxTail = (rxTail + 1) % SIL_SERIAL_RX_SIZE;
+  return c;
+}
+
+void HardwareSerial::flush() {
+  unsigned long now = micros() * 1000;
+  if (txDrainTimeNanos > now) {
+    silAdvanceNanos(txDrainTimeNanos - now);
+  }
+}
+
+size_t HardwareSerial::write(uint8_t c) {
+  if (byteTimeNanos) {
+    unsigned long now = micros() * 1000;
+    if (txDrainTimeNanos < now) {
+      txDrainTimeNanos = now;
+    }
+    // wait for a free slot when SERIAL_BUFFER_SIZE bytes are still pending
+    unsigned long bufferTime = SERIAL_BUFFER_SIZE * byteTimeNanos;
+    if (txDrainTimeNanos - now > bufferTime) {
+      unsigned long wait = txDrainTimeNanos - now - bufferTime;
+      silAdvanceNanos(wait);
+      silTxBlockedTime += wait / 1000;
+    }
+    txDrainTimeNanos += byteTimeNanos;
+  }
+  if (silEcho) {
+    fputc(c, silEcho);
+  }
+  silTxCount++;
+  return 1;
+}
+
+void HardwareSerial::silInject(const uint8_t *data, size_t size) {
+  while (size--) {
+    size_t next = (rxHead + 1) % SIL_SERIAL_RX_SIZE;
+    if (next == rxTail) {
+      return; // overflow, drop like the target UART would
+    }
+    rxBuffer[rxHead] = *data++;
+    rxHead = next;
+  }
+}
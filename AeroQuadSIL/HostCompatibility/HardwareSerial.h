@@ -0,0 +1,78 @@
+#ifndef HardwareSerial_h
+#define HardwareSerial_h
+
+// Serial ports of the host build.
+// Transmit is modelled like the AeroQuad32 USARTs: bytes go into a 255 byte
+// buffer that drains at the configured baud rate, write() blocks (advancing the
+// virtual clock) when the buffer is full. Received bytes are queued by the test
+// harness with silInject(), transmitted bytes are optionally echoed to a file.
+
+#define SERIAL_BUFFER_SIZE 255
+#define SERIAL_AVAILABLE_FOR_WRITE
+#define SIL_SERIAL_RX_SIZE 4096
+
+class Print {
+public:
+  virtual ~Print() {}
+  virtual size_t write(uint8_t c) = 0;
+  virtual size_t write(const uint8_t *buffer, size_t size);
+  size_t write(const char *str) { return write((const uint8_t *)str, strlen(str)); }
+
+  size_t print(const char str[]);
+  size_t print(char c);
+  size_t print(unsigned char b, int base = DEC);
+  size_t print(int n, int base = DEC);
+  size_t print(unsigned int n, int base = DEC);
+  size_t print(long n, int base = DEC);
+  size_t print(unsigned long n, int base = DEC);
+  size_t print(double n, int digits = 2);
+
+  size_t println(const char str[]);
+  size_t println(char c);
+  size_t println(unsigned char b, int base = DEC);
+  size_t println(int n, int base = DEC);
+  size_t println(unsigned int n, int base = DEC);
+  size_t println(long n, int base = DEC);
+  size_t println(unsigned long n, int base = DEC);
+  size_t println(double n, int digits = 2);
+  size_t println(void);
+
+private:
+  size_t printNumber(unsigned long n, uint8_t base);
+  size_t printFloat(double number, uint8_t digits);
+};
+
+class HardwareSerial : public Print {
+public:
+  HardwareSerial();
+  void begin(unsigned long baud);
+  void end();
+  int available(void);
+  int availableForWrite(void);
+  int peek(void);
+  int read(void);
+  void flush(void);
+  virtual size_t write(uint8_t c);
+  using Print::write;
+
+  // host side of the port
+  void silInject(const uint8_t *data, size_t size);
+  void silInject(const char *str) { silInject((const uint8_t *)str, strlen(str)); }
+  FILE *silEcho;                  // transmitted bytes are copied here when set
+  unsigned long silTxCount;       // total number of bytes transmitted
+  unsigned long silTxBlockedTime; // microseconds spent waiting for a full buffer
+
+private:
+  unsigned long byteTimeNanos;
+  unsigned long txDrainTimeNanos; // virtual time the last queued byte is sent
+  uint8_t rxBuffer[SIL_SERIAL_RX_SIZE];
+  size_t rxHead;
+  size_t rxTail;
+};
+
+extern HardwareSerial Serial;
+extern HardwareSerial Serial1;
+extern HardwareSerial Serial2;
+extern HardwareSerial Serial3;
+
+#endif
@@ -0,0 +1,67 @@
+// Arduino core functions for the Linux host build, running on a virtual clock
+
+#include "WProgram.h"
+#include "SILBench.h"
+
+static unsigned long silMicrosCount = 0;
+static unsigned long silNanosRemainder = 0;
+
+int silAnalogInput[SIL_ANALOG_PINS];
+
+void init() {
+  silMicrosCount = 0;
+  silNanosRemainder = 0;
+}
+
+void silAdvanceMicros(unsigned long us) {
+  silMicrosCount += us;
+}
+
+void silAdvanceNanos(unsigned long ns) {
+  silNanosRemainder += ns;
+  silMicrosCount += silNanosRemainder / 1000;
+  silNanosRemainder %= 1000;
+}
+
+unsigned long micros() {
+  return silMicrosCount;
+}
+
+unsigned long millis() {
+  return silMicrosCount / 1000;
+}
+
+void delay(unsigned long ms) {
+  silAdvanceMicros(ms * 1000);
+}
+
+void delayMicroseconds(unsigned int us) {
+  silAdvanceMicros(us);
+}
+
+void pinMode(uint8_t pin, uint8_t mode) {
+}
+
+static uint8_t silPinState[256];
+
+void digitalWrite(uint8_t pin, uint8_t value) {
+  silPinState[pin] = value ? HIGH : LOW;
+}
+
+int digitalRead(uint8_t pin) {
+  return silPinState[pin];
+}
+
+int analogRead(uint8_t pin) {
+  if (pin < SIL_ANALOG_PINS) {
+    return silAnalogInput[pin];
+  }
+  return 0;
+}
+
+void analogWrite(uint8_t pin, int value) {
+}
+
+long map(long x, long in_min, long in_max, long out_min, long out_max) {
+  return (x - in_min) * (out_max - out_min) / (in_max - in_min) + out_min;
+}
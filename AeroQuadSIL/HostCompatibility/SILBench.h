@@ -0,0 +1,26 @@
+#ifndef _SIL_BENCH_H_
+#define _SIL_BENCH_H_
+
+// State of the simulated test bench the host build flies on.
+// Values are physical quantities in the sensor frame, the device models
+// convert them into raw register content on every read.
+
+#define SIL_ANALOG_PINS 16
+
+struct SILBench {
+  float gyroRate[3];    // deg/s
+  float accel[3];       // g
+  float mag[3];         // gauss
+  float pressure;       // Pa
+  float temperature;    // deg C
+  int   gyroNoise;      // peak noise in LSB added to each gyro sample
+  int   accelNoise;     // peak noise in LSB added to each accel sample
+};
+
+extern SILBench silBench;
+extern int silAnalogInput[SIL_ANALOG_PINS]; // raw ADC counts returned by analogRead()
+
+// register the simulated sensors on the host Wire bus
+void silAttachSensors();
+
+#endif
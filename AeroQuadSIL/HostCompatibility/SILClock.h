@@ -0,0 +1,16 @@
+#ifndef _SIL_CLOCK_H_
+#define _SIL_CLOCK_H_
+
+// Virtual time base of the host build.
+// The sketch never sees wall clock time, everything is driven from here so a
+// run is deterministic and can go as fast as the host allows.
+
+// advance the virtual clock, used by delay(), by simulated bus transfers and
+// by the main loop driver to model the cost of one loop() pass
+void silAdvanceMicros(unsigned long us);
+
+// advance the virtual clock by a fraction of a microsecond, the remainder
+// is carried so that many short transfers add up correctly
+void silAdvanceNanos(unsigned long ns);
+
+#endif
@@ -0,0 +1,275 @@
+// Register level models of the I2C sensors used by the host build:
+// MPU6050 gyro/accel, HMC5883L magnetometer and MS5611 barometer.
+// The values served come from silBench, see SILBench.h
+
+#include "Wire.h"
+#include "SILBench.h"
+
+SILBench silBench = {
+  {0.0, 0.0, 0.0},    // gyro at rest
+  {0.0, 0.0, 1.0},    // level
+  {0.0, 0.2, 0.4},    // pointing north, roughly central Europe inclination
+  101325.0,
+  20.0,
+  2,
+  8
+};
+
+// deterministic noise so every run gives the same result
+static unsigned long silNoiseState = 12345;
+
+static int silNoise(int peak) {
+  if (peak <= 0) {
+    return 0;
+  }
+  silNoiseState = silNoiseState * 1103515245UL + 12345UL;
+  return (int)((silNoiseState >> 16) % (2 * peak + 1)) - peak;
+}
+
+static short silClampShort(float value) {
+  if (value > 32767.0) {
+    return 32767;
+  }
+  if (value < -32768.0) {
+    return -32768;
+  }
+  return (short)value;
+}
+
+// Generic register file device with an auto incremented register pointer
+class SILRegisterDevice : public SILI2CDevice {
+public:
+  SILRegisterDevice() : pointer(0) {
+    memset(registers, 0, sizeof(registers));
+  }
+  virtual void receive(const uint8_t *data, int length) {
+    if (length == 0) {
+      return;
+    }
+    pointer = data[0];
+    for (int i = 1; i < length; i++) {
+      writeRegister(pointer++, data[i]);
+    }
+  }
+  virtual int transmit(uint8_t *data, int length) {
+    update();
+    for (int i = 0; i < length; i++) {
+      data[i] = registers[pointer++];
+    }
+    return length;
+  }
+
+protected:
+  virtual void writeRegister(uint8_t reg, uint8_t value) {
+    registers[reg] = value;
+  }
+  virtual void update() {
+  }
+  void setWord(uint8_t reg, short value) {
+    registers[reg]     = (uint16_t)value >> 8;
+    registers[reg + 1] = (uint16_t)value & 0xFF;
+  }
+
+  uint8_t registers[256];
+  uint8_t pointer;
+};
+
+class SILMPU6050 : public SILRegisterDevice {
+public:
+  SILMPU6050() : fifoLength(0), lastSampleTime(0) {
+    registers[0x75] = 0x68; // WHO_AM_I
+  }
+
+  virtual int transmit(uint8_t *data, int length) {
+    if (pointer != 0x74) {
+      return SILRegisterDevice::transmit(data, length);
+    }
+    // FIFO_R_W, the register pointer stays, an empty FIFO reads as 0
+    sampleFifo();
+    int n = length < fifoLength ? length : fifoLength;
+    memcpy(data, fifo, n);
+    memmove(fifo, fifo + n, fifoLength - n);
+    fifoLength -= n;
+    memset(data + n, 0, length - n);
+    return length;
+  }
+
+protected:
+  virtual void writeRegister(uint8_t reg, uint8_t value) {
+    if (reg == 0x6A && (value & 0x04)) { // USER_CTRL FIFO_RESET, self clearing
+      fifoLength = 0;
+      lastSampleTime = micros();
+      value &= ~0x04;
+    }
+    if (reg == 0x6A && (value & 0x40) && !(registers[0x6A] & 0x40)) {
+      lastSampleTime = micros();
+    }
+    registers[reg] = value;
+  }
+
+  virtual void update() {
+    sampleFifo();
+    registers[0x72] = fifoLength >> 8;
+    registers[0x73] = fifoLength & 0xFF;
+    if (pointer < 0x3B || pointer > 0x48) {
+      return;
+    }
+    sample();
+  }
+
+private:
+  // FS = 1000 deg/s and +-4g as set up by initializeMPU6000Sensors()
+  void sample() {
+    const float gyroLSB  = 65536.0 / 2000.0;
+    const float accelLSB = 8192.0;
+    for (int axis = 0; axis < 3; axis++) {
+      setWord(0x3B + 2 * axis, silClampShort(silBench.accel[axis] * accelLSB + silNoise(silBench.accelNoise)));
+      setWord(0x43 + 2 * axis, silClampShort(silBench.gyroRate[axis] * gyroLSB + silNoise(silBench.gyroNoise)));
+    }
+    setWord(0x41, silClampShort((silBench.temperature - 36.53) * 340.0));
+  }
+
+  // Adds the samples taken since the last access when the FIFO is enabled.
+  // Sample rate is 1kHz / (1 + SMPLRT_DIV) with the DLPF on, 8kHz without.
+  // A full FIFO drops its oldest bytes like the chip does.
+  void sampleFifo() {
+    if (!(registers[0x6A] & 0x40) || registers[0x23] != 0x78) {
+      return;
+    }
+    uint8_t dlpf = registers[0x1A] & 0x07;
+    unsigned long period = (dlpf == 0 || dlpf == 7 ? 125 : 1000) * (1 + registers[0x19]);
+    unsigned long now = micros();
+    while (now - lastSampleTime >= period) {
+      lastSampleTime += period;
+      sample();
+      if (fifoLength + 12 > (int)sizeof(fifo)) {
+        int drop = fifoLength + 12 - sizeof(fifo);
+        memmove(fifo, fifo + drop, fifoLength - drop);
+        fifoLength -= drop;
+      }
+      memcpy(fifo + fifoLength, &registers[0x3B], 6);      // accel
+      memcpy(fifo + fifoLength + 6, &registers[0x43], 6);  // gyro
+      fifoLength += 12;
+    }
+  }
+
+  uint8_t fifo[1024];
+  int fifoLength;
+  unsigned long lastSampleTime;
+};
+
+class SILHMC5883L : public SILRegisterDevice {
+public:
+  SILHMC5883L() {
+    registers[0x00] = 0x10; // configuration A reset value, checked as identity
+    registers[0x01] = 0x20;
+    registers[0x0A] = 'H';
+    registers[0x0B] = '4';
+    registers[0x0C] = '3';
+  }
+
+protected:
+  virtual void update() {
+    if (pointer < 0x03 || pointer > 0x08) {
+      return;
+    }
+    static const float gainLSB[8] = {1370, 1090, 820, 660, 440, 390, 330, 230};
+    float lsb = gainLSB[registers[0x01] >> 5];
+    // output order is X, Z, Y
+    setWord(0x03, silClampShort(silBench.mag[0] * lsb));
+    setWord(0x05, silClampShort(silBench.mag[2] * lsb));
+    setWord(0x07, silClampShort(silBench.mag[1] * lsb));
+  }
+};
+
+class SILMS5611 : public SILI2CDevice {
+public:
+  SILMS5611() : command(0), conversion(0) {
+    // calibration values from the datasheet example, word 7 holds the CRC
+    static const uint16_t datasheetProm[8] = {0, 40127, 36924, 23317, 23282, 33464, 28312, 0};
+    memcpy(prom, datasheetProm, sizeof(prom));
+    prom[7] = crc4();
+  }
+
+  virtual void receive(const uint8_t *data, int length) {
+    if (length == 0) {
+      return;
+    }
+    command = data[0];
+    if ((command & 0xF0) == 0x50) {
+      conversion = rawTemperature();
+    }
+    else if ((command & 0xF0) == 0x40) {
+      conversion = rawPressure();
+    }
+  }
+
+  virtual int transmit(uint8_t *data, int length) {
+    if (command >= 0xA0 && command <= 0xAE) {
+      uint16_t value = prom[(command - 0xA0) / 2];
+      data[0] = value >> 8;
+      if (length > 1) {
+        data[1] = value & 0xFF;
+      }
+      return length < 2 ? length : 2;
+    }
+    if (command == 0x00) {
+      data[0] = conversion >> 16;
+      if (length > 1) data[1] = conversion >> 8;
+      if (length > 2) data[2] = conversion;
+      conversion = 0; // a second read without a new conversion returns 0
+      return length < 3 ? length : 3;
+    }
+    return 0;
+  }
+
+private:
+  // inverse of the first order compensation in the datasheet
+  unsigned long rawTemperature() {
+    // TEMP = 2000 + dT * C6 / 2^23, D2 = C5 * 2^8 + dT
+    int64_t dT = (int64_t)((silBench.temperature * 100.0 - 2000.0) * 8388608.0 / prom[6]);
+    return (unsigned long)(((int64_t)prom[5] << 8) + dT);
+  }
+
+  unsigned long rawPressure() {
+    int64_t dT   = (int64_t)rawTemperature() - ((int64_t)prom[5] << 8);
+    int64_t off  = ((int64_t)prom[2] << 16) + ((prom[4] * dT) >> 7);
+    int64_t sens = ((int64_t)prom[1] << 15) + ((prom[3] * dT) >> 8);
+    // P = (D1 * SENS / 2^21 - OFF) / 2^15
+    int64_t d1 = ((((int64_t)silBench.pressure) << 15) + off) * 2097152 / sens;
+    return (unsigned long)d1;
+  }
+
+  uint16_t crc4() {
+    uint16_t n_rem = 0;
+    uint16_t saved = prom[7];
+    prom[7] &= 0xFF00;
+    for (int cnt = 0; cnt < 16; cnt++) {
+      if (cnt % 2 == 1) {
+        n_rem ^= prom[cnt >> 1] & 0x00FF;
+      }
+      else {
+        n_rem ^= prom[cnt >> 1] >> 8;
+      }
+      for (int n_bit = 8; n_bit > 0; n_bit--) {
+        n_rem = (n_rem & 0x8000) ? (n_rem << 1) ^ 0x3000 : (n_rem << 1);
+      }
+    }
+    prom[7] = saved;
+    return (n_rem >> 12) & 0xF;
+  }
+
+  uint16_t prom[8];
+  uint8_t command;
+  unsigned long conversion;
+};
+
+static SILMPU6050  silMPU6050;
+static SILHMC5883L silHMC5883L;
+static SILMS5611   silMS5611;
+
+void silAttachSensors() {
+  silAttachI2CDevice(0x68, &silMPU6050);
+  silAttachI2CDevice(0x1E, &silHMC5883L);
+  silAttachI2CDevice(0x76, &silMS5611);
+}
@@ -0,0 +1,92 @@
+#ifndef WProgram_h
+	#define WProgram_h
+
+	// Arduino core replacement for the Linux host (software in the loop) build.
+	// Time is virtual: micros()/millis() only move when delay()/delayMicroseconds()
+	// are called, when a simulated bus transfer takes place, or when the main
+	// loop driver advances the clock between two loop() passes.
+
+	#include <stdint.h>
+	#include <stdio.h>
+	#include <stdlib.h>
+	#include <string.h>
+	#include <math.h>
+
+	extern void setup();
+	extern void loop();
+
+	typedef uint8_t byte;
+	typedef bool    boolean;
+	typedef uint16_t word;
+
+	#define HIGH 0x1
+	#define LOW  0x0
+
+	#define INPUT        0x0
+	#define OUTPUT       0x1
+	#define INPUT_PULLUP 0x2
+	#define INPUT_ANALOG 0x3
+	#define PWM          0x4
+
+	#define LSBFIRST 0
+	#define MSBFIRST 1
+
+	#define DEC 10
+	#define HEX 16
+	#define OCT 8
+	#define BIN 2
+
+	#ifndef PI
+		#define PI 3.1415926535897932384626433832795
+	#endif
+	#define HALF_PI    1.5707963267948966192313216916398
+	#define TWO_PI     6.283185307179586476925286766559
+	#define DEG_TO_RAD 0.017453292519943295769236907684886
+	#define RAD_TO_DEG 57.295779513082320876798154814105
+
+	#define min(a,b) ((a)<(b)?(a):(b))
+	#define max(a,b) ((a)>(b)?(a):(b))
+	#define constrain(amt,low,high) ((amt)<(low)?(low):((amt)>(high)?(high):(amt)))
+	#define radians(deg) ((deg)*DEG_TO_RAD)
+	#define degrees(rad) ((rad)*RAD_TO_DEG)
+	#define sq(x) ((x)*(x))
+
+	#define lowByte(w)  ((uint8_t) ((w) & 0xff))
+	#define highByte(w) ((uint8_t) ((w) >> 8))
+	#define bitRead(value, bit) (((value) >> (bit)) & 0x01)
+	#define bitSet(value, bit) ((value) |= (1UL << (bit)))
+	#define bitClear(value, bit) ((value) &= ~(1UL << (bit)))
+
+	// flash constants live in ordinary memory on the host
+	#define PROGMEM
+	#define pgm_read_byte(p)     (*(const uint8_t *)(p))
+	#define pgm_read_byte_far(p) (*(const uint8_t *)(p))
+	#define pgm_read_word(p)     (*(const uint16_t *)(p))
+	#define memcpy_P memcpy
+
+	// no interrupts on the host, the whole sketch runs on one thread
+	#define cli()
+	#define sei()
+
+	typedef void (*voidFuncPtr)(void);
+
+	void init();
+
+	unsigned long micros();
+	unsigned long millis();
+	void delay(unsigned long ms);
+	void delayMicroseconds(unsigned int us);
+
+	void pinMode(uint8_t pin, uint8_t mode);
+	void digitalWrite(uint8_t pin, uint8_t value);
+	int digitalRead(uint8_t pin);
+	int analogRead(uint8_t pin);
+	void analogWrite(uint8_t pin, int value);
+
+	long map(long x, long in_min, long in_max, long out_min, long out_max);
+
+	#ifdef __cplusplus
+		#include "HardwareSerial.h"
+		#include "SILClock.h"
+	#endif
+#endif
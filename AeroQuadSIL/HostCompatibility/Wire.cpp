@@ -0,0 +1,148 @@
+// Wire library of the host build, see Wire.h
+
+#include "Wire.h"
+
+static SILI2CDevice *silI2CDevices[128];
+
+void silAttachI2CDevice(uint8_t address, SILI2CDevice *device) {
+  silI2CDevices[address & 0x7F] = device;
+}
+
+TwoWire Wire;
+
+TwoWire::TwoWire() {
+  silTransactions = 0;
+  silBusTimeMicros = 0;
+  clockFrequency = 400000; // same as TWBR = 12 on the AVR boards
+  txAddress = 0;
+  txLength = 0;
+  rxIndex = 0;
+  rxLength = 0;
+  busTimeNanos = 0;
+  asyncDoneTime = 0;
+  asyncResult = 0;
+}
+
+void TwoWire::begin() {
+}
+
+void TwoWire::setClock(unsigned long frequency) {
+  clockFrequency = frequency;
+}
+
+// start + address + data bytes, 9 clocks per byte including ack + stop
+// returns the duration of the transfer in ns
+unsigned long TwoWire::busTransfer(int dataBytes) {
+  unsigned long bits = 1 + (dataBytes + 1) * 9 + 1;
+  unsigned long ns = bits * 1000000000UL / clockFrequency;
+  busTimeNanos += ns;
+  silBusTimeMicros = busTimeNanos / 1000;
+  silTransactions++;
+  return ns;
+}
+
+// a blocking transfer cannot start before the background one has finished
+void TwoWire::waitAsyncTransfer() {
+  unsigned long now = micros();
+  if ((long)(asyncDoneTime - now) > 0) {
+    silAdvanceMicros(asyncDoneTime - now);
+  }
+}
+
+// The devices are accessed at the start, only the completion is delayed
+// by the bus time.
+bool TwoWire::beginAsyncTransfer(uint8_t address, const uint8_t *txData, uint8_t txLength, uint8_t *rxData, uint8_t rxLength) {
+  waitAsyncTransfer();
+  SILI2CDevice *device = silI2CDevices[address & 0x7F];
+  unsigned long ns = 0;
+  asyncResult = 0;
+  if (!device) {
+    ns = busTransfer(0);
+    asyncResult = 2; // address NACK
+  }
+  else {
+    if (txLength) {
+      ns += busTransfer(txLength);
+      device->receive(txData, txLength);
+    }
+    if (rxLength) {
+      ns += busTransfer(rxLength);
+      if (device->transmit(rxData, rxLength) != rxLength) {
+        asyncResult = 4;
+      }
+    }
+  }
+  asyncDoneTime = micros() + (ns + 999) / 1000;
+  return true;
+}
+
+// polling takes time as on the target, a wait loop would not end otherwise
+uint8_t TwoWire::asyncTransferStatus() {
+  if ((long)(asyncDoneTime - micros()) > 0) {
+    silAdvanceMicros(1);
+    return WIRE_ASYNC_BUSY;
+  }
+  return asyncResult;
+}
+
+void TwoWire::beginTransmission(int address) {
+  txAddress = address;
+  txLength = 0;
+}
+
+size_t TwoWire::write(uint8_t data) {
+  if (txLength >= BUFFER_LENGTH) {
+    return 0;
+  }
+  txBuffer[txLength++] = data;
+  return 1;
+}
+
+size_t TwoWire::write(const uint8_t *data, size_t quantity) {
+  size_t n = 0;
+  while (quantity--) {
+    n += write(*data++);
+  }
+  return n;
+}
+
+uint8_t TwoWire::endTransmission(void) {
+  waitAsyncTransfer();
+  SILI2CDevice *device = silI2CDevices[txAddress & 0x7F];
+  if (!device) {
+    silAdvanceNanos(busTransfer(0));
+    return 2; // address NACK
+  }
+  silAdvanceNanos(busTransfer(txLength));
+  device->receive(txBuffer, txLength);
+  txLength = 0;
+  return 0;
+}
+
+uint8_t TwoWire::requestFrom(int address, int quantity) {
+  if (quantity > BUFFER_LENGTH) {
+    quantity = BUFFER_LENGTH;
+  }
+  rxIndex = 0;
+  rxLength = 0;
+  waitAsyncTransfer();
+  SILI2CDevice *device = silI2CDevices[address & 0x7F];
+  if (!device) {
+    silAdvanceNanos(busTransfer(0));
+    return 0;
+  }
+  silAdvanceNanos(busTransfer(quantity));
+  rxLength = device->transmit(rxBuffer, quantity);
+  return rxLength;
+}
+
+int TwoWire::available(void) {
+  return rxLength - rxIndex;
+}
+
+int TwoWire::read(void) {
+  if (rxIndex >= rxLength) {
+    return -1;
+  }
+  return rxBuffer[rxIndex++];
+}
@@ -0,0 +1,69 @@
+#ifndef TwoWire_h
+#define TwoWire_h
+
+// Wire library of the host build.
+// Transfers are routed to simulated devices registered with silAttachI2CDevice().
+// Each transfer advances the virtual clock by its duration on the bus, so the
+// cost of blocking I2C reads shows up in loop timing as it does on the target.
+
+#include "WProgram.h"
+
+#define BUFFER_LENGTH 32
+
+// transfers can also run in the background, see I2C_Queue.h
+#define WIRE_ASYNC_TRANSFER
+#define WIRE_ASYNC_BUSY 0xFF
+
+class SILI2CDevice {
+public:
+  virtual ~SILI2CDevice() {}
+  // master write, data[0] is usually a register address or command
+  virtual void receive(const uint8_t *data, int length) = 0;
+  // master read, returns the number of bytes provided
+  virtual int transmit(uint8_t *data, int length) = 0;
+};
+
+void silAttachI2CDevice(uint8_t address, SILI2CDevice *device);
+
+class TwoWire {
+public:
+  TwoWire();
+  void begin();
+  void setClock(unsigned long frequency);
+  void beginTransmission(int address);
+  uint8_t endTransmission(void);
+  uint8_t requestFrom(int address, int quantity);
+  size_t write(uint8_t data);
+  size_t write(const uint8_t *data, size_t quantity);
+  int available(void);
+  int read(void);
+
+  // Starts a register write and/or read that completes in the background,
+  // asyncTransferStatus() returns WIRE_ASYNC_BUSY until it is done.
+  // Blocking calls made meanwhile first wait for the bus to be free.
+  bool beginAsyncTransfer(uint8_t address, const uint8_t *txData, uint8_t txLength, uint8_t *rxData, uint8_t rxLength);
+  uint8_t asyncTransferStatus();
+
+  // bus statistics
+  unsigned long silTransactions;
+  unsigned long silBusTimeMicros;
+
+private:
+  unsigned long busTransfer(int dataBytes);
+  void waitAsyncTransfer();
+
+  unsigned long clockFrequency;
+  uint8_t txAddress;
+  uint8_t txBuffer[BUFFER_LENGTH];
+  uint8_t txLength;
+  uint8_t rxBuffer[BUFFER_LENGTH];
+  uint8_t rxIndex;
+  uint8_t rxLength;
+  unsigned long busTimeNanos;
+  unsigned long asyncDoneTime;
+  uint8_t asyncResult;
+};
+
+extern TwoWire Wire;
+
+#endif
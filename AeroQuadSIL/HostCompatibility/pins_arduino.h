@@ -0,0 +1 @@
+// dummy file, nothing to do here
@@ -0,0 +1,17 @@
+#ifndef Arduino_h
+#define Arduino_h
+
+// The part of the Arduino core used by Libraries/AQ_I2C/I2C_Queue.h and Device_I2C.h,
+// so that the queue compiles on the host against the clock of I2CQueueBench.cpp
+
+#include <math.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+
+typedef uint8_t byte;
+typedef bool boolean;
+
+unsigned long micros();
+
+#endif
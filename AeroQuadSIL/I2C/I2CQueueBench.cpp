@@ -0,0 +1,223 @@
+// Host test of the I2C transaction queue (Libraries/AQ_I2C/I2C_Queue.h)
+// Runs the queue on a modelled 400kHz bus that completes every transfer in the background,
+// like the STM32 hardware I2C driver, on a simulated clock. Checks that the queue serves high
+// priority first and in queue order within a priority, that a low priority transaction is
+// promoted after I2C_QUEUE_MAX_WAIT when high priority reads keep the bus busy, and the worst
+// wait of each priority under the AeroQuad32 sensor load against the bound the design gives.
+// Build and run with "make i2cqueuebench" in BuildSIL.
+
+#include <stdio.h>
+
+#include "Arduino.h"
+
+static unsigned long benchTime; // us
+
+unsigned long micros() {
+  return benchTime;
+}
+
+#include "I2C_Queue.h"
+
+TwoWire Wire;
+
+byte readByteI2C() {
+  return Wire.read();
+}
+
+#define BUS_BIT_TIME   2.5  // us at 400kHz
+#define POLL_PERIOD    100  // us between two processI2CQueue() calls of the flight loop
+#define LOG_SIZE       16
+
+static unsigned long busDoneTime;
+static bool busBusy = false;
+static unsigned long longestTransfer; // us
+
+// start order of the transactions
+static struct I2CTransaction *serviceLog[LOG_SIZE];
+static int serviceLogLength;
+
+// address, start and stop of each message, 9 bits per byte
+static unsigned long transferTime(uint8_t txLength, uint8_t rxLength) {
+  int bits = 0;
+  if (txLength) {
+    bits += 2 + 9 * (1 + txLength);
+  }
+  if (rxLength) {
+    bits += 2 + 9 * (1 + rxLength);
+  }
+  return (unsigned long)ceil(bits * BUS_BIT_TIME);
+}
+
+bool TwoWire::beginAsyncTransfer(uint8_t address, const uint8_t *txData, uint8_t txLength, uint8_t *rxData, uint8_t rxLength) {
+  if (busBusy) {
+    return false;
+  }
+  unsigned long duration = transferTime(txLength, rxLength);
+  if (duration > longestTransfer) {
+    longestTransfer = duration;
+  }
+  busBusy = true;
+  busDoneTime = benchTime + duration;
+  if (serviceLogLength < LOG_SIZE) {
+    serviceLog[serviceLogLength++] = i2cActiveTransaction;
+  }
+  return true;
+}
+
+uint8_t TwoWire::asyncTransferStatus() {
+  if (busBusy && (long)(benchTime - busDoneTime) < 0) {
+    return WIRE_ASYNC_BUSY;
+  }
+  busBusy = false;
+  return 0;
+}
+
+static void resetQueue() {
+  i2cQueueLength = 0;
+  i2cActiveTransaction = NULL;
+  memset(i2cQueueStatistics, 0, sizeof(i2cQueueStatistics));
+  busBusy = false;
+  longestTransfer = 0;
+  serviceLogLength = 0;
+}
+
+// polls the queue like the flight loop does until the bus and the queue are idle
+static void runQueue() {
+  while (i2cQueueLength > 0 || i2cActiveTransaction) {
+    benchTime += POLL_PERIOD;
+    processI2CQueue();
+  }
+}
+
+static byte readData[16];
+
+static struct I2CTransaction transaction(byte priority, byte rxLength) {
+  struct I2CTransaction result = {0x68, priority, 1, {0}, rxLength, readData, NULL};
+  return result;
+}
+
+// queued while the bus is busy: high priority first, queue order within a priority
+static int serviceOrderTest() {
+  resetQueue();
+  struct I2CTransaction busy = transaction(I2C_PRIORITY_LOW, 14);
+  struct I2CTransaction low1 = transaction(I2C_PRIORITY_LOW, 6);
+  struct I2CTransaction high1 = transaction(I2C_PRIORITY_HIGH, 14);
+  struct I2CTransaction low2 = transaction(I2C_PRIORITY_LOW, 3);
+  struct I2CTransaction high2 = transaction(I2C_PRIORITY_HIGH, 14);
+  struct I2CTransaction high3 = transaction(I2C_PRIORITY_HIGH, 6);
+  queueI2CTransaction(&busy);
+  queueI2CTransaction(&low1);
+  queueI2CTransaction(&high1);
+  queueI2CTransaction(&low2);
+  queueI2CTransaction(&high2);
+  queueI2CTransaction(&high3);
+  runQueue();
+
+  struct I2CTransaction *expected[] = {&busy, &high1, &high2, &high3, &low1, &low2};
+  int count = sizeof(expected) / sizeof(expected[0]);
+  int errors = serviceLogLength != count;
+  for (int index = 0; index < count && index < serviceLogLength; index++) {
+    errors += serviceLog[index] != expected[index];
+  }
+  for (int index = 0; index < count; index++) {
+    errors += expected[index]->status != I2C_DONE;
+  }
+  printf("service order       %s\n", errors ? "wrong" : "high priority first, queue order within a priority");
+  return errors != 0;
+}
+
+// a high priority read queued again by its own callback keeps the bus busy all the time
+static struct I2CTransaction saturatingRead;
+static unsigned long saturatingEnd;
+
+static void saturatingReadDone(struct I2CTransaction *transaction) {
+  if (benchTime < saturatingEnd) {
+    queueI2CTransaction(transaction);
+  }
+}
+
+static int promotionTest() {
+  resetQueue();
+  saturatingRead = transaction(I2C_PRIORITY_HIGH, 14);
+  saturatingRead.callback = saturatingReadDone;
+  saturatingEnd = benchTime + 10 * I2C_QUEUE_MAX_WAIT;
+  struct I2CTransaction low = transaction(I2C_PRIORITY_LOW, 6);
+  queueI2CTransaction(&saturatingRead);
+  queueI2CTransaction(&low);
+  runQueue();
+
+  // the low one is promoted at the first bus hand over after I2C_QUEUE_MAX_WAIT
+  unsigned long bound = I2C_QUEUE_MAX_WAIT + longestTransfer + POLL_PERIOD;
+  struct I2CQueueStatistics *statistics = &i2cQueueStatistics[I2C_PRIORITY_LOW];
+  int errors = low.status != I2C_DONE || statistics->promoted != 1 || statistics->waitMax > bound;
+  printf("promotion           low priority waited %lu us on a saturated bus, %lu promoted (bound %lu us)%s\n",
+         statistics->waitMax, statistics->promoted, bound, errors ? "  wrong" : "");
+  return errors;
+}
+
+// AeroQuad32 sensor load, the gyro/accel read of every loop pass at 1kHz, the magnetometer at 10Hz
+// and the barometer conversion read with its next command at 50Hz
+#define FLIGHT_TIME 10000000 // us
+
+static int flightLoadTest() {
+  resetQueue();
+  struct I2CTransaction gyroRead = transaction(I2C_PRIORITY_HIGH, 14);
+  struct I2CTransaction magRead = transaction(I2C_PRIORITY_LOW, 6);
+  struct I2CTransaction magStart = {0x1E, I2C_PRIORITY_LOW, 2, {0x02, 0x01}, 0, NULL, NULL};
+  struct I2CTransaction baroRead = transaction(I2C_PRIORITY_LOW, 3);
+  struct I2CTransaction baroCommand = {0x76, I2C_PRIORITY_LOW, 1, {0x48}, 0, NULL, NULL};
+
+  unsigned long start = benchTime;
+  unsigned long busTime = 0;
+  for (unsigned long time = 0; time < FLIGHT_TIME; time += POLL_PERIOD) {
+    benchTime = start + time;
+    processI2CQueue();
+    // phases that make the reads of the three sensors meet
+    if (time % 1000 == 0 && queueI2CTransaction(&gyroRead)) {
+      busTime += transferTime(gyroRead.txLength, gyroRead.rxLength);
+    }
+    if (time % 100000 == 0) {
+      queueI2CTransaction(&magRead);
+      queueI2CTransaction(&magStart);
+      busTime += transferTime(1, 6) + transferTime(2, 0);
+    }
+    if (time % 20000 == 0) {
+      queueI2CTransaction(&baroRead);
+      queueI2CTransaction(&baroCommand);
+      busTime += transferTime(1, 3) + transferTime(1, 0);
+    }
+  }
+  runQueue();
+
+  // not preemptive, a high priority transaction waits for the one on the bus and for the poll
+  // that sees it done, a low priority one waits for the other low priority transactions of
+  // the same burst and the gyro reads queued in between
+  unsigned long lowBurst = transferTime(1, 6) + transferTime(2, 0) + transferTime(1, 3) + transferTime(1, 0);
+  unsigned long highBound = longestTransfer + POLL_PERIOD;
+  unsigned long lowBound = lowBurst + 2 * transferTime(1, 14) + 4 * POLL_PERIOD;
+  int errors = 0;
+  printf("flight load         bus %.1f%% busy\n", 100.0 * busTime / FLIGHT_TIME);
+  for (byte priority = 0; priority < I2C_PRIORITIES; priority++) {
+    struct I2CQueueStatistics *statistics = &i2cQueueStatistics[priority];
+    unsigned long bound = priority == I2C_PRIORITY_HIGH ? highBound : lowBound;
+    bool failed = statistics->waitMax > bound || statistics->promoted != 0 || statistics->failed != 0;
+    printf("  %-4s priority     %lu transactions, wait avg %.1f max %lu us (bound %lu us)%s\n",
+           priority == I2C_PRIORITY_HIGH ? "high" : "low", statistics->count,
+           (float)statistics->waitSum / statistics->count, statistics->waitMax, bound, failed ? "  too long" : "");
+    errors += failed;
+  }
+  return errors;
+}
+
+int main() {
+  int errors = 0;
+  errors += serviceOrderTest();
+  errors += promotionTest();
+  errors += flightLoadTest();
+  if (errors) {
+    printf("%d checks failed\n", errors);
+    return 1;
+  }
+  printf("queue order and latency within their bounds\n");
+  return 0;
+}
@@ -0,0 +1,26 @@
+#ifndef TwoWire_h
+#define TwoWire_h
+
+// Bus of I2CQueueBench.cpp: every transfer runs in the background for the time it
+// takes at 400kHz and is logged, the blocking calls are not used by the queue then.
+
+#include "Arduino.h"
+
+#define WIRE_ASYNC_TRANSFER
+#define WIRE_ASYNC_BUSY 0xFF
+
+class TwoWire {
+public:
+  void beginTransmission(int address) {}
+  uint8_t endTransmission(void) { return 0; }
+  uint8_t requestFrom(int address, int quantity) { return 0; }
+  size_t write(uint8_t data) { return 1; }
+  int read(void) { return 0; }
+
+  bool beginAsyncTransfer(uint8_t address, const uint8_t *txData, uint8_t txLength, uint8_t *rxData, uint8_t rxLength);
+  uint8_t asyncTransferStatus();
+};
+
+extern TwoWire Wire;
+
+#endif
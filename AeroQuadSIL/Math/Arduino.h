@@ -0,0 +1,20 @@
+#ifndef Arduino_h
+#define Arduino_h
+
+// The part of the Arduino core used by AQMath.cpp, BiquadFilter.h and the kernels of
+// FixedPointKernels.cpp, so that they compile on the host for the benchmarks in this directory
+
+#include <math.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+
+typedef uint8_t byte;
+typedef bool boolean;
+
+#define PI 3.1415926535897932384626433832795
+
+#define constrain(amt,low,high) ((amt)<(low)?(low):((amt)>(high)?(high):(amt)))
+#define degrees(rad) ((rad)*(180.0/PI))
+
+#endif
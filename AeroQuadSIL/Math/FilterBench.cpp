@@ -0,0 +1,226 @@
+// Host benchmark of the accelerometer filter (Libraries/AQ_Math/BiquadFilter.h)
+// Runs the biquad cascade and the fourth order filter it replaced side by side on sines from
+// 1Hz to the Nyquist frequency, a step and noise at the 100Hz of the task, prints both frequency
+// responses and checks that the outputs agree, then times one three axis sample of each.
+// The float rounding of both is measured against the fourth order filter computed in double.
+// Build and run with "make filterbench" in BuildSIL.
+
+#include <stdio.h>
+#include <time.h>
+
+#include "Arduino.h"
+#include "BiquadFilter.h"
+
+#define SAMPLE_RATE   100.0
+#define BENCH_SAMPLES 1000000
+#define AXES          3
+
+static double hostSeconds() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// FourtOrderFilter.h before the biquads, one direct form I filter per axis
+struct fourthOrderData
+{
+  float  inputTm1,  inputTm2,  inputTm3,  inputTm4;
+  float outputTm1, outputTm2, outputTm3, outputTm4;
+} fourthOrder[AXES];
+
+float computeFourthOrder(float currentInput, struct fourthOrderData *filterParameters)
+{
+  // cheby2(4,60,12.5/50)
+  #define _b0  0.001893594048567
+  #define _b1 -0.002220262954039
+  #define _b2  0.003389066536478
+  #define _b3 -0.002220262954039
+  #define _b4  0.001893594048567
+  
+  #define _a1 -3.362256889209355
+  #define _a2  4.282608240117919
+  #define _a3 -2.444765517272841
+  #define _a4  0.527149895089809
+  
+  float output;
+  
+  output = _b0 * currentInput                + 
+           _b1 * filterParameters->inputTm1  + 
+           _b2 * filterParameters->inputTm2  +
+           _b3 * filterParameters->inputTm3  +
+           _b4 * filterParameters->inputTm4  -
+           _a1 * filterParameters->outputTm1 -
+           _a2 * filterParameters->outputTm2 -
+           _a3 * filterParameters->outputTm3 -
+           _a4 * filterParameters->outputTm4;
+
+  filterParameters->inputTm4 = filterParameters->inputTm3;
+  filterParameters->inputTm3 = filterParameters->inputTm2;
+  filterParameters->inputTm2 = filterParameters->inputTm1;
+  filterParameters->inputTm1 = currentInput;
+  
+  filterParameters->outputTm4 = filterParameters->outputTm3;
+  filterParameters->outputTm3 = filterParameters->outputTm2;
+  filterParameters->outputTm2 = filterParameters->outputTm1;
+  filterParameters->outputTm1 = output;
+    
+  return output;
+}
+
+// the same filter in double as the exact output
+struct exactData
+{
+  double input[4], output[4];
+} exact[AXES];
+
+static double computeExact(double currentInput, struct exactData *data) {
+  static const double b[5] = {0.001893594048567, -0.002220262954039, 0.003389066536478, -0.002220262954039, 0.001893594048567};
+  static const double a[5] = {1.0, -3.362256889209355, 4.282608240117919, -2.444765517272841, 0.527149895089809};
+  double output = b[0] * currentInput;
+  for (int tap = 0; tap < 4; tap++) {
+    output += b[tap + 1] * data->input[tap] - a[tap + 1] * data->output[tap];
+  }
+  for (int tap = 3; tap > 0; tap--) {
+    data->input[tap] = data->input[tap - 1];
+    data->output[tap] = data->output[tap - 1];
+  }
+  data->input[0] = currentInput;
+  data->output[0] = output;
+  return output;
+}
+
+static BiquadCascade<AccelLowPass100Hz, AXES> accelFilter;
+
+// both filters settled on the accelerometer at rest, like setup() does
+static void resetFilters() {
+  const float accelAtRest[AXES] = {0.0, 0.0, -9.8065};
+  for (int axis = 0; axis < AXES; axis++) {
+    fourthOrderData *data = &fourthOrder[axis];
+    data->inputTm1 = data->inputTm2 = data->inputTm3 = data->inputTm4 = accelAtRest[axis];
+    data->outputTm1 = data->outputTm2 = data->outputTm3 = data->outputTm4 = accelAtRest[axis];
+    for (int tap = 0; tap < 4; tap++) {
+      exact[axis].input[tap] = exact[axis].output[tap] = accelAtRest[axis];
+    }
+  }
+  accelFilter.initialize(accelAtRest);
+}
+
+static float (*signal)(int sample, int axis);
+static float frequency;
+
+static float sineSignal(int sample, int axis) {
+  return (axis == ZAXIS ? -9.8065 : 0.0) + sin(2 * PI * frequency * sample / SAMPLE_RATE + axis);
+}
+
+static float stepSignal(int sample, int axis) {
+  return (axis == ZAXIS ? -9.8065 : 0.0) + (sample >= 10 ? 5.0 : 0.0);
+}
+
+// accelerometer noise of a few tenths of m/s/s
+static float noiseSignal(int sample, int axis) {
+  unsigned long hash = (sample * 7919UL + axis * 104729UL) * 2654435761UL;
+  return (axis == ZAXIS ? -9.8065 : 0.0) + ((int)((hash >> 16) % 1001) - 500) / 1000.0;
+}
+
+struct filterRun
+{
+  double fourthOrderRms, biquadRms; // X axis after settling
+  double difference;                // largest difference between the outputs
+  double fourthOrderError, biquadError; // largest difference to the exact output
+};
+
+static void runFilters(int samples, int settle, filterRun *run) {
+  resetFilters();
+  double fourthOrderSum = 0, biquadSum = 0;
+  run->difference = run->fourthOrderError = run->biquadError = 0;
+  for (int sample = 0; sample < samples; sample++) {
+    float input[AXES], output[AXES];
+    for (int axis = 0; axis < AXES; axis++) {
+      input[axis] = signal(sample, axis);
+    }
+    accelFilter.filter(input, output);
+    for (int axis = 0; axis < AXES; axis++) {
+      float reference = computeFourthOrder(input[axis], &fourthOrder[axis]);
+      double exactOutput = computeExact(input[axis], &exact[axis]);
+      run->difference = fmax(run->difference, fabs(reference - output[axis]));
+      run->fourthOrderError = fmax(run->fourthOrderError, fabs(reference - exactOutput));
+      run->biquadError = fmax(run->biquadError, fabs(output[axis] - exactOutput));
+      if (sample >= settle && axis == XAXIS) {
+        fourthOrderSum += reference * reference;
+        biquadSum += output[axis] * output[axis];
+      }
+    }
+  }
+  run->fourthOrderRms = sqrt(fourthOrderSum / (samples - settle));
+  run->biquadRms = sqrt(biquadSum / (samples - settle));
+}
+
+// outputs agree within float rounding on the 1g of the Z axis, below one LSB of the accelerometers
+#define MAX_DIFFERENCE 5e-3
+
+static int printRun(const char *name, filterRun *run) {
+  printf("%-16s max diff %.2e, error against double: fourth order %.2e, biquads %.2e\n", name,
+         run->difference, run->fourthOrderError, run->biquadError);
+  return run->difference > MAX_DIFFERENCE;
+}
+
+int main() {
+  static const float frequencies[] = {1, 2, 3, 4, 5, 6, 8, 10, 12.5, 15, 20, 30, 40, 49};
+  int errors = 0;
+
+  printf("%8s  %12s  %12s  %10s\n", "Hz", "fourth order", "biquads", "max diff");
+  filterRun run;
+  signal = sineSignal;
+  for (unsigned int index = 0; index < sizeof(frequencies) / sizeof(frequencies[0]); index++) {
+    frequency = frequencies[index];
+    runFilters(2000, 500, &run);
+    double fourthOrderGain = 20 * log10(run.fourthOrderRms * sqrt(2.0));
+    double biquadGain = 20 * log10(run.biquadRms * sqrt(2.0));
+    printf("%8.1f  %9.2f dB  %9.2f dB  %10.2e\n", frequency, fourthOrderGain, biquadGain, run.difference);
+    // same response down to the rounding noise in the stopband
+    if (run.difference > MAX_DIFFERENCE || (biquadGain > -50 && fabs(fourthOrderGain - biquadGain) > 0.05)) {
+      printf("  responses differ\n");
+      errors++;
+    }
+  }
+
+  signal = stepSignal;
+  runFilters(500, 0, &run);
+  errors += printRun("step of 5 m/s/s:", &run);
+  signal = noiseSignal;
+  runFilters(100000, 0, &run);
+  errors += printRun("noise:", &run);
+
+  // one three axis sample per pass, inputs from memory so that nothing is hoisted
+  static float input[1024][AXES];
+  for (int sample = 0; sample < 1024; sample++) {
+    for (int axis = 0; axis < AXES; axis++) {
+      input[sample][axis] = noiseSignal(sample, axis);
+    }
+  }
+  volatile float sink;
+  resetFilters();
+  double start = hostSeconds();
+  for (int sample = 0; sample < BENCH_SAMPLES; sample++) {
+    for (int axis = 0; axis < AXES; axis++) {
+      sink = computeFourthOrder(input[sample & 1023][axis], &fourthOrder[axis]);
+    }
+  }
+  double fourthOrderTime = (hostSeconds() - start) / BENCH_SAMPLES;
+  float output[AXES];
+  start = hostSeconds();
+  for (int sample = 0; sample < BENCH_SAMPLES; sample++) {
+    accelFilter.filter(input[sample & 1023], output);
+    sink = output[ZAXIS];
+  }
+  double biquadTime = (hostSeconds() - start) / BENCH_SAMPLES;
+  (void)sink;
+  printf("three axis sample: fourth order %.1f ns, biquads %.1f ns\n", fourthOrderTime * 1e9, biquadTime * 1e9);
+
+  if (errors) {
+    printf("%d differences\n", errors);
+    return 1;
+  }
+  printf("outputs match\n");
+  return 0;
+}
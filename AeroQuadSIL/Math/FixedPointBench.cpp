@@ -0,0 +1,332 @@
+// Host benchmark of the fixed point kernels (FixedPointKernels in AeroQuad/UserConfiguration.h)
+// Runs the float and the fixed point build of the accelerometer filter, readReceiver() and the
+// ARG kinematics side by side on the same inputs and checks the fixed point outputs against the
+// float ones, or against ARG in double where the float rounding adds up over time, checks that the conversions from float saturate out of their range, then times one call
+// of each. The host has an FPU, so the times only show the cost of the integer products here,
+// the gain is on the ATmega boards where every float operation is a library call: count the
+// cycles there with KernelCycles.cpp ("make kernelcyclessim") or with TaskProfiler.
+// Build and run with "make fixedpointbench" in BuildSIL.
+
+#include <stdio.h>
+#include <time.h>
+
+#include "Arduino.h"
+#include "GlobalDefined.h"
+#include "FixedPoint.h"
+
+namespace FloatKernels {
+  #include "FixedPointKernels.h"
+}
+namespace FixedKernels {
+  #include "FixedPointKernels.h"
+}
+
+#define BENCH_CALLS 1000000
+#define CONTROL_PERIOD 10000 // us, 100Hz task
+
+// largest differences accepted for the fixed point build
+#define FILTER_MAX_DIFFERENCE   1e-3 // m/s/s
+#define RECEIVER_MAX_DIFFERENCE 1    // us of stick, the truncation to int may round the other way
+#define ANGLE_MAX_ERROR         0.05 // degrees against ARG in double
+
+static double hostSeconds() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// deterministic noise in -1..1
+static double noise(unsigned long sample, int channel) {
+  unsigned long hash = (sample * 7919UL + channel * 104729UL) * 2654435761UL;
+  return ((int)((hash >> 16) % 2001) - 1000) / 1000.0;
+}
+
+// control task time with a few us of jitter
+static unsigned long taskTime(unsigned long cycle) {
+  return 1000000 + cycle * CONTROL_PERIOD + (unsigned long)(100 + 100 * noise(cycle, 9));
+}
+
+static int filterTest() {
+  FloatKernels::resetKernels();
+  FixedKernels::resetKernels();
+  double difference = 0;
+  for (unsigned long sample = 0; sample < 100000; sample++) {
+    float input[3], floatOutput[3], fixedOutput[3];
+    for (int axis = XAXIS; axis <= ZAXIS; axis++) {
+      input[axis] = (axis == ZAXIS ? -9.8065 : 0.0) + 2.0 * sin(sample * 0.05 * (axis + 1)) + 0.5 * noise(sample, axis);
+    }
+    FloatKernels::runAccelFilter(input, floatOutput);
+    FixedKernels::runAccelFilter(input, fixedOutput);
+    for (int axis = XAXIS; axis <= ZAXIS; axis++) {
+      difference = fmax(difference, fabs(floatOutput[axis] - fixedOutput[axis]));
+    }
+  }
+  bool failed = difference > FILTER_MAX_DIFFERENCE;
+  printf("accel filter   max diff %.2e m/s/s%s\n", difference, failed ? "  too large" : "");
+  return failed;
+}
+
+static int receiverTest() {
+  const float slope[6] = {1.02, 0.98, 1.0, 1.05, 1.0, 1.0};
+  const float offset[6] = {-30.6, 29.4, 0.0, -51.2, 0.0, 0.0};
+  const float smoothFactor[6] = {1.0, 0.7, 0.5, 0.3, 1.0, 1.0};
+  FloatKernels::resetKernels();
+  FixedKernels::resetKernels();
+  FloatKernels::setReceiverCalibration(slope, offset, smoothFactor, 0.75);
+  FixedKernels::setReceiverCalibration(slope, offset, smoothFactor, 0.75);
+  int difference = 0;
+  unsigned long mismatches = 0, commands = 0;
+  for (unsigned long cycle = 0; cycle < 100000; cycle++) {
+    // sticks held for a while, then moved, a new frame every 2 or 3 cycles
+    unsigned long frame = cycle * 2 / 5;
+    int raw[6];
+    for (int channel = 0; channel < 6; channel++) {
+      double stick = (frame / 200) % 3 == 0 ? 0.0 : sin(frame * 0.01 * (channel + 1));
+      raw[channel] = 1500 + (int)(450 * stick) + (int)(3 * noise(frame, channel));
+    }
+    int floatCommand[6], fixedCommand[6];
+    FloatKernels::runReceiver(taskTime(cycle), raw, floatCommand);
+    FixedKernels::runReceiver(taskTime(cycle), raw, fixedCommand);
+    for (int channel = 0; channel < 6; channel++) {
+      int channelDifference = abs(floatCommand[channel] - fixedCommand[channel]);
+      difference = channelDifference > difference ? channelDifference : difference;
+      mismatches += channelDifference != 0;
+      commands++;
+    }
+  }
+  bool failed = difference > RECEIVER_MAX_DIFFERENCE;
+  printf("receiver       max diff %d us, %.2f%% of the commands differ%s\n", difference,
+         100.0 * mismatches / commands, failed ? "  too large" : "");
+  return failed;
+}
+
+// the true attitude as the ARG quaternion in double, integrated in small steps
+static double truth[4];
+
+static void rotateTruth(const double *rate, double dt) {
+  for (int step = 0; step < 10; step++) {
+    double h = dt / 20;
+    double q[4] = {truth[0], truth[1], truth[2], truth[3]};
+    truth[0] += (-q[1] * rate[0] - q[2] * rate[1] - q[3] * rate[2]) * h;
+    truth[1] += ( q[0] * rate[0] + q[2] * rate[2] - q[3] * rate[1]) * h;
+    truth[2] += ( q[0] * rate[1] - q[1] * rate[2] + q[3] * rate[0]) * h;
+    truth[3] += ( q[0] * rate[2] + q[1] * rate[1] - q[2] * rate[0]) * h;
+    double norm = sqrt(truth[0] * truth[0] + truth[1] * truth[1] + truth[2] * truth[2] + truth[3] * truth[3]);
+    for (int index = 0; index < 4; index++) {
+      truth[index] /= norm;
+    }
+  }
+}
+
+// direction of gravity in the body frame the way ARG estimates it, the accelerometers read
+// the opposite, -9.8065 on the Z axis at rest
+template <class T> static void gravity(const T *q, double *vector) {
+  vector[XAXIS] = 2 * (q[1] * q[3] - q[0] * q[2]);
+  vector[YAXIS] = 2 * (q[0] * q[1] + q[2] * q[3]);
+  vector[ZAXIS] = q[0] * q[0] - q[1] * q[1] - q[2] * q[2] + q[3] * q[3];
+}
+
+// argUpdate() in double as the exact attitude
+struct exactARG {
+  double q[4], integral[3], previousError[3];
+};
+
+static void runExactARG(exactARG *state, const float *gyro, const float *accel, double dt) {
+  const double Kp = 0.2, Ki = 0.0005;
+  double *q = state->q;
+  double norm = sqrt((double)accel[XAXIS] * accel[XAXIS] + (double)accel[YAXIS] * accel[YAXIS] + (double)accel[ZAXIS] * accel[ZAXIS]);
+  double a[3] = {accel[XAXIS] / norm, accel[YAXIS] / norm, accel[ZAXIS] / norm};
+  double v[3];
+  gravity(q, v);
+  double e[3] = {v[YAXIS] * a[ZAXIS] - v[ZAXIS] * a[YAXIS], v[ZAXIS] * a[XAXIS] - v[XAXIS] * a[ZAXIS], v[XAXIS] * a[YAXIS] - v[YAXIS] * a[XAXIS]};
+  double g[3];
+  for (int axis = XAXIS; axis <= ZAXIS; axis++) {
+    state->integral[axis] += e[axis] * Ki;
+    if ((state->previousError[axis] > 0 && e[axis] < 0) || (state->previousError[axis] < 0 && e[axis] > 0)) {
+      state->integral[axis] = 0;
+    }
+    state->previousError[axis] = e[axis];
+    g[axis] = (gyro[axis] + Kp * e[axis] + state->integral[axis]) * dt / 2;
+  }
+  double p[4] = {q[0], q[1], q[2], q[3]};
+  q[0] += -p[1] * g[XAXIS] - p[2] * g[YAXIS] - p[3] * g[ZAXIS];
+  q[1] +=  p[0] * g[XAXIS] + p[2] * g[ZAXIS] - p[3] * g[YAXIS];
+  q[2] +=  p[0] * g[YAXIS] - p[1] * g[ZAXIS] + p[3] * g[XAXIS];
+  q[3] +=  p[0] * g[ZAXIS] + p[1] * g[YAXIS] - p[2] * g[XAXIS];
+  norm = sqrt(q[0] * q[0] + q[1] * q[1] + q[2] * q[2] + q[3] * q[3]);
+  for (int index = 0; index < 4; index++) {
+    q[index] /= norm;
+  }
+}
+
+// angle of the rotation between two attitudes
+template <class T> static double rotationBetween(const T *a, const double *b) {
+  double dot = 0;
+  for (int index = 0; index < 4; index++) {
+    dot += a[index] * b[index];
+  }
+  return 2 * acos(fmin(1.0, fabs(dot)));
+}
+
+static double angleBetween(const double *a, const double *b) {
+  double dot = a[XAXIS] * b[XAXIS] + a[YAXIS] * b[YAXIS] + a[ZAXIS] * b[ZAXIS];
+  double cross = sqrt(pow(a[YAXIS] * b[ZAXIS] - a[ZAXIS] * b[YAXIS], 2) + pow(a[ZAXIS] * b[XAXIS] - a[XAXIS] * b[ZAXIS], 2) +
+                      pow(a[XAXIS] * b[YAXIS] - a[YAXIS] * b[XAXIS], 2));
+  return atan2(cross, dot);
+}
+
+// ten minutes of flight with a biased gyro, the heading drifts away from the truth as there is no
+// magnetometer, so the builds are compared to the exact ARG by the rotation between the attitudes
+// and to the truth by the tilt only
+static int kinematicsTest() {
+  FloatKernels::resetKernels();
+  FixedKernels::resetKernels();
+  truth[0] = 1.0;
+  truth[1] = truth[2] = truth[3] = 0.0;
+  exactARG exact = {{1.0, 0.0, 0.0, 0.0}, {0.0, 0.0, 0.0}, {0.0, 0.0, 0.0}};
+  double floatError = 0, fixedError = 0, floatTilt = 0, fixedTilt = 0;
+  for (unsigned long cycle = 0; cycle < 60000; cycle++) {
+    double t = cycle * (CONTROL_PERIOD / 1000000.0);
+    double dt = (taskTime(cycle + 1) - taskTime(cycle)) / 1000000.0;
+    double rate[3] = {0.8 * sin(0.7 * t), 0.6 * sin(0.5 * t + 1.0), 0.5 * cos(0.3 * t)};
+    rotateTruth(rate, dt);
+    double down[3];
+    gravity(truth, down);
+    float accel[3], gyro[3];
+    for (int axis = XAXIS; axis <= ZAXIS; axis++) {
+      accel[axis] = -9.8065 * down[axis] + 0.3 * noise(cycle, axis);
+      gyro[axis] = rate[axis] + 0.01 + 0.02 * noise(cycle, axis + 3);
+    }
+    float floatQuaternion[4], fixedQuaternion[4];
+    FloatKernels::runKinematics(gyro, accel, dt, floatQuaternion);
+    FixedKernels::runKinematics(gyro, accel, dt, fixedQuaternion);
+
+    runExactARG(&exact, gyro, accel, dt);
+
+    floatError = fmax(floatError, rotationBetween(floatQuaternion, exact.q));
+    fixedError = fmax(fixedError, rotationBetween(fixedQuaternion, exact.q));
+    double floatDown[3], fixedDown[3];
+    gravity(floatQuaternion, floatDown);
+    gravity(fixedQuaternion, fixedDown);
+    if (cycle >= 1000) {
+      floatTilt = fmax(floatTilt, angleBetween(floatDown, down));
+      fixedTilt = fmax(fixedTilt, angleBetween(fixedDown, down));
+    }
+  }
+  bool failed = degrees(fixedError) > ANGLE_MAX_ERROR;
+  printf("ARG kinematics error against double: float %.4f, fixed %.4f deg, tilt error float %.2f, fixed %.2f deg%s\n",
+         degrees(floatError), degrees(fixedError), degrees(floatTilt), degrees(fixedTilt), failed ? "  too large" : "");
+  return failed;
+}
+
+// a value out of the range of its format converts to the nearest end of the range instead of
+// wrapping around, the values at the ends of the range convert exactly
+struct conversionCase {
+  const char *name;
+  int32_t (*convert)(float);
+  float value;
+  int32_t expected;
+};
+
+static const conversionCase conversionCases[] = {
+  {"Q16.16", floatToFixed,  32767.0,  32767L * FIXED_ONE},
+  {"Q16.16", floatToFixed, -32768.0,  INT32_MIN},
+  {"Q16.16", floatToFixed,  32768.0,  INT32_MAX},
+  {"Q16.16", floatToFixed,  1.0e6,    INT32_MAX},
+  {"Q16.16", floatToFixed, -1.0e6,    INT32_MIN},
+  {"Q16.16", floatToFixed,  1.0e30,   INT32_MAX},
+  {"Q16.16", floatToFixed, -INFINITY, INT32_MIN},
+  {"Q16.16", floatToFixed,  NAN,      INT32_MAX},
+  {"Q8.24",  floatToQ24,    127.0,    127L * Q24_ONE},
+  {"Q8.24",  floatToQ24,    128.0,    INT32_MAX},
+  {"Q8.24",  floatToQ24,   -200.0,    INT32_MIN},
+  {"Q2.30",  floatToQ30,   -2.0,      INT32_MIN},
+  {"Q2.30",  floatToQ30,    2.0,      INT32_MAX},
+  {"Q2.30",  floatToQ30,   -3.0,      INT32_MIN},
+  {"Q2.30",  floatToQ30,    INFINITY, INT32_MAX},
+};
+
+static int conversionTest() {
+  int errors = 0;
+  for (unsigned int index = 0; index < sizeof(conversionCases) / sizeof(conversionCases[0]); index++) {
+    const conversionCase &test = conversionCases[index];
+    int32_t result = test.convert(test.value);
+    if (result != test.expected) {
+      printf("conversion     %s of %g gives %ld instead of %ld\n", test.name, test.value, (long)result, (long)test.expected);
+      errors++;
+    }
+  }
+  if (!errors) {
+    printf("conversion     out of range values saturate in Q16.16, Q8.24 and Q2.30\n");
+  }
+  return errors;
+}
+
+// one call of each kernel of one build, inputs from memory so that nothing is hoisted
+#define BENCH_INPUTS 1024
+static float benchInput[BENCH_INPUTS][3];
+static int benchRaw[BENCH_INPUTS][6];
+
+#define TIME_KERNELS(KERNELS, times) \
+  { \
+    volatile float sink; \
+    float output[3], quaternion[4]; \
+    int command[6]; \
+    const float slope[6] = {1.0, 1.0, 1.0, 1.0, 1.0, 1.0}; \
+    const float offset[6] = {0.0, 0.0, 0.0, 0.0, 0.0, 0.0}; \
+    const float smoothFactor[6] = {1.0, 1.0, 0.5, 1.0, 1.0, 1.0}; \
+    KERNELS::resetKernels(); \
+    KERNELS::setReceiverCalibration(slope, offset, smoothFactor, 0.75); \
+    double start = hostSeconds(); \
+    for (unsigned long call = 0; call < BENCH_CALLS; call++) { \
+      KERNELS::runAccelFilter(benchInput[call & 1023], output); \
+      sink = output[ZAXIS]; \
+    } \
+    times[0] = (hostSeconds() - start) / BENCH_CALLS; \
+    start = hostSeconds(); \
+    for (unsigned long call = 0; call < BENCH_CALLS; call++) { \
+      KERNELS::runReceiver(call * CONTROL_PERIOD, benchRaw[call & 1023], command); \
+      sink = command[XAXIS]; \
+    } \
+    times[1] = (hostSeconds() - start) / BENCH_CALLS; \
+    start = hostSeconds(); \
+    for (unsigned long call = 0; call < BENCH_CALLS; call++) { \
+      const float gyro[3] = {benchInput[call & 1023][0], benchInput[call & 1023][1], 0.1}; \
+      const float accel[3] = {benchInput[call & 1023][2], 0.5, 9.8}; \
+      KERNELS::runKinematics(gyro, accel, 0.01, quaternion); \
+      sink = quaternion[0]; \
+    } \
+    times[2] = (hostSeconds() - start) / BENCH_CALLS; \
+    (void)sink; \
+  }
+
+int main() {
+  int errors = filterTest();
+  errors += receiverTest();
+  errors += kinematicsTest();
+  errors += conversionTest();
+
+  for (int sample = 0; sample < BENCH_INPUTS; sample++) {
+    for (int axis = 0; axis < 3; axis++) {
+      benchInput[sample][axis] = noise(sample, axis);
+    }
+    for (int channel = 0; channel < 6; channel++) {
+      benchRaw[sample][channel] = 1500 + (int)(400 * noise(sample, channel));
+    }
+  }
+  double floatTimes[3], fixedTimes[3];
+  TIME_KERNELS(FloatKernels, floatTimes);
+  TIME_KERNELS(FixedKernels, fixedTimes);
+  static const char *kernels[3] = {"accel filter", "readReceiver", "ARG update"};
+  printf("host time per call  %8s  %8s\n", "float", "fixed");
+  for (int kernel = 0; kernel < 3; kernel++) {
+    printf("  %-16s  %5.1f ns  %5.1f ns\n", kernels[kernel], floatTimes[kernel] * 1e9, fixedTimes[kernel] * 1e9);
+  }
+
+  if (errors) {
+    printf("%d differences too large\n", errors);
+    return 1;
+  }
+  printf("outputs match\n");
+  return 0;
+}
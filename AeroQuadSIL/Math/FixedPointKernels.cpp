@@ -0,0 +1,90 @@
+// The accelerometer filter, receiver and ARG kernels for FixedPointBench.cpp, built once
+// with -DKERNELS=FloatKernels and once with -DKERNELS=FixedKernels -DFixedPointKernels so that
+// both versions link into the same program, each in its own namespace.
+
+#include "Arduino.h"
+#include "GlobalDefined.h"
+#include "AQMath.h"
+
+namespace KERNELS {
+
+// globals of AeroQuad.h, AeroQuad.ino and Accelerometer.h used by the kernels
+float G_Dt = 0.01;
+float accelOneG = 9.80665;
+
+unsigned long kernelMicros = 0;
+unsigned long micros() {
+  return kernelMicros;
+}
+
+#include "BiquadFilter.h"
+#include "Receiver.h"
+#include "Kinematics.h"
+#include "Kinematics_ARG.h"
+
+#include "FixedPointKernels.h"
+
+#if defined(FixedPointKernels)
+  BiquadCascadeFixed<AccelLowPass100Hz, 3> accelFilter;
+#else
+  BiquadCascade<AccelLowPass100Hz, 3> accelFilter;
+#endif
+
+const int *receiverRaw;
+
+int getRawChannelValue(byte channel) {
+  return receiverRaw[channel];
+}
+
+void setChannelValue(byte channel, int value) {
+}
+
+void resetKernels() {
+  const float accelAtRest[3] = {0.0, 0.0, -9.8065};
+  accelFilter.initialize(accelAtRest);
+
+  initializeReceiverParam(6);
+  receiverReadTime = 0;
+
+  G_Dt = 0.01;
+  initializeKinematics();
+}
+
+void runAccelFilter(const float *input, float *output) {
+  accelFilter.filter(input, output);
+}
+
+void setReceiverCalibration(const float *slope, const float *offset, const float *smoothFactor, float xmitFactor) {
+  for (byte channel = XAXIS; channel < lastReceiverChannel; channel++) {
+    receiverSlope[channel] = slope[channel];
+    receiverOffset[channel] = offset[channel];
+    receiverSmoothFactor[channel] = smoothFactor[channel];
+  }
+  receiverXmitFactor = xmitFactor;
+}
+
+void runReceiver(unsigned long time, const int *raw, int *command) {
+  kernelMicros = time;
+  receiverRaw = raw;
+  readReceiver();
+  for (byte channel = XAXIS; channel < lastReceiverChannel; channel++) {
+    command[channel] = receiverCommand[channel];
+  }
+}
+
+void runKinematics(const float *gyro, const float *accel, float dt, float *quaternion) {
+  G_Dt = dt;
+  calculateKinematics(gyro[XAXIS], gyro[YAXIS], gyro[ZAXIS], accel[XAXIS], accel[YAXIS], accel[ZAXIS], G_Dt);
+  #if defined(FixedPointKernels)
+    for (byte index = 0; index < 4; index++) {
+      quaternion[index] = q30ToFloat(qFixed[index]);
+    }
+  #else
+    quaternion[0] = q0;
+    quaternion[1] = q1;
+    quaternion[2] = q2;
+    quaternion[3] = q3;
+  #endif
+}
+
+}
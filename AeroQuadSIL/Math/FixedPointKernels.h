@@ -0,0 +1,14 @@
+// Entry points of one build of FixedPointKernels.cpp, declared inside its namespace by
+// FixedPointKernels.cpp and FixedPointBench.cpp, no include guard on purpose
+
+void resetKernels();
+
+// accelerometer filter of the 100Hz task
+void runAccelFilter(const float *input, float *output);
+
+// readReceiver() at the time in us on 6 raw channel values
+void setReceiverCalibration(const float *slope, const float *offset, const float *smoothFactor, float xmitFactor);
+void runReceiver(unsigned long time, const int *raw, int *command);
+
+// calculateKinematics() of ARG, returns q0..q3
+void runKinematics(const float *gyro, const float *accel, float dt, float *quaternion);
@@ -0,0 +1,159 @@
+// AVR cycle counts of the fixed point kernels (FixedPointKernels in AeroQuad/UserConfiguration.h)
+// Links the float and the fixed point build of FixedPointKernels.cpp like FixedPointBench.cpp does,
+// times every call of each kernel with Timer1 counting CPU cycles and prints the average and the
+// worst cycles per call on serial port 0 at 115200 baud, then stops the CPU.
+// Build with "make kernelcycles" in BuildSIL (avr-gcc and avr-libc), run it in simavr with
+// "make kernelcyclessim" or upload KernelCycles.hex to a v2 board (ATmega2560, 16MHz) with avrdude.
+
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <avr/sleep.h>
+#include <stdio.h>
+
+#include "Arduino.h"
+#include "GlobalDefined.h"
+
+namespace FloatKernels {
+  #include "FixedPointKernels.h"
+}
+namespace FixedKernels {
+  #include "FixedPointKernels.h"
+}
+
+#define KERNEL_CALLS 200
+#define KERNEL_INPUTS 32
+#define CONTROL_PERIOD 10000 // us, 100Hz task
+#define SERIAL_BAUD 115200
+
+static volatile uint16_t timerOverflows;
+
+ISR(TIMER1_OVF_vect) {
+  timerOverflows++;
+}
+
+// CPU cycles since the timer start, an overflow not served yet is counted when the count has
+// wrapped around already
+static uint32_t cycles() {
+  uint8_t sreg = SREG;
+  cli();
+  uint16_t count = TCNT1;
+  uint16_t overflows = timerOverflows;
+  if ((TIFR1 & _BV(TOV1)) && count < 0x8000) {
+    overflows++;
+  }
+  SREG = sreg;
+  return ((uint32_t)overflows << 16) | count;
+}
+
+static int serialPut(char c, FILE *stream) {
+  if (c == '\n') {
+    serialPut('\r', stream);
+  }
+  loop_until_bit_is_set(UCSR0A, UDRE0);
+  UCSR0A = _BV(U2X0) | _BV(TXC0); // clears TXC0 for the wait at the end
+  UDR0 = c;
+  return 0;
+}
+
+// deterministic noise in -1..1
+static float noise(uint16_t sample, uint8_t channel) {
+  uint32_t hash = (sample * 7919UL + channel * 104729UL) * 2654435761UL;
+  return ((int)((hash >> 16) % 2001) - 1000) / 1000.0;
+}
+
+static float input[KERNEL_INPUTS][3];
+static int raw[KERNEL_INPUTS][6];
+
+struct kernelCycles {
+  uint32_t sum;
+  uint32_t worst;
+};
+
+static uint32_t timerCost;
+
+static void count(struct kernelCycles *kernel, uint32_t start, uint32_t end) {
+  uint32_t spent = end - start - timerCost;
+  kernel->sum += spent;
+  if (spent > kernel->worst) {
+    kernel->worst = spent;
+  }
+}
+
+// every call of each kernel of one build timed on its own, inputs from memory
+#define TIME_KERNELS(KERNELS, result) \
+  { \
+    volatile float sink; \
+    float output[3], quaternion[4]; \
+    int command[6]; \
+    const float slope[6] = {1.0, 1.0, 1.0, 1.0, 1.0, 1.0}; \
+    const float offset[6] = {0.0, 0.0, 0.0, 0.0, 0.0, 0.0}; \
+    const float smoothFactor[6] = {1.0, 1.0, 0.5, 1.0, 1.0, 1.0}; \
+    KERNELS::resetKernels(); \
+    KERNELS::setReceiverCalibration(slope, offset, smoothFactor, 0.75); \
+    for (uint16_t call = 0; call < KERNEL_CALLS; call++) { \
+      uint8_t index = call % KERNEL_INPUTS; \
+      const float gyro[3] = {input[index][0], input[index][1], 0.1}; \
+      const float accel[3] = {input[index][2], 0.5, 9.8}; \
+      uint32_t start = cycles(); \
+      KERNELS::runAccelFilter(input[index], output); \
+      uint32_t end = cycles(); \
+      count(&result[0], start, end); \
+      sink = output[ZAXIS]; \
+      start = cycles(); \
+      KERNELS::runReceiver(call * (unsigned long)CONTROL_PERIOD, raw[index], command); \
+      end = cycles(); \
+      count(&result[1], start, end); \
+      sink = command[XAXIS]; \
+      start = cycles(); \
+      KERNELS::runKinematics(gyro, accel, 0.01, quaternion); \
+      end = cycles(); \
+      count(&result[2], start, end); \
+      sink = quaternion[0]; \
+    } \
+    (void)sink; \
+  }
+
+int main() {
+  UBRR0 = F_CPU / 8 / SERIAL_BAUD - 1;
+  UCSR0A = _BV(U2X0);
+  UCSR0B = _BV(TXEN0);
+  fdevopen(serialPut, NULL);
+
+  TCCR1A = 0;
+  TCCR1B = _BV(CS10); // CPU clock
+  TIMSK1 = _BV(TOIE1);
+  sei();
+
+  uint32_t start = cycles();
+  uint32_t end = cycles();
+  timerCost = end - start;
+
+  for (uint8_t sample = 0; sample < KERNEL_INPUTS; sample++) {
+    for (uint8_t axis = 0; axis < 3; axis++) {
+      input[sample][axis] = noise(sample, axis);
+    }
+    for (uint8_t channel = 0; channel < 6; channel++) {
+      raw[sample][channel] = 1500 + (int)(400 * noise(sample, channel));
+    }
+  }
+  struct kernelCycles floatCycles[3] = {{0, 0}, {0, 0}, {0, 0}};
+  struct kernelCycles fixedCycles[3] = {{0, 0}, {0, 0}, {0, 0}};
+  TIME_KERNELS(FloatKernels, floatCycles);
+  TIME_KERNELS(FixedKernels, fixedCycles);
+
+  static const char *kernels[3] = {"accel filter", "readReceiver", "ARG update"};
+  printf("cycles per call     float avg   max   fixed avg   max\n");
+  for (uint8_t kernel = 0; kernel < 3; kernel++) {
+    printf("  %-16s  %8lu %6lu  %8lu %6lu\n", kernels[kernel],
+           floatCycles[kernel].sum / KERNEL_CALLS, floatCycles[kernel].worst,
+           fixedCycles[kernel].sum / KERNEL_CALLS, fixedCycles[kernel].worst);
+  }
+  loop_until_bit_is_set(UCSR0A, TXC0);
+
+  // interrupts off and asleep, simavr ends the simulation here
+  set_sleep_mode(SLEEP_MODE_PWR_DOWN);
+  sleep_enable();
+  cli();
+  sleep_cpu();
+  return 0;
+}
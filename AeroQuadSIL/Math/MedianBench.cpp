@@ -0,0 +1,174 @@
+// Host benchmark of the median kernels of Libraries/AQ_Math/AQMath.cpp
+// Times findMedianInt/findMedianFloat against the bubble sort they used before, and the sliding
+// window MedianFilter against sorting the window for each sample, and checks every result
+// against a full sort. The window size of MedianFilter is DATASIZE, set when compiling, the
+// calibration arrays use the same size.
+// Build and run with "make medianbench" in BuildSIL, once per size from 25 to 400.
+
+#include <stdio.h>
+#include <time.h>
+#include <algorithm>
+
+#include "Arduino.h"
+#include "AQMath.h"
+
+#define BENCH_SAMPLES 20000 // per timing, calibration arrays or filter samples
+
+static double hostSeconds() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// findMedianInt before the selection, with an int index so that it also runs above 255 values
+static int bubbleSortMedianInt(int *data, int arraySize) {
+  boolean done = 0;
+  while (done != 1) {
+    done = 1;
+    for (int i = 0; i < arraySize - 1; i++) {
+      if (data[i] > data[i + 1]) {
+        int temp = data[i + 1];
+        data[i + 1] = data[i];
+        data[i] = temp;
+        done = 0;
+      }
+    }
+  }
+  return data[arraySize / 2];
+}
+
+// MedianFilter before the heaps: copy and insertion sort the window for each sample
+static float windowSortMedian(const float *window) {
+  float sorted[DATASIZE];
+  memcpy(sorted, window, sizeof(sorted));
+  for (int i = 1; i < DATASIZE; i++) {
+    float temp = sorted[i];
+    int j = i - 1;
+    while (j >= 0 && temp < sorted[j]) {
+      sorted[j + 1] = sorted[j];
+      j--;
+    }
+    sorted[j + 1] = temp;
+  }
+  return sorted[DATASIZE / 2];
+}
+
+// gyro like samples: offset, noise of a few counts and a spike now and then
+static int sensorSample() {
+  int value = 1000 + rand() % 9 - 4;
+  if (rand() % 50 == 0) {
+    value += rand() % 2000 - 1000;
+  }
+  return value;
+}
+
+static int calibrationErrors = 0;
+
+static void checkCalibration(const char *name, int *data) {
+  int reference[DATASIZE];
+  int work[DATASIZE];
+  memcpy(reference, data, sizeof(reference));
+  std::sort(reference, reference + DATASIZE);
+  float floatData[DATASIZE];
+  for (int i = 0; i < DATASIZE; i++) {
+    floatData[i] = data[i] * 0.5;
+  }
+  int diff = -1;
+  memcpy(work, data, sizeof(work));
+  int median = findMedianIntWithDiff(work, DATASIZE, &diff);
+  memcpy(work, data, sizeof(work));
+  if (findMedianInt(work, DATASIZE) != reference[DATASIZE / 2] || median != reference[DATASIZE / 2] ||
+      diff != reference[DATASIZE - 1] - reference[0] || findMedianFloat(floatData, DATASIZE) != reference[DATASIZE / 2] * 0.5) {
+    if (calibrationErrors++ < 5) {
+      printf("%s: median %d diff %d, expected %d diff %d\n", name, median, diff,
+             reference[DATASIZE / 2], reference[DATASIZE - 1] - reference[0]);
+    }
+  }
+}
+
+int main() {
+  static int arrays[BENCH_SAMPLES / 10][DATASIZE];
+  static int work[BENCH_SAMPLES / 10][DATASIZE];
+  const int arrayCount = BENCH_SAMPLES / 10;
+  volatile long sink = 0;
+
+  // results on random, constant, sorted and reversed data
+  srand(DATASIZE);
+  for (int n = 0; n < arrayCount; n++) {
+    for (int i = 0; i < DATASIZE; i++) {
+      arrays[n][i] = sensorSample();
+    }
+    checkCalibration("random", arrays[n]);
+  }
+  int pattern[DATASIZE];
+  for (int i = 0; i < DATASIZE; i++) {
+    pattern[i] = 7;
+  }
+  checkCalibration("constant", pattern);
+  for (int i = 0; i < DATASIZE; i++) {
+    pattern[i] = i;
+  }
+  checkCalibration("sorted", pattern);
+  for (int i = 0; i < DATASIZE; i++) {
+    pattern[i] = DATASIZE - i;
+  }
+  checkCalibration("reversed", pattern);
+
+  // calibration median of one array
+  memcpy(work, arrays, sizeof(work));
+  double start = hostSeconds();
+  for (int n = 0; n < arrayCount; n++) {
+    sink += bubbleSortMedianInt(work[n], DATASIZE);
+  }
+  double bubbleTime = (hostSeconds() - start) / arrayCount;
+  memcpy(work, arrays, sizeof(work));
+  start = hostSeconds();
+  for (int n = 0; n < arrayCount; n++) {
+    sink += findMedianInt(work[n], DATASIZE);
+  }
+  double selectTime = (hostSeconds() - start) / arrayCount;
+
+  // sliding window, checked against the sorted window and timed separately
+  static float samples[BENCH_SAMPLES];
+  for (int n = 0; n < BENCH_SAMPLES; n++) {
+    samples[n] = sensorSample() * 0.1;
+  }
+  float window[DATASIZE];
+  memset(window, 0, sizeof(window));
+  MedianFilter filter;
+  filter.initialize();
+  int filterErrors = 0;
+  for (int n = 0; n < BENCH_SAMPLES; n++) {
+    window[n % DATASIZE] = samples[n];
+    float median = filter.filter(samples[n]);
+    float expected = windowSortMedian(window);
+    if (median != expected && filterErrors++ < 5) {
+      printf("filter sample %d: median %f, expected %f\n", n, median, expected);
+    }
+  }
+
+  memset(window, 0, sizeof(window));
+  start = hostSeconds();
+  for (int n = 0; n < BENCH_SAMPLES; n++) {
+    window[n % DATASIZE] = samples[n];
+    sink += (long)windowSortMedian(window);
+  }
+  double sortWindowTime = (hostSeconds() - start) / BENCH_SAMPLES;
+  filter.initialize();
+  start = hostSeconds();
+  for (int n = 0; n < BENCH_SAMPLES; n++) {
+    sink += (long)filter.filter(samples[n]);
+  }
+  double filterTime = (hostSeconds() - start) / BENCH_SAMPLES;
+
+  printf("size %3d  median: bubble sort %8.2f us, selection %6.2f us, %5.1fx"
+         "  window: sort %8.3f us, heaps %6.3f us, %6.1fx\n", DATASIZE,
+         bubbleTime * 1e6, selectTime * 1e6, bubbleTime / selectTime,
+         sortWindowTime * 1e6, filterTime * 1e6, sortWindowTime / filterTime);
+
+  if (calibrationErrors || filterErrors) {
+    printf("%d calibration and %d filter errors\n", calibrationErrors, filterErrors);
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,125 @@
+// Host benchmark of the trigonometry approximations (Libraries/AQ_Math/FastTrigonometry.h)
+// Sweeps each approximation over its domain against libm in double, checks the largest error
+// against the bounds documented in the header, then times one call of each against the libm
+// float function. The arctan2() of AQMath is measured for comparison. The host times are a
+// hint only, on the boards the float operations are library calls.
+// Build and run with "make trigbench" in BuildSIL.
+
+#include <stdio.h>
+#include <time.h>
+
+#include "Arduino.h"
+#include "AQMath.h"
+#include "FastTrigonometry.h"
+
+#define BENCH_CALLS  10000000
+#define BENCH_INPUTS 1024
+
+// largest errors documented in FastTrigonometry.h
+#define ATAN2_MAX_ERROR 1.2e-5
+#define ASIN_MAX_ERROR  4.0e-6
+#define SIN_MAX_ERROR   9.0e-7
+#define COS_MAX_ERROR   1.3e-6
+#define SQRT_MAX_ERROR  5.0e-6 // relative
+
+static double hostSeconds() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static int report(const char *name, double error, double bound, const char *unit) {
+  bool failed = error > bound;
+  printf("%-10s max error %.2e %s (bound %.1e)%s\n", name, error, unit, bound, failed ? "  too large" : "");
+  return failed;
+}
+
+static int accuracy() {
+  int errors = 0;
+  double atan2Error = 0, arctan2Error = 0;
+  for (int radius = 0; radius < 6; radius++) {
+    double length = pow(10.0, radius - 3);
+    for (int step = 0; step <= 100000; step++) {
+      double angle = -PI + 2 * PI * step / 100000;
+      float y = length * sin(angle), x = length * cos(angle);
+      double exact = atan2((double)y, (double)x);
+      atan2Error = fmax(atan2Error, fabs(fastAtan2(y, x) - exact));
+      double difference = fabs(arctan2(y, x) - exact);
+      arctan2Error = fmax(arctan2Error, fmin(difference, 2 * PI - difference));
+    }
+  }
+  errors += report("fastAtan2", atan2Error, ATAN2_MAX_ERROR, "rad");
+  printf("%-10s max error %.2e rad, the former approximation of AQMath\n", "arctan2", arctan2Error);
+
+  double asinError = 0;
+  for (int step = 0; step <= 1000000; step++) {
+    float x = -1.0 + 2.0 * step / 1000000;
+    asinError = fmax(asinError, fabs(fastAsin(x) - asin((double)x)));
+  }
+  errors += report("fastAsin", asinError, ASIN_MAX_ERROR, "rad");
+
+  double sinError = 0, cosError = 0;
+  for (int step = 0; step <= 1000000; step++) {
+    float x = -4 * PI + 8 * PI * step / 1000000;
+    sinError = fmax(sinError, fabs(fastSin(x) - sin((double)x)));
+    cosError = fmax(cosError, fabs(fastCos(x) - cos((double)x)));
+  }
+  errors += report("fastSin", sinError, SIN_MAX_ERROR, "");
+  errors += report("fastCos", cosError, COS_MAX_ERROR, "");
+
+  double sqrtError = 0;
+  for (int step = 0; step <= 1000000; step++) {
+    float x = pow(10.0, -6.0 + 12.0 * step / 1000000);
+    sqrtError = fmax(sqrtError, fabs(fastSqrt(x) / sqrt((double)x) - 1));
+  }
+  errors += report("fastSqrt", sqrtError, SQRT_MAX_ERROR, "relative");
+  return errors;
+}
+
+static float input[BENCH_INPUTS][2];
+
+#define TIME_CALLS(expression, time) \
+  { \
+    volatile float sink; \
+    double start = hostSeconds(); \
+    for (int call = 0; call < BENCH_CALLS; call++) { \
+      const float *in = input[call & (BENCH_INPUTS - 1)]; \
+      sink = expression; \
+    } \
+    time = (hostSeconds() - start) / BENCH_CALLS; \
+    (void)sink; \
+  }
+
+int main() {
+  int errors = accuracy();
+
+  srand(1);
+  for (int index = 0; index < BENCH_INPUTS; index++) {
+    input[index][0] = 2.0 * rand() / RAND_MAX - 1.0;
+    input[index][1] = 2.0 * rand() / RAND_MAX - 1.0;
+  }
+  double fastTime, libmTime;
+  printf("host time per call   libm     fast\n");
+  TIME_CALLS(atan2f(in[0], in[1]), libmTime);
+  TIME_CALLS(fastAtan2(in[0], in[1]), fastTime);
+  printf("  atan2           %5.1f ns  %5.1f ns\n", libmTime * 1e9, fastTime * 1e9);
+  TIME_CALLS(asinf(in[0]), libmTime);
+  TIME_CALLS(fastAsin(in[0]), fastTime);
+  printf("  asin            %5.1f ns  %5.1f ns\n", libmTime * 1e9, fastTime * 1e9);
+  TIME_CALLS(sinf(in[0] * 4), libmTime);
+  TIME_CALLS(fastSin(in[0] * 4), fastTime);
+  printf("  sin             %5.1f ns  %5.1f ns\n", libmTime * 1e9, fastTime * 1e9);
+  TIME_CALLS(cosf(in[0] * 4), libmTime);
+  TIME_CALLS(fastCos(in[0] * 4), fastTime);
+  printf("  cos             %5.1f ns  %5.1f ns\n", libmTime * 1e9, fastTime * 1e9);
+  TIME_CALLS(sqrtf(in[0] + 1), libmTime);
+  TIME_CALLS(fastSqrt(in[0] + 1), fastTime);
+  printf("  sqrt            %5.1f ns  %5.1f ns\n", libmTime * 1e9, fastTime * 1e9);
+
+  if (errors) {
+    printf("%d approximations off their bound\n", errors);
+    return 1;
+  }
+  printf("approximations within their bounds\n");
+  return 0;
+}
@@ -0,0 +1,19 @@
+#ifndef Arduino_h
+#define Arduino_h
+
+// The part of the Arduino core used by Libraries/AQ_Receiver/Receiver.h and AQMath.cpp,
+// so that the receiver processing compiles on the host against the clock of ReceiverBench.cpp
+
+#include <math.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+
+typedef uint8_t byte;
+typedef bool boolean;
+
+#define PI 3.1415926535897932384626433832795
+
+unsigned long micros();
+
+#endif
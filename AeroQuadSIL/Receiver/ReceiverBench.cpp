@@ -0,0 +1,236 @@
+// Host benchmark of the receiver processing (Libraries/AQ_Receiver/Receiver.h)
+// Models PPM, SBUS and PWM receivers on a simulated clock and reads them like the 100Hz task does
+// now and like the 50Hz task did before. Measures the stick to setpoint latency on stick steps at
+// random receiver frame phases, and how smooth the setpoint follows a constant stick movement:
+// the setpoint change per 10ms control cycle should be constant, steps at the frame or read rate
+// show as deviation from the mean change. Both are checked against the bounds the receiver timing gives.
+// Build and run with "make receiverbench" in BuildSIL, once without and once with ReceiverInterpolation.
+
+#include <stdio.h>
+
+#include "Arduino.h"
+#include "GlobalDefined.h"
+#include "AQMath.h"
+
+static unsigned long benchTime; // us
+
+unsigned long micros() {
+  return benchTime;
+}
+
+#include "Receiver.h"
+
+#define CONTROL_PERIOD  10000  // us, 100Hz task
+#define STEP_TRIALS     400
+#define STEP_SIZE       200    // us of stick
+#define STEP_SPACING    150000 // us between stick steps
+#define RAMP_SPEED      500.0  // us of stick per second
+#define RAMP_TIME       2000000
+
+// Transmitter samples the sticks once per frame, the flight controller gets a channel
+// deliveryDelay + channel * channelDelay after the sample
+struct ReceiverModel {
+  const char *name;
+  unsigned long framePeriod;  // us, not a multiple of the control period so that the phase drifts
+  unsigned long deliveryDelay;
+  unsigned long channelDelay;
+  float resolution;           // us per count
+  int jitter;                 // +- us of measurement noise
+};
+
+static const ReceiverModel receiverModels[] = {
+  {"PPM 22.5ms",  22500, 2000, 1500, 1.0,   1}, // channel ends one after the other in the pulse train
+  {"SBUS 14ms",   14000, 3000,    0, 0.625, 0}, // whole 25 byte frame at 100kbaud, 11 bit channels
+  {"SBUS 7ms",     7000, 3000,    0, 0.625, 0},
+  {"PWM 20ms",    20013, 1500, 2000, 1.0,   2}, // one pulse per channel, measured at its falling edge
+};
+#define RECEIVER_MODELS (sizeof(receiverModels) / sizeof(receiverModels[0]))
+
+static const ReceiverModel *model;
+static float (*stick)(unsigned long time);
+static unsigned long stickStart;
+
+// deterministic noise of one sample
+static int sampleJitter(unsigned long frame, byte channel) {
+  if (model->jitter == 0) {
+    return 0;
+  }
+  unsigned long hash = (frame * 7919 + channel * 104729) * 2654435761UL;
+  return (int)((hash >> 16) % (2 * model->jitter + 1)) - model->jitter;
+}
+
+int getRawChannelValue(byte channel) {
+  unsigned long delay = model->deliveryDelay + channel * model->channelDelay;
+  if (benchTime < delay) {
+    return channel == THROTTLE ? 1000 : 1500;
+  }
+  unsigned long frame = (benchTime - delay) / model->framePeriod;
+  unsigned long sampleTime = frame * model->framePeriod;
+  float value = channel == XAXIS ? stick(sampleTime) : (channel == THROTTLE ? 1000 : 1500);
+  value = floor(value / model->resolution + 0.5) * model->resolution;
+  return (int)floor(value + 0.5) + sampleJitter(frame, channel);
+}
+
+void setChannelValue(byte channel, int value) {
+}
+
+// stick steps between 1500 and 1500 + STEP_SIZE at a random phase within each spacing
+static unsigned long stepTime[STEP_TRIALS];
+
+static float stepStick(unsigned long time) {
+  float value = 1500;
+  for (int trial = 0; trial < STEP_TRIALS && stepTime[trial] <= time; trial++) {
+    value = (trial & 1) ? 1500 : 1500 + STEP_SIZE;
+  }
+  return value;
+}
+
+static float rampStick(unsigned long time) {
+  if (time < stickStart) {
+    return 1000;
+  }
+  float value = 1000 + (time - stickStart) * (RAMP_SPEED / 1000000.0);
+  return value > 2000 ? 2000 : value;
+}
+
+static void resetReceiver() {
+  initializeReceiverParam(6);
+  receiverXmitFactor = 1.0;
+  receiverReadTime = 0;
+  #if defined (ReceiverInterpolation)
+    receiverFrameTime = 0;
+    receiverFramePeriod = 0.0;
+  #endif
+}
+
+// one control cycle, the receiver is read every readDivider cycles
+static void controlCycle(unsigned long cycle, int readDivider) {
+  benchTime = cycle * CONTROL_PERIOD;
+  if (cycle % readDivider == 0) {
+    readReceiver();
+  }
+}
+
+static void stepTest(int readDivider, float *averageLatency, float *maxLatency) {
+  srand(1);
+  for (int trial = 0; trial < STEP_TRIALS; trial++) {
+    stepTime[trial] = 1000000 + trial * STEP_SPACING + rand() % (STEP_SPACING / 2);
+  }
+  stick = stepStick;
+  resetReceiver();
+
+  float latencySum = 0;
+  float latencyMax = 0;
+  int trial = 0;
+  for (unsigned long cycle = 0; trial < STEP_TRIALS; cycle++) {
+    controlCycle(cycle, readDivider);
+    bool up = !(trial & 1);
+    int command = receiverCommand[XAXIS];
+    if (benchTime >= stepTime[trial] &&
+        (up ? command >= 1500 + STEP_SIZE / 2 : command <= 1500 + STEP_SIZE / 2)) {
+      float latency = (benchTime - stepTime[trial]) / 1000.0;
+      latencySum += latency;
+      if (latency > latencyMax) {
+        latencyMax = latency;
+      }
+      trial++;
+    }
+  }
+  *averageLatency = latencySum / STEP_TRIALS;
+  *maxLatency = latencyMax;
+}
+
+static void rampTest(int readDivider, float *meanChange, float *rmsDeviation, float *maxChange) {
+  stick = rampStick;
+  stickStart = 500000;
+  resetReceiver();
+
+  // skip the start and the end of the ramp
+  unsigned long firstCycle = (stickStart + 200000) / CONTROL_PERIOD;
+  unsigned long lastCycle = (stickStart + RAMP_TIME - 200000) / CONTROL_PERIOD;
+  int previous = 0;
+  float sum = 0;
+  float sumSquares = 0;
+  float changeMax = 0;
+  int count = 0;
+  for (unsigned long cycle = 0; cycle <= lastCycle; cycle++) {
+    controlCycle(cycle, readDivider);
+    int command = receiverCommand[XAXIS];
+    if (cycle > firstCycle) {
+      float change = command - previous;
+      sum += change;
+      sumSquares += change * change;
+      if (change > changeMax) {
+        changeMax = change;
+      }
+      count++;
+    }
+    previous = command;
+  }
+  *meanChange = sum / count;
+  *rmsDeviation = sqrt(sumSquares / count - *meanChange * *meanChange);
+  *maxChange = changeMax;
+}
+
+// A stick step is seen at the next transmitter sample, one frame at most, is delivered deliveryDelay
+// later and read at the next read. The interpolation starts the ramp one read in, so it crosses
+// half the step by the next 100Hz read for frame periods up to RECEIVER_MAX_FRAME_PERIOD.
+static float stepLatencyBound(unsigned long readPeriod) {
+  unsigned long bound = model->framePeriod + model->deliveryDelay + readPeriod;
+  #if defined (ReceiverInterpolation)
+    bound += CONTROL_PERIOD;
+  #endif
+  return bound / 1000.0;
+}
+
+// The setpoint changes by the stick movement of the frames seen in one read, plus the resolution,
+// the jitter of two samples and the truncation. The interpolation spreads a frame over the reads,
+// at most two reads of stick movement come together.
+static float changeBound(unsigned long readPeriod) {
+  unsigned long frames = (readPeriod + model->framePeriod - 1) / model->framePeriod;
+  float movement = RAMP_SPEED * frames * model->framePeriod / 1000000.0;
+  #if defined (ReceiverInterpolation)
+    if (readPeriod == CONTROL_PERIOD && model->framePeriod > CONTROL_PERIOD) {
+      movement = RAMP_SPEED * 2 * CONTROL_PERIOD / 1000000.0;
+    }
+  #endif
+  return movement + model->resolution + 2 * model->jitter + 1;
+}
+
+#define MEAN_CHANGE_ERROR 0.1 // us, the setpoint follows the stick without drift
+
+int main() {
+  #if defined (ReceiverInterpolation)
+    printf("ReceiverInterpolation on\n");
+  #else
+    printf("ReceiverInterpolation off\n");
+  #endif
+  printf("%-12s %-6s  %21s  %32s  %s\n", "receiver", "read", "step latency avg/max",
+         "setpoint change per 10ms cycle", "bounds");
+  printf("%-12s %-6s  %21s  %32s  %s\n", "", "", "ms", "mean / rms deviation / max us", "latency ms / change us");
+  int errors = 0;
+
+  for (unsigned int index = 0; index < RECEIVER_MODELS; index++) {
+    model = &receiverModels[index];
+    for (int readDivider = 2; readDivider >= 1; readDivider--) {
+      float averageLatency, maxLatency, meanChange, rmsDeviation, maxChange;
+      stepTest(readDivider, &averageLatency, &maxLatency);
+      rampTest(readDivider, &meanChange, &rmsDeviation, &maxChange);
+      float latencyBound = stepLatencyBound(readDivider * CONTROL_PERIOD);
+      float maxChangeBound = changeBound(readDivider * CONTROL_PERIOD);
+      float expectedChange = RAMP_SPEED * CONTROL_PERIOD / 1000000.0;
+      bool failed = maxLatency > latencyBound || maxChange > maxChangeBound ||
+                    fabs(meanChange - expectedChange) > MEAN_CHANGE_ERROR;
+      printf("%-12s %-6s  %10.1f / %8.1f  %10.2f / %8.2f / %8.1f  %6.1f / %4.1f%s\n", model->name,
+             readDivider == 2 ? "50Hz" : "100Hz", averageLatency, maxLatency, meanChange, rmsDeviation, maxChange,
+             latencyBound, maxChangeBound, failed ? "  off bound" : "");
+      errors += failed;
+    }
+  }
+  if (errors) {
+    printf("%d receiver timings off their bound\n", errors);
+    return 1;
+  }
+  printf("receiver timings within their bounds\n");
+  return 0;
+}
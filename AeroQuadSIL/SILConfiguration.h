@@ -0,0 +1,56 @@
+#ifndef _SIL_CONFIGURATION_H_
+#define _SIL_CONFIGURATION_H_
+
+// Host (software in the loop) build configuration.
+// Included by AeroQuad.ino right after UserConfiguration.h when AeroQuadSIL
+// is defined. The board selected in UserConfiguration.h is replaced by the
+// simulated SIL board, the flight configuration and the flight options are
+// kept so the host build runs the same flight code as the real craft.
+// Options that need hardware the host build does not simulate are removed.
+
+#undef AeroQuad_v1
+#undef AeroQuad_v1_IDG
+#undef AeroQuad_v18
+#undef AeroQuad_Mini
+#undef AeroQuad_Wii
+#undef AeroQuad_Paris_v3
+#undef AeroQuadMega_v1
+#undef AeroQuadMega_v2
+#undef AeroQuadMega_v21
+#undef AeroQuadMega_Wii
+#undef ArduCopter
+#undef AeroQuadMega_CHR6DM
+#undef APM_OP_CHR6DM
+#undef AeroQuadSTM32
+
+// receiver input comes from the test harness
+#undef RemotePCReceiver
+#undef ReceiverSBUS
+#undef ReceiverPPM
+#undef ReceiverHWPPM
+#undef ReceiverTimerPWM
+#undef ReceiverHWPWM
+#undef UseAnalogRSSIReader
+#undef UseEzUHFRSSIReader
+#undef UseSBUSRSSIReader
+#undef ShowRSSI
+
+// not simulated
+#undef AltitudeHoldRangeFinder
+#undef AutoLanding
+#undef UseGPS
+#undef UseGPSNMEA
+#undef UseGPSUBLOX
+#undef UseGPSMTK
+#undef UseGPS406
+#undef UseGPSNavigator
+#undef SlowTelemetry
+#undef SoftModem
+#undef CameraControl
+#undef CameraTXControl
+#undef OSD
+#undef OSD_SYSTEM_MENU
+#undef SERIAL_LCD
+#undef WirelessTelemetry
+
+#endif
@@ -0,0 +1,14 @@
+#ifndef Arduino_h
+#define Arduino_h
+
+// The part of the Arduino core used by AeroQuad/TaskScheduler.h,
+// so that the scheduler compiles on the host against the clock of SchedulerBench.cpp
+
+#include <stdint.h>
+
+typedef uint8_t byte;
+typedef bool boolean;
+
+unsigned long micros();
+
+#endif
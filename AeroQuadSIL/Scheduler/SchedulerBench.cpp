@@ -0,0 +1,283 @@
+// Host test of the task scheduler (AeroQuad/TaskScheduler.h)
+// Runs scripted task tables on a scripted clock: every task function logs its slice and start
+// time and moves the clock by the execution time its script gives. Checks the deadline order,
+// the priority order of equal deadlines, that a sliced task resumes in the following passes and
+// is profiled as one run, the pass budget, and the overrun and miss counts of slow slices,
+// late finishes and releases lost in a stalled loop.
+// Build and run with "make schedulerbench" in BuildSIL.
+
+#include <stdio.h>
+
+#include "Arduino.h"
+
+static unsigned long benchTime; // us
+
+unsigned long micros() {
+  return benchTime;
+}
+
+#define BENCH_TASKS 4
+#define LOG_SIZE    32
+#define MAX_SLICES  4
+
+// TaskProfiler calls of the scheduler, counted per task
+struct ProfilerCalls {
+  int begin;
+  int pause;
+  int resume;
+  int end;
+};
+static struct ProfilerCalls profilerCalls[BENCH_TASKS];
+
+#define TASK_PROFILER_BEGIN(task)  profilerCalls[task].begin++
+#define TASK_PROFILER_PAUSE(task)  profilerCalls[task].pause++
+#define TASK_PROFILER_RESUME(task) profilerCalls[task].resume++
+#define TASK_PROFILER_END(task)    profilerCalls[task].end++
+
+#include "TaskScheduler.h"
+
+// execution time of each slice, the last slice returns TASK_DONE
+struct TaskScript {
+  byte slices;
+  unsigned long sliceTime[MAX_SLICES];
+};
+static struct TaskScript taskScript[BENCH_TASKS];
+
+struct TaskRun {
+  byte task;
+  byte slice;
+  unsigned long now;
+};
+static struct TaskRun runLog[LOG_SIZE];
+static int runLogLength;
+
+template <byte task> byte benchTask(byte slice, unsigned long now) {
+  if (runLogLength < LOG_SIZE) {
+    struct TaskRun run = {task, slice, now};
+    runLog[runLogLength++] = run;
+  }
+  benchTime += taskScript[task].sliceTime[slice];
+  return slice + 1 < taskScript[task].slices ? TASK_CONTINUE : TASK_DONE;
+}
+
+static void script(byte task, unsigned long sliceTime, byte slices = 1) {
+  taskScript[task].slices = slices;
+  for (byte slice = 0; slice < MAX_SLICES; slice++) {
+    taskScript[task].sliceTime[slice] = sliceTime;
+  }
+}
+
+static void resetBench(struct SchedulerTask *tasks, byte count) {
+  benchTime = 1000000;
+  runLogLength = 0;
+  for (byte task = 0; task < BENCH_TASKS; task++) {
+    struct ProfilerCalls none = {0, 0, 0, 0};
+    profilerCalls[task] = none;
+    script(task, 100);
+  }
+  initializeTaskScheduler(tasks, count, benchTime);
+}
+
+// one scheduler pass at the given time, like loop() after the sensor reads
+static void schedulerPass(struct SchedulerTask *tasks, byte count, unsigned long time) {
+  if ((long)(time - benchTime) > 0) {
+    benchTime = time;
+  }
+  runTaskScheduler(tasks, count, benchTime);
+}
+
+static int checkRuns(const char *test, const struct TaskRun *expected, int count) {
+  int errors = runLogLength != count;
+  for (int index = 0; index < count && index < runLogLength; index++) {
+    errors += runLog[index].task != expected[index].task || runLog[index].slice != expected[index].slice ||
+              runLog[index].now != expected[index].now;
+  }
+  if (errors) {
+    printf("%-19s wrong runs, task/slice/start:", test);
+    for (int index = 0; index < runLogLength; index++) {
+      printf(" %d/%d/%lu", runLog[index].task, runLog[index].slice, runLog[index].now);
+    }
+    printf("\n");
+  }
+  return errors != 0;
+}
+
+// released together, the earliest deadline runs first whatever the priority
+static int deadlineOrderTest() {
+  struct SchedulerTask tasks[3] = {
+    // function        period  offset budget priority profiler
+    {benchTask<0>,     100000,      0,  2000, 0, 0},
+    {benchTask<1>,      20000,      0,  2000, 1, 1},
+    {benchTask<2>,      10000,      0,  2000, 2, 2},
+  };
+  resetBench(tasks, 3);
+  unsigned long start = benchTime;
+  schedulerPass(tasks, 3, start);
+
+  const struct TaskRun expected[] = {{2, 0, start}, {1, 0, start + 100}, {0, 0, start + 200}};
+  int errors = checkRuns("deadline order", expected, 3);
+  if (!errors) {
+    printf("deadline order      10ms, 20ms, 100ms period against priority 2, 1, 0\n");
+  }
+  return errors;
+}
+
+// equal deadlines run in priority order, 0 first
+static int priorityTest() {
+  struct SchedulerTask tasks[3] = {
+    {benchTask<0>,      10000,      0,  2000, 2, 0},
+    {benchTask<1>,      10000,      0,  2000, 0, 1},
+    {benchTask<2>,      10000,      0,  2000, 1, 2},
+  };
+  resetBench(tasks, 3);
+  unsigned long start = benchTime;
+  schedulerPass(tasks, 3, start);
+  schedulerPass(tasks, 3, start + 10000);
+
+  const struct TaskRun expected[] = {
+    {1, 0, start}, {2, 0, start + 100}, {0, 0, start + 200},
+    {1, 0, start + 10000}, {2, 0, start + 10100}, {0, 0, start + 10200}};
+  int errors = checkRuns("priority order", expected, 6);
+  if (!errors) {
+    printf("priority order      equal deadlines in priority order, two releases\n");
+  }
+  return errors;
+}
+
+// a sliced task runs one slice per pass, the 10ms task runs between its slices,
+// the task profiler sees one run with two pauses
+static int sliceTest() {
+  struct SchedulerTask tasks[2] = {
+    {benchTask<0>,     100000,      0,  2000, 1, 0},
+    {benchTask<1>,      10000,      0,  2000, 0, 1},
+  };
+  resetBench(tasks, 2);
+  script(0, 300, 3);
+  unsigned long start = benchTime;
+  for (unsigned long pass = 0; pass < 12; pass++) {
+    schedulerPass(tasks, 2, start + pass * 1000);
+  }
+
+  const struct TaskRun expected[] = {
+    {1, 0, start}, {0, 0, start + 100}, {0, 1, start + 1000}, {0, 2, start + 2000},
+    {1, 0, start + 10000}};
+  int errors = checkRuns("slices", expected, 5);
+  struct ProfilerCalls *calls = &profilerCalls[0];
+  if (calls->begin != 1 || calls->pause != 2 || calls->resume != 2 || calls->end != 1 ||
+      tasks[0].pending || tasks[0].overruns || tasks[0].misses) {
+    printf("slices              profiler begin/pause/resume/end %d/%d/%d/%d, pending %d, overruns %u, misses %u, wrong\n",
+           calls->begin, calls->pause, calls->resume, calls->end, tasks[0].pending, tasks[0].overruns, tasks[0].misses);
+    errors++;
+  }
+  if (!errors) {
+    printf("slices              3 slices in 3 passes, profiled as one run\n");
+  }
+  return errors;
+}
+
+// a pass starts no task after TASK_SCHEDULER_PASS_BUDGET, the rest runs in the next pass
+static int passBudgetTest() {
+  struct SchedulerTask tasks[4] = {
+    {benchTask<0>,      10000,      0,  2000, 0, 0},
+    {benchTask<1>,      10000,      0,  2000, 1, 1},
+    {benchTask<2>,      10000,      0,  2000, 2, 2},
+    {benchTask<3>,      10000,      0,  2000, 3, 3},
+  };
+  resetBench(tasks, 4);
+  for (byte task = 0; task < 4; task++) {
+    script(task, 2000);
+  }
+  unsigned long start = benchTime;
+  schedulerPass(tasks, 4, start);
+  int firstPass = runLogLength;
+  schedulerPass(tasks, 4, benchTime + 1000);
+
+  // 0, 2000 and 4000 us into the pass are below the 5000 us budget
+  const struct TaskRun expected[] = {{0, 0, start}, {1, 0, start + 2000}, {2, 0, start + 4000}, {3, 0, start + 7000}};
+  int errors = checkRuns("pass budget", expected, 4);
+  if (!errors) {
+    printf("pass budget         %d of 4 tasks of 2ms in the first pass (budget %d us)\n", firstPass, TASK_SCHEDULER_PASS_BUDGET);
+  }
+  return errors;
+}
+
+// a slice above the task budget is an overrun, a task split in slices within the budget is not
+static int overrunTest() {
+  struct SchedulerTask tasks[2] = {
+    {benchTask<0>,      10000,      0,  2000, 0, 0},
+    {benchTask<1>,     100000,      0,  2000, 1, 1},
+  };
+  resetBench(tasks, 2);
+  script(0, 2500);
+  script(1, 1500, 3);
+  unsigned long start = benchTime;
+  schedulerPass(tasks, 2, start);
+  schedulerPass(tasks, 2, start + 4000);
+  schedulerPass(tasks, 2, start + 5000);
+
+  int errors = tasks[0].overruns != 1 || tasks[0].misses != 0 || tasks[1].overruns != 0 ||
+               tasks[1].misses != 0 || tasks[1].pending;
+  printf("overruns            %u of a 2500 us slice, %u of 3 slices of 1500 us (budget 2000 us)%s\n",
+         tasks[0].overruns, tasks[1].overruns, errors ? "  wrong" : "");
+  return errors;
+}
+
+// the loop comes back 500 us before the deadline of task 1, which needs 1000 us:
+// a miss of task 1, task 0 runs after it and stays within its own deadline
+static int lateFinishTest() {
+  struct SchedulerTask tasks[2] = {
+    {benchTask<0>,      10000,      0,  5000, 0, 0},
+    {benchTask<1>,      10000,   5000,  2000, 1, 1},
+  };
+  resetBench(tasks, 2);
+  script(0, 4000);
+  script(1, 1000);
+  unsigned long start = benchTime;
+  schedulerPass(tasks, 2, start);
+  schedulerPass(tasks, 2, start + 14500);
+
+  const struct TaskRun expected[] = {{0, 0, start}, {1, 0, start + 14500}, {0, 0, start + 15500}};
+  int errors = checkRuns("late finish", expected, 3);
+  errors += tasks[0].misses != 0 || tasks[1].misses != 1;
+  printf("late finish         %u miss of task 1, %u of task 0%s\n",
+         tasks[1].misses, tasks[0].misses, errors ? "  wrong" : "");
+  return errors != 0;
+}
+
+// the loop stalls for 35 ms: the run of the release at 10 ms finishes late and the releases lost
+// during the stall count one miss, the release grid restarts one period after the stall
+static int stallTest() {
+  struct SchedulerTask tasks[1] = {
+    {benchTask<0>,      10000,      0,  2000, 0, 0},
+  };
+  resetBench(tasks, 1);
+  unsigned long start = benchTime;
+  schedulerPass(tasks, 1, start);
+  schedulerPass(tasks, 1, start + 35000);
+  schedulerPass(tasks, 1, start + 40000);
+  schedulerPass(tasks, 1, start + 45000);
+
+  const struct TaskRun expected[] = {{0, 0, start}, {0, 0, start + 35000}, {0, 0, start + 45000}};
+  int errors = checkRuns("stalled loop", expected, 3);
+  errors += tasks[0].misses != 2;
+  printf("stalled loop        %u misses of the 10ms task in a 35ms stall, next run one period after it%s\n",
+         tasks[0].misses, errors ? "  wrong" : "");
+  return errors != 0;
+}
+
+int main() {
+  int errors = 0;
+  errors += deadlineOrderTest();
+  errors += priorityTest();
+  errors += sliceTest();
+  errors += passBudgetTest();
+  errors += overrunTest();
+  errors += lateFinishTest();
+  errors += stallTest();
+  if (errors) {
+    printf("%d checks failed\n", errors);
+    return 1;
+  }
+  printf("scheduler order, slices, overruns and misses as expected\n");
+  return 0;
+}
@@ -0,0 +1,89 @@
+#ifndef _PLATFORM_SIL_H_
+#define _PLATFORM_SIL_H_
+
+// Simulated board of the host build, modelled after the AeroQuad32:
+// MPU6050 on I2C instead of the MPU6000 on SPI, HMC5883L and MS5611.
+// Sensor values come from the bench model in HostCompatibility/SILBench.h
+
+#include <SILBench.h>
+
+#define SIL_BOARD_TYPE "sil"
+#define LED_Green  13
+#define LED_Red    4
+#define LED_Yellow 31
+
+#define BATT_ANALOG_INPUT 0
+
+#include <Device_I2C.h>
+
+// sensors share the bus through the transaction queue, run in the background by the mock bus
+#define I2C_QUEUE
+#include <I2C_Queue.h>
+
+#define MPU6000_I2C
+#define MPU6000_FIFO
+#include <Gyroscope_MPU6000.h>
+#include <Accelerometer_MPU6000.h>
+
+// heading mag hold declaration
+#ifdef HeadingMagHold
+  #include <Compass.h>
+  #define HMC5883L
+#endif
+
+// Altitude declaration
+#ifdef AltitudeHoldBaro
+  #define MS5611
+#endif
+
+// Battery Monitor declaration
+#ifdef BattMonitor
+  #define BattDefaultConfig DEFINE_BATTERY(0, BATT_ANALOG_INPUT, 15.0, 0, BM_NOPIN, 0, 0)
+#endif
+
+void initPlatform() {
+  pinMode(LED_Red, OUTPUT);
+  digitalWrite(LED_Red, LOW);
+  pinMode(LED_Yellow, OUTPUT);
+  digitalWrite(LED_Yellow, LOW);
+
+  // 12.3V on a 15V full scale divider
+  silAnalogInput[BATT_ANALOG_INPUT] = 840;
+
+  // I2C setup
+  silAttachSensors();
+  Wire.begin();
+}
+
+// called when eeprom is initialized
+void initializePlatformSpecificAccelCalibration() {
+  // matches the +-4g range of the MPU6050 model
+  accelScaleFactor[XAXIS] = 9.8065 / 8192.0;
+  accelScaleFactor[YAXIS] = -9.8065 / 8192.0;
+  accelScaleFactor[ZAXIS] = -9.8065 / 8192.0;
+  #ifdef HeadingMagHold
+    magBias[XAXIS]  = 0.0;
+    magBias[YAXIS]  = 0.0;
+    magBias[ZAXIS]  = 0.0;
+  #endif
+}
+
+unsigned long previousMeasureCriticalSensorsTime = 0;
+void measureCriticalSensors() {
+  #ifdef MPU6000_BATCH
+    // the MPU6000 samples on its own, take the batch once per rate loop cycle
+    if (isRateLoopDue()) {
+      measureGyroSum();
+      measureAccelSum();
+    }
+  #else
+    // read sensors not faster than every 1 ms
+    if (currentTime - previousMeasureCriticalSensorsTime >= 1000) {
+      measureGyroSum();
+      measureAccelSum();
+      previousMeasureCriticalSensorsTime = currentTime;
+    }
+  #endif
+}
+
+#endif
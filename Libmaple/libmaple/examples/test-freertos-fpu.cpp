@@ -0,0 +1,123 @@
+// Tests the floating point context switch of the FreeRTOS port on the
+// STM32F4 (built with -mfpu=fpv4-sp-d16).
+//
+// Three tasks run the same float recurrence with many live values, so
+// they hold s0-s31, and get preempted by the tick and by each other.
+// An integer task runs in between without a floating point context.
+// Every round is checked against the result computed before the
+// scheduler started; the report task prints the rounds and the errors
+// of each task on SerialUSB once a second.  Any error count other than
+// 0 means a lost floating point register.
+
+#include "wirish.h"
+#include "libraries/FreeRTOS/MapleFreeRTOS.h"
+
+#define FLOAT_TASKS 3
+#define STEPS 2000
+
+struct fpuTaskState {
+    float seed;
+    float expected;
+    volatile unsigned long rounds;
+    volatile unsigned long errors;
+};
+
+static fpuTaskState fpuTasks[FLOAT_TASKS];
+static volatile unsigned long integerRounds;
+
+static float recurrence(float seed) {
+    float a = seed, b = seed * 0.5f, c = seed * 0.25f, d = 1.0f;
+    float e = 0.1f, f = 0.2f, g = 0.3f, h = 0.4f;
+    for (int step = 0; step < STEPS; step++) {
+        a = a * 0.999f + b * 0.001f;
+        b = b * 0.998f + c * 0.002f;
+        c = c * 0.997f + d * 0.003f;
+        d = d * 0.996f + e * 0.004f;
+        e = e * 0.995f + f * 0.005f;
+        f = f * 0.994f + g * 0.006f;
+        g = g * 0.993f + h * 0.007f;
+        h = h * 0.992f + a * 0.008f;
+    }
+    return a + b + c + d + e + f + g + h;
+}
+
+static void vFloatTask(void *pvParameters) {
+    fpuTaskState *state = (fpuTaskState *)pvParameters;
+    for (;;) {
+        if (recurrence(state->seed) != state->expected) {
+            state->errors++;
+        }
+        state->rounds++;
+        taskYIELD();
+    }
+}
+
+static void vIntegerTask(void *pvParameters) {
+    for (;;) {
+        integerRounds++;
+        vTaskDelay(1);
+    }
+}
+
+static void vReportTask(void *pvParameters) {
+    for (;;) {
+        vTaskDelay(1000);
+        toggleLED();
+        for (int task = 0; task < FLOAT_TASKS; task++) {
+            SerialUSB.print("float task ");
+            SerialUSB.print(task);
+            SerialUSB.print(": rounds ");
+            SerialUSB.print(fpuTasks[task].rounds);
+            SerialUSB.print(" errors ");
+            SerialUSB.println(fpuTasks[task].errors);
+        }
+        SerialUSB.print("integer task: rounds ");
+        SerialUSB.println(integerRounds);
+    }
+}
+
+void setup() {
+    pinMode(BOARD_LED_PIN, OUTPUT);
+
+    for (int task = 0; task < FLOAT_TASKS; task++) {
+        fpuTasks[task].seed = 1.0f + task;
+        fpuTasks[task].expected = recurrence(fpuTasks[task].seed);
+        xTaskCreate(vFloatTask,
+                    (signed portCHAR *)"Float",
+                    configMINIMAL_STACK_SIZE + 64,
+                    &fpuTasks[task],
+                    tskIDLE_PRIORITY + 1,
+                    NULL);
+    }
+    xTaskCreate(vIntegerTask,
+                (signed portCHAR *)"Integer",
+                configMINIMAL_STACK_SIZE,
+                NULL,
+                tskIDLE_PRIORITY + 2,
+                NULL);
+    xTaskCreate(vReportTask,
+                (signed portCHAR *)"Report",
+                configMINIMAL_STACK_SIZE + 128,
+                NULL,
+                tskIDLE_PRIORITY + 3,
+                NULL);
+    vTaskStartScheduler();
+}
+
+void loop() {
+}
+
+// Force init to be called *first*, i.e. before static object allocation.
+// Otherwise, statically allocated objects that need libmaple may fail.
+__attribute__((constructor)) void premain() {
+    init();
+}
+
+int main(void) {
+    setup();
+
+    while (true) {
+        loop();
+    }
+    return 0;
+}
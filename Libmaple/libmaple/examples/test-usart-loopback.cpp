@@ -0,0 +1,107 @@
+// Loop-back test of the serial ports receiving by DMA on the STM32F4.
+//
+// Wire TX to RX on Serial1, Serial2, Serial3 and Serial4 (USART1-3 and
+// UART4). Each port sends bursts of 1 to 200 bytes at 115200 baud and
+// reads them back. Short bursts never fill half of the RX buffer, so
+// they only reach read() through the idle line interrupt; a burst that
+// does not come back at all means a lost idle interrupt, a wrong byte
+// means a byte the DMA missed. The results of each port are printed on
+// SerialUSB once a second.  Any count other than 0 in "lost" or
+// "wrong" is a failure.
+
+#include "wirish.h"
+
+#define PORTS 4
+#define BAUD 115200
+#define MAX_BURST 200
+#define BURST_TIMEOUT 50 // ms, a 200 byte burst takes 17 ms
+
+struct loopbackPort {
+    HardwareSerial *serial;
+    const char *name;
+    unsigned long bursts;
+    unsigned long lost;  // bursts that did not come back complete
+    unsigned long wrong; // bytes received with another value
+};
+
+static loopbackPort ports[PORTS] = {
+    {&Serial1, "Serial1", 0, 0, 0},
+    {&Serial2, "Serial2", 0, 0, 0},
+    {&Serial3, "Serial3", 0, 0, 0},
+    {&Serial4, "Serial4", 0, 0, 0},
+};
+
+static uint8 txData[MAX_BURST];
+static unsigned long burstNumber;
+
+static void runBurst(loopbackPort *port, uint32 length) {
+    HardwareSerial *serial = port->serial;
+    for (uint32 i = 0; i < length; i++) {
+        txData[i] = (uint8)(burstNumber * 31 + i * 7);
+    }
+    serial->write(txData, length);
+
+    uint32 received = 0;
+    uint32 start = millis();
+    while (received < length && millis() - start < BURST_TIMEOUT) {
+        while (serial->available() && received < length) {
+            if (serial->read() != txData[received]) {
+                port->wrong++;
+            }
+            received++;
+        }
+    }
+    if (received < length) {
+        port->lost++;
+    }
+    // drop anything left over so the next burst starts clean
+    while (serial->available()) {
+        serial->read();
+    }
+    port->bursts++;
+}
+
+void setup() {
+    pinMode(BOARD_LED_PIN, OUTPUT);
+    for (int port = 0; port < PORTS; port++) {
+        ports[port].serial->begin(BAUD);
+    }
+}
+
+void loop() {
+    uint32 start = millis();
+    while (millis() - start < 1000) {
+        // lengths 1..200, mostly short ones below half the RX buffer
+        uint32 length = burstNumber % 4 ? 1 + burstNumber % 16 : 1 + (burstNumber * 37) % MAX_BURST;
+        for (int port = 0; port < PORTS; port++) {
+            runBurst(&ports[port], length);
+        }
+        burstNumber++;
+    }
+
+    toggleLED();
+    for (int port = 0; port < PORTS; port++) {
+        SerialUSB.print(ports[port].name);
+        SerialUSB.print(": bursts ");
+        SerialUSB.print(ports[port].bursts);
+        SerialUSB.print(" lost ");
+        SerialUSB.print(ports[port].lost);
+        SerialUSB.print(" wrong ");
+        SerialUSB.println(ports[port].wrong);
+    }
+}
+
+// Force init to be called *first*, i.e. before static object allocation.
+// Otherwise, statically allocated objects that need libmaple may fail.
+__attribute__((constructor)) void premain() {
+    init();
+}
+
+int main(void) {
+    setup();
+
+    while (true) {
+        loop();
+    }
+    return 0;
+}
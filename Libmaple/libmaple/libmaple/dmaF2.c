@@ -144,6 +144,19 @@ void dma_clear_isr_bits(dma_dev *dev, dma_stream stream) {
     }
 }
 
+/* flag offsets of the streams in LISR/HISR */
+static const uint8 dma_isr_offsets[] = {0, 6, 16, 22};
+
+uint8 dma_get_isr_bits(dma_dev *dev, dma_stream stream) {
+    __io uint32 *isr = stream < DMA_STREAM4 ? &dev->regs->LISR : &dev->regs->HISR;
+    uint32 bits = (*isr >> dma_isr_offsets[stream & 3]) & 0x3d;
+    /* same layout as on the F1: TEIF, HTIF, TCIF, GIF */
+    return (((bits >> 3) & 1) << 3) |
+           (((bits >> 4) & 1) << 2) |
+           (((bits >> 5) & 1) << 1) |
+           (bits ? 1 : 0);
+}
+
 /*
  * IRQ handlers
  */
@@ -220,6 +220,15 @@ static inline void dma_set_num_transfers(dma_dev *dev,
     dev->regs->STREAM[stream].NDTR = num_transfers;
 }
 
+/**
+ * @brief Get the number of transfers a DMA stream has left.
+ * @param dev DMA device
+ * @param stream Stream whose count to return.
+ */
+static inline uint16 dma_get_num_transfers(dma_dev *dev, dma_stream stream) {
+    return (uint16)dev->regs->STREAM[stream].NDTR;
+}
+
 void dma_attach_interrupt(dma_dev *dev,
                           dma_stream stream,
                           void (*handler)(void));
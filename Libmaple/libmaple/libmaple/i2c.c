@@ -304,7 +304,7 @@ void __irq_i2c2_ev(void) {
 static void i2c_irq_error_handler(i2c_dev *dev) {
     I2C_CRUMB(ERROR_ENTRY, dev->regs->SR1, dev->regs->SR2);
 
-    dev->error_flags = dev->regs->SR2 & (I2C_SR1_BERR |
+    dev->error_flags = dev->regs->SR1 & (I2C_SR1_BERR |
                                          I2C_SR1_ARLO |
                                          I2C_SR1_AF |
                                          I2C_SR1_OVR);
@@ -393,7 +393,13 @@ void i2c_init(i2c_dev *dev) {
  *              I2C_REMAP: Remap I2C1 to SCL/PB8 SDA/PB9.
  */
 void i2c_master_enable(i2c_dev *dev, uint32 flags) {
-#define I2C_CLK                (STM32_PCLK1/1000000)
+#if defined(STM32F2) && defined(F_CPU)
+/* APB1 runs at HCLK/4 on the F2/F4 boards, see rccF2.c */
+#define I2C_PCLK1              (F_CPU/4)
+#else
+#define I2C_PCLK1              STM32_PCLK1
+#endif
+#define I2C_CLK                (I2C_PCLK1/1000000)
     uint32 ccr   = 0;
     uint32 trise = 0;
 
@@ -413,10 +419,15 @@ void i2c_master_enable(i2c_dev *dev, uint32 flags) {
 
     /* Turn on clock and set GPIO modes */
     i2c_init(dev);
+#ifdef STM32F2
+    /* I2C1..I2C3 are alternate function 4 */
+    gpio_set_af_mode(dev->gpio_port, dev->sda_pin, 4);
+    gpio_set_af_mode(dev->gpio_port, dev->scl_pin, 4);
+#endif
     gpio_set_mode(dev->gpio_port, dev->sda_pin, GPIO_AF_OUTPUT_OD);
     gpio_set_mode(dev->gpio_port, dev->scl_pin, GPIO_AF_OUTPUT_OD);
 
-    /* I2C1 and I2C2 are fed from APB1, clocked at 36MHz */
+    /* I2C1 and I2C2 are fed from APB1, clocked at 36MHz on F1 */
     i2c_set_input_clk(dev, I2C_CLK);
 
     if (flags & I2C_FAST_MODE) {
@@ -425,16 +436,16 @@ void i2c_master_enable(i2c_dev *dev, uint32 flags) {
         if (flags & I2C_DUTY_16_9) {
             /* Tlow/Thigh = 16/9 */
             ccr |= I2C_CCR_DUTY;
-            ccr |= STM32_PCLK1/(400000 * 25);
+            ccr |= I2C_PCLK1/(400000 * 25);
         } else {
             /* Tlow/Thigh = 2 */
-            ccr |= STM32_PCLK1/(400000 * 3);
+            ccr |= I2C_PCLK1/(400000 * 3);
         }
 
         trise = (300 * (I2C_CLK)/1000) + 1;
     } else {
         /* Tlow/Thigh = 1 */
-        ccr = STM32_PCLK1/(100000 * 2);
+        ccr = I2C_PCLK1/(100000 * 2);
         trise = I2C_CLK + 1;
     }
 
@@ -510,6 +521,30 @@ int32 i2c_master_xfer(i2c_dev *dev,
                       uint32 timeout) {
     int32 rc;
 
+    i2c_master_xfer_start(dev, msgs, num);
+
+    rc = wait_for_state_change(dev, I2C_STATE_XFER_DONE, timeout);
+    if (rc < 0) {
+        goto out;
+    }
+
+    dev->state = I2C_STATE_IDLE;
+out:
+    return rc;
+}
+
+/**
+ * @brief Start an i2c transaction without waiting for its completion.
+ *
+ * The messages are processed by the interrupt handler, poll
+ * i2c_master_xfer_status() for the result. msgs must stay valid
+ * until the transaction is complete.
+ *
+ * @param dev I2C device
+ * @param msgs Messages to send/receive
+ * @param num Number of messages to send/receive
+ */
+void i2c_master_xfer_start(i2c_dev *dev, i2c_msg *msgs, uint16 num) {
     ASSERT(dev->state == I2C_STATE_IDLE);
 
     dev->msg = msgs;
@@ -519,15 +554,31 @@ int32 i2c_master_xfer(i2c_dev *dev,
 
     i2c_enable_irq(dev, I2C_IRQ_EVENT);
     i2c_start_condition(dev);
+}
 
-    rc = wait_for_state_change(dev, I2C_STATE_XFER_DONE, timeout);
-    if (rc < 0) {
-        goto out;
-    }
+/**
+ * @brief Check an i2c transaction started with i2c_master_xfer_start().
+ * @param dev I2C device
+ * @param timeout Bus idle timeout in milliseconds, 0 denotes no timeout.
+ * @return 1 while the transaction is running,
+ *         0 on success, the device is idle again,
+ *         I2C_ERROR_PROTOCOL if there was a protocol error,
+ *         I2C_ERROR_TIMEOUT if the transfer timed out.
+ */
+int32 i2c_master_xfer_status(i2c_dev *dev, uint32 timeout) {
+    i2c_state state = dev->state;
 
-    dev->state = I2C_STATE_IDLE;
-out:
-    return rc;
+    if (state == I2C_STATE_ERROR) {
+        return I2C_ERROR_PROTOCOL;
+    }
+    if (state == I2C_STATE_XFER_DONE) {
+        dev->state = I2C_STATE_IDLE;
+        return 0;
+    }
+    if (timeout && systick_uptime() > (dev->timestamp + timeout)) {
+        return I2C_ERROR_TIMEOUT;
+    }
+    return 1;
 }
 
 
@@ -185,6 +185,8 @@ void i2c_master_enable(i2c_dev *dev, uint32 flags);
 #define I2C_ERROR_PROTOCOL      (-1)
 #define I2C_ERROR_TIMEOUT       (-2)
 int32 i2c_master_xfer(i2c_dev *dev, i2c_msg *msgs, uint16 num, uint32 timeout);
+void i2c_master_xfer_start(i2c_dev *dev, i2c_msg *msgs, uint16 num);
+int32 i2c_master_xfer_status(i2c_dev *dev, uint32 timeout);
 
 void i2c_bus_reset(const i2c_dev *dev);
 
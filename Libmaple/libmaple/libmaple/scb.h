@@ -61,5 +61,9 @@ typedef struct scb_reg_map {
 /** System control block register map base pointer */
 #define SCB_BASE                        ((struct scb_reg_map*)0xE000ED00)
 
+/* Interrupt control state register */
+
+#define SCB_ICSR_PENDSTSET              BIT(26)
+
 #endif
 
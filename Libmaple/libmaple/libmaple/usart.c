@@ -32,8 +32,38 @@
  */
 
 #include "usart.h"
+#include "systick.h"
+#include "scb.h"
 #define USART_TX_IRQ
 
+/*
+ * TX by DMA on the ports whose TX stream is not shared with the SPI
+ * DMA: USART3 and UART4 would take DMA1 streams 3 and 4 of SPI2, UART5
+ * stream 7 of the MPU6000 SPI. These ports keep the TXE interrupt.
+ */
+#ifdef STM32F2
+#define USART_TX_DMA
+static void usart1_tx_dma_irq(void);
+static void usart2_tx_dma_irq(void);
+#endif
+
+/*
+ * RX by a circular DMA into rx_buf on all ports but UART5, whose RX
+ * stream (DMA1 stream 0) belongs to the MPU6000 SPI. The bytes are
+ * handed to rbRX at an idle line and at each half of the buffer, not
+ * per byte. USART2 shares DMA1 stream 5 with the SoftModem DAC, see
+ * usart_rx_dma_release().
+ */
+#ifdef STM32F2
+#define USART_RX_DMA
+static void usart1_rx_dma_irq(void);
+static void usart2_rx_dma_irq(void);
+static void usart3_rx_dma_irq(void);
+#ifdef STM32_HIGH_DENSITY
+static void uart4_rx_dma_irq(void);
+#endif
+#endif
+
 /*
  * Devices
  */
@@ -42,7 +72,19 @@ static usart_dev usart1 = {
     .regs     = USART1_BASE,
     .max_baud = 4500000UL,
     .clk_id   = RCC_USART1,
-    .irq_num  = NVIC_USART1
+    .irq_num  = NVIC_USART1,
+#ifdef USART_TX_DMA
+    .tx_dma         = &DMA2,
+    .tx_stream      = DMA_STREAM7,
+    .tx_channel     = DMA_CR_CH4,
+    .tx_dma_handler = usart1_tx_dma_irq,
+#endif
+#ifdef USART_RX_DMA
+    .rx_dma         = &DMA2,
+    .rx_stream      = DMA_STREAM2,
+    .rx_channel     = DMA_CR_CH4,
+    .rx_dma_handler = usart1_rx_dma_irq
+#endif
 };
 /** USART1 device */
 usart_dev *USART1 = &usart1;
@@ -51,7 +93,19 @@ static usart_dev usart2 = {
     .regs     = USART2_BASE,
     .max_baud = 2250000UL,
     .clk_id   = RCC_USART2,
-    .irq_num  = NVIC_USART2
+    .irq_num  = NVIC_USART2,
+#ifdef USART_TX_DMA
+    .tx_dma         = &DMA1,
+    .tx_stream      = DMA_STREAM6,
+    .tx_channel     = DMA_CR_CH4,
+    .tx_dma_handler = usart2_tx_dma_irq,
+#endif
+#ifdef USART_RX_DMA
+    .rx_dma         = &DMA1,
+    .rx_stream      = DMA_STREAM5,
+    .rx_channel     = DMA_CR_CH4,
+    .rx_dma_handler = usart2_rx_dma_irq
+#endif
 };
 /** USART2 device */
 usart_dev *USART2 = &usart2;
@@ -60,7 +114,13 @@ static usart_dev usart3 = {
     .regs     = USART3_BASE,
     .max_baud = 2250000UL,
     .clk_id   = RCC_USART3,
-    .irq_num  = NVIC_USART3
+    .irq_num  = NVIC_USART3,
+#ifdef USART_RX_DMA
+    .rx_dma         = &DMA1,
+    .rx_stream      = DMA_STREAM1,
+    .rx_channel     = DMA_CR_CH4,
+    .rx_dma_handler = usart3_rx_dma_irq
+#endif
 };
 /** USART3 device */
 usart_dev *USART3 = &usart3;
@@ -70,7 +130,13 @@ static usart_dev uart4 = {
     .regs     = UART4_BASE,
     .max_baud = 2250000UL,
     .clk_id   = RCC_UART4,
-    .irq_num  = NVIC_UART4
+    .irq_num  = NVIC_UART4,
+#ifdef USART_RX_DMA
+    .rx_dma         = &DMA1,
+    .rx_stream      = DMA_STREAM2,
+    .rx_channel     = DMA_CR_CH4,
+    .rx_dma_handler = uart4_rx_dma_irq
+#endif
 };
 /** UART4 device */
 usart_dev *UART4 = &uart4;
@@ -85,6 +151,88 @@ static usart_dev uart5 = {
 usart_dev *UART5 = &uart5;
 #endif
 
+/*
+ * Microseconds since boot, the micros() clock of wirish. Looks at the
+ * pending SysTick interrupt instead of COUNTFLAG, reading that from an
+ * interrupt would make micros() miss a millisecond.
+ */
+static uint32 usart_rx_stamp(void) {
+    uint32 reload = SYSTICK_BASE->RVR;
+    uint32 ms = systick_uptime();
+    uint32 count = systick_get_count();
+    if ((SCB_BASE->ICSR & SCB_ICSR_PENDSTSET) && count > reload / 2) {
+        ms++;
+    }
+    return ms * 1000 + (reload - count) / ((reload + 1) / 1000);
+}
+
+#ifdef USART_RX_DMA
+/* Hand the bytes the DMA wrote since the last call over to rbRX */
+static void usart_rx_dma_sync(usart_dev *dev) {
+    ring_buffer *rb = &dev->rbRX;
+    uint16 length = rb->size + 1;
+    uint16 tail = (length - dma_get_num_transfers(*dev->rx_dma, dev->rx_stream)) % length;
+    uint16 received = (tail + length - rb->tail) % length;
+
+    if (received == 0) {
+        return;
+    }
+    if (received > rb->size - rb_full_count(rb)) {
+        /* Unread bytes were overwritten, keep the newest like rb_push_insert() */
+        rb->head = (tail + 1) % length;
+    }
+    rb->tail = tail;
+    dev->rx_time = usart_rx_stamp();
+    if (dev->rx_handler) {
+        dev->rx_handler();
+    }
+}
+
+/* (Re)start the circular RX DMA with an empty rbRX */
+static void usart_rx_dma_start(usart_dev *dev) {
+    dma_dev *dma = *dev->rx_dma;
+
+    nvic_irq_disable(dev->irq_num);
+    dma_disable(dma, dev->rx_stream);
+    while (dma_is_stream_enabled(dma, dev->rx_stream))
+        ;
+    dma_clear_isr_bits(dma, dev->rx_stream);
+    rb_reset(&dev->rbRX);
+    dma_setup_transfer(dma, dev->rx_stream, &dev->regs->DR, dev->rx_buf, NULL,
+                       dev->rx_channel | DMA_CR_MSIZE_8BITS | DMA_CR_PSIZE_8BITS |
+                       DMA_CR_MINC | DMA_CR_CIRC | DMA_CR_DIR_P2M |
+                       DMA_CR_HTIE | DMA_CR_TCIE, 0);
+    dma_set_num_transfers(dma, dev->rx_stream, USART_RX_BUF_SIZE);
+    dma_enable(dma, dev->rx_stream);
+    nvic_irq_enable(dev->irq_num);
+}
+
+/**
+ * @brief Give a serial port's RX DMA stream to another user.
+ *
+ * The port keeps receiving by RXNE interrupt, also after a new
+ * usart_enable().
+ *
+ * @param dev Serial port whose RX stream to release
+ */
+void usart_rx_dma_release(usart_dev *dev) {
+    usart_reg_map *regs = dev->regs;
+
+    if (!dev->rx_dma) {
+        return;
+    }
+    nvic_irq_disable(dev->irq_num);
+    regs->CR3 &= ~USART_CR3_DMAR;
+    regs->CR1 &= ~USART_CR1_IDLEIE;
+    usart_rx_dma_sync(dev);
+    dma_disable(*dev->rx_dma, dev->rx_stream);
+    dma_detach_interrupt(*dev->rx_dma, dev->rx_stream);
+    dev->rx_dma = NULL;
+    regs->CR1 |= USART_CR1_RXNEIE;
+    nvic_irq_enable(dev->irq_num);
+}
+#endif
+
 /**
  * @brief Initialize a serial port.
  * @param dev         Serial port to be initialized
@@ -94,6 +242,19 @@ void usart_init(usart_dev *dev) {
     rb_init(&dev->rbTX, USART_TX_BUF_SIZE, dev->tx_buf);
     rcc_clk_enable(dev->clk_id);
     nvic_irq_enable(dev->irq_num);
+#ifdef USART_TX_DMA
+    if (dev->tx_dma) {
+        dev->tx_dma_count = 0;
+        dma_init(*dev->tx_dma);
+        dma_attach_interrupt(*dev->tx_dma, dev->tx_stream, dev->tx_dma_handler);
+    }
+#endif
+#ifdef USART_RX_DMA
+    if (dev->rx_dma) {
+        dma_init(*dev->rx_dma);
+        dma_attach_interrupt(*dev->rx_dma, dev->rx_stream, dev->rx_dma_handler);
+    }
+#endif
 }
 
 /**
@@ -133,6 +294,18 @@ void usart_set_baud_rate(usart_dev *dev, uint32 baud) {
 void usart_enable(usart_dev *dev) {
     usart_reg_map *regs = dev->regs;
     regs->CR1 = USART_CR1_TE | USART_CR1_RE | USART_CR1_RXNEIE;
+#ifdef USART_TX_DMA
+    if (dev->tx_dma) {
+        regs->CR3 |= USART_CR3_DMAT;
+    }
+#endif
+#ifdef USART_RX_DMA
+    if (dev->rx_dma) {
+        usart_rx_dma_start(dev);
+        regs->CR3 |= USART_CR3_DMAR;
+        regs->CR1 = USART_CR1_TE | USART_CR1_RE | USART_CR1_IDLEIE;
+    }
+#endif
     regs->CR1 |= USART_CR1_UE;
 }
 
@@ -173,6 +346,12 @@ void usart_disable(usart_dev *dev) {
 
     /* Disable UE */
     regs->CR1 &= ~USART_CR1_UE;
+#ifdef USART_RX_DMA
+    if (dev->rx_dma) {
+        regs->CR3 &= ~USART_CR3_DMAR;
+        dma_disable(*dev->rx_dma, dev->rx_stream);
+    }
+#endif
 
     /* Clean up buffer */
     usart_reset_rx(dev);
@@ -192,6 +371,73 @@ void usart_foreach(void (*fn)(usart_dev*)) {
 #endif
 }
 
+#ifdef USART_TX_DMA
+/*
+ * Start a DMA transfer of the bytes waiting in rbTX, up to the end of
+ * the buffer if they wrap around. Only called while no transfer runs.
+ */
+static void usart_tx_dma_start(usart_dev *dev) {
+    ring_buffer *rb = &dev->rbTX;
+    dma_dev *dma = *dev->tx_dma;
+    uint16 head = rb->head;
+    uint16 tail = rb->tail;
+    uint16 count = (tail >= head ? tail : rb->size + 1) - head;
+
+    dev->tx_dma_count = count;
+    if (count == 0) {
+        return;
+    }
+    dma_clear_isr_bits(dma, dev->tx_stream);
+    dma_setup_transfer(dma, dev->tx_stream, &dev->regs->DR, &rb->buf[head], NULL,
+                       dev->tx_channel | DMA_CR_MSIZE_8BITS | DMA_CR_PSIZE_8BITS |
+                       DMA_CR_MINC | DMA_CR_DIR_M2P | DMA_CR_TCIE, 0);
+    dma_set_num_transfers(dma, dev->tx_stream, count);
+    dma_enable(dma, dev->tx_stream);
+}
+
+/* Transfer complete: release the sent bytes and send what came meanwhile */
+static inline void usart_tx_dma_irq(usart_dev *dev) {
+    ring_buffer *rb = &dev->rbTX;
+    dma_clear_isr_bits(*dev->tx_dma, dev->tx_stream);
+    rb->head = (rb->head + dev->tx_dma_count) % (rb->size + 1);
+    usart_tx_dma_start(dev);
+}
+
+static void usart1_tx_dma_irq(void) {
+    usart_tx_dma_irq(USART1);
+}
+
+static void usart2_tx_dma_irq(void) {
+    usart_tx_dma_irq(USART2);
+}
+#endif
+
+#ifdef USART_RX_DMA
+/* Half or all of rx_buf written */
+static inline void usart_rx_dma_irq(usart_dev *dev) {
+    dma_clear_isr_bits(*dev->rx_dma, dev->rx_stream);
+    usart_rx_dma_sync(dev);
+}
+
+static void usart1_rx_dma_irq(void) {
+    usart_rx_dma_irq(USART1);
+}
+
+static void usart2_rx_dma_irq(void) {
+    usart_rx_dma_irq(USART2);
+}
+
+static void usart3_rx_dma_irq(void) {
+    usart_rx_dma_irq(USART3);
+}
+
+#ifdef STM32_HIGH_DENSITY
+static void uart4_rx_dma_irq(void) {
+    usart_rx_dma_irq(UART4);
+}
+#endif
+#endif
+
 /**
  * @brief Nonblocking USART transmit
  * @param dev Serial port to transmit over
@@ -203,9 +449,21 @@ uint32 usart_tx(usart_dev *dev, const uint8 *buf, uint32 len) {
     uint32 txed = 0;
 #ifdef USART_TX_IRQ
     while (txed < len && rb_safe_insert(&dev->rbTX, buf[txed])) {
-    	usart_tx_irq_enable(dev);
     	txed++;
     }
+#ifdef USART_TX_DMA
+    if (dev->tx_dma) {
+        /* An idle stream raises no interrupt, so only this side starts it */
+        asm volatile("" ::: "memory");
+        if (txed > 0 && dev->tx_dma_count == 0) {
+            usart_tx_dma_start(dev);
+        }
+        return txed;
+    }
+#endif
+    if (txed > 0) {
+    	usart_tx_irq_enable(dev);
+    }
 
 #else
     usart_reg_map *regs = dev->regs;
@@ -246,6 +504,28 @@ void usart_putudec(usart_dev *dev, uint32 val) {
  */
 static inline void usart_irq(usart_dev *dev) {
 	volatile int sr = dev->regs->SR;
+#ifdef USART_RX_DMA
+	if(dev->rx_dma) {
+		/*
+		 * IDLE is cleared by a SR read followed by a DR read. A DR read
+		 * here would take a byte arriving meanwhile away from the DMA,
+		 * so the DMA read of the next byte ends the sequence instead:
+		 * at an idle line the IDLE interrupt is turned off and RXNE
+		 * interrupts once on the next byte. The DMA has read that byte
+		 * by the time the handler runs, then IDLE is clear and its
+		 * interrupt is turned on again.
+		 */
+		uint32 cr1 = dev->regs->CR1;
+		if(cr1 & USART_CR1_IDLEIE) {
+			if(sr & USART_SR_IDLE) {
+				dev->regs->CR1 = (cr1 & ~USART_CR1_IDLEIE) | USART_CR1_RXNEIE;
+				usart_rx_dma_sync(dev);
+			}
+		} else if(!(sr & (USART_SR_IDLE | USART_SR_RXNE))) {
+			dev->regs->CR1 = (cr1 & ~USART_CR1_RXNEIE) | USART_CR1_IDLEIE;
+		}
+	} else
+#endif
 	if(sr & USART_SR_RXNE) {
 #ifdef USART_SAFE_INSERT
 		/* If the buffer is full and the user defines USART_SAFE_INSERT,
@@ -255,9 +535,16 @@ static inline void usart_irq(usart_dev *dev) {
 		/* By default, push bytes around in the ring buffer. */
 		rb_push_insert(&dev->rbRX, (uint8)dev->regs->DR);
 #endif
+		dev->rx_time = usart_rx_stamp();
+		if(dev->rx_handler) {
+			dev->rx_handler();
+		}
+		return;
+	}
 
 #ifdef USART_TX_IRQ
-	} else if(sr & USART_SR_TXE) {
+	/* TXE is set whenever DR is empty, only serve it for TX by interrupt */
+	if((sr & USART_SR_TXE) && (dev->regs->CR1 & USART_CR1_TXEIE)) {
 		if(rb_full_count(&dev->rbTX) > 0) {
 			dev->regs->DR = rb_remove(&dev->rbTX);
 		} else {
@@ -266,9 +553,8 @@ static inline void usart_irq(usart_dev *dev) {
 		    asm volatile("nop");
 		    asm volatile("nop");
 		}
-#endif
-
 	}
+#endif
 }
 
 void __irq_usart1(void) {
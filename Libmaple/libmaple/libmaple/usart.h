@@ -40,6 +40,9 @@
 #include "nvic.h"
 #include "ring_buffer.h"
 #include "bitband.h"
+#ifdef STM32F2
+#include "dma.h"
+#endif
 
 
 #ifdef __cplusplus
@@ -255,6 +258,24 @@ typedef struct usart_dev {
     uint8 tx_buf[USART_TX_BUF_SIZE];
     rcc_clk_id clk_id;               /**< RCC clock information */
     nvic_irq_num irq_num;            /**< USART NVIC interrupt */
+#ifdef STM32F2
+    dma_dev **tx_dma;                /**< DMA device draining rbTX, NULL
+                                      * for TX by interrupt */
+    dma_stream tx_stream;            /**< DMA stream of the TX request */
+    uint32 tx_channel;               /**< DMA channel of the TX request */
+    void (*tx_dma_handler)(void);    /**< DMA transfer complete handler */
+    volatile uint16 tx_dma_count;    /**< Bytes of the running DMA transfer */
+    dma_dev **rx_dma;                /**< DMA device filling rx_buf, NULL
+                                      * for RX by interrupt */
+    dma_stream rx_stream;            /**< DMA stream of the RX request */
+    uint32 rx_channel;               /**< DMA channel of the RX request */
+    void (*rx_dma_handler)(void);    /**< DMA half/complete handler */
+#endif
+    volatile uint32 tx_overflows;    /**< Writes that found rbTX full */
+    volatile uint32 rx_time;         /**< Microseconds since boot when the
+                                      * last bytes arrived in rbRX */
+    void (*rx_handler)(void);        /**< Called from the interrupt after
+                                      * bytes arrived in rbRX */
 } usart_dev;
 
 extern usart_dev *USART1;
@@ -272,6 +293,9 @@ void usart_disable(usart_dev *dev);
 void usart_foreach(void (*fn)(usart_dev *dev));
 uint32 usart_tx(usart_dev *dev, const uint8 *buf, uint32 len);
 void usart_putudec(usart_dev *dev, uint32 val);
+#ifdef STM32F2
+void usart_rx_dma_release(usart_dev *dev);
+#endif
 
 /**
  * @brief Disable all serial ports.
@@ -290,8 +314,11 @@ static inline void usart_disable_all(void) {
  * @param byte Byte to transmit.
  */
 static inline void usart_putc(usart_dev* dev, uint8 byte) {
-    while (!usart_tx(dev, &byte, 1))
-        ;
+    if (!usart_tx(dev, &byte, 1)) {
+        dev->tx_overflows++;
+        while (!usart_tx(dev, &byte, 1))
+            ;
+    }
 }
 
 /**
@@ -332,6 +359,33 @@ static inline uint32 usart_data_available(usart_dev *dev) {
     return rb_full_count(&dev->rbRX);
 }
 
+/**
+ * @brief Return when data last arrived in a serial port's RX buffer.
+ *
+ * Ports received by DMA hand over their bytes in chunks, at an idle
+ * line and at each half of the buffer, so this is the time the last
+ * chunk (usually a whole frame) was complete.
+ *
+ * @param dev Serial port to check
+ * @return Microseconds since boot, on the same clock as micros().
+ */
+static inline uint32 usart_rx_time(usart_dev *dev) {
+    return dev->rx_time;
+}
+
+/**
+ * @brief Call a function whenever data arrived in a serial port's RX buffer.
+ *
+ * The handler runs in interrupt context, once per chunk on ports
+ * received by DMA and once per byte otherwise. It may read the port.
+ *
+ * @param dev Serial port to watch
+ * @param handler Function to call, NULL to stop the calls.
+ */
+static inline void usart_attach_rx_handler(usart_dev *dev, void (*handler)(void)) {
+    dev->rx_handler = handler;
+}
+
 /**
  * @brief Return the amount of data available in a serial port's TX buffer.
  * @param dev Serial port to check
@@ -341,12 +395,34 @@ static inline uint32 usart_data_pending(usart_dev *dev) {
     return rb_full_count(&dev->rbTX);
 }
 
+/**
+ * @brief Return the free space in a serial port's TX buffer.
+ * @param dev Serial port to check
+ * @return Number of bytes usart_tx() can queue without blocking.
+ */
+static inline uint32 usart_tx_space(usart_dev *dev) {
+    return dev->rbTX.size - rb_full_count(&dev->rbTX);
+}
+
+/**
+ * @brief Return how often a write found a serial port's TX buffer full.
+ *
+ * Each of these writes waited for the buffer to drain.
+ *
+ * @param dev Serial port to check
+ * @return Number of writes that did not fit into dev's TX buffer.
+ */
+static inline uint32 usart_tx_overflows(usart_dev *dev) {
+    return dev->tx_overflows;
+}
+
 /**
  * @brief Discard the contents of a serial port's RX buffer.
  * @param dev Serial port whose buffer to empty.
  */
 static inline void usart_reset_rx(usart_dev *dev) {
-    rb_reset(&dev->rbRX);
+    /* Keeps tail where the RX DMA writes next */
+    dev->rbRX.head = dev->rbRX.tail;
 }
 
 #ifdef __cplusplus
@@ -28,6 +28,10 @@
 
 extern "C" {
 
+unsigned long ulMapleRunTimeCounter(void) {
+    return micros();
+}
+
 void vApplicationStackOverflowHook(xTaskHandle *pxTask,
                                    signed char *pcTaskName) {
     /* This function will get called if a task overflows its stack.
@@ -73,7 +73,13 @@
 #define configTICK_RATE_HZ			( ( portTickType ) 1000 )
 #define configMAX_PRIORITIES		( ( unsigned portBASE_TYPE ) 5 )
 #define configMINIMAL_STACK_SIZE	( ( unsigned short ) 120 )
-#define configTOTAL_HEAP_SIZE		( ( size_t ) ( 8 * 1024 ) )
+// !!! Maple
+#if defined(STM32F2)
+	#define configTOTAL_HEAP_SIZE		( ( size_t ) ( 32 * 1024 ) )
+#else
+	#define configTOTAL_HEAP_SIZE		( ( size_t ) ( 8 * 1024 ) )
+#endif
+// !!! Maple
 #define configMAX_TASK_NAME_LEN		( 16 )
 #define configUSE_TRACE_FACILITY	1
 #define configUSE_16_BIT_TICKS		0
@@ -89,7 +95,15 @@
 #define configCHECK_FOR_STACK_OVERFLOW	2
 #define configUSE_RECURSIVE_MUTEXES		1
 #define configQUEUE_REGISTRY_SIZE		0
-#define configGENERATE_RUN_TIME_STATS	0
+#define configGENERATE_RUN_TIME_STATS	1
+
+// !!! Maple
+/* Run time statistics count microseconds, ulMapleRunTimeCounter() is
+micros() of wirish, see MapleFreeRTOS.cpp. */
+extern unsigned long ulMapleRunTimeCounter( void );
+#define portCONFIGURE_TIMER_FOR_RUN_TIME_STATS()
+#define portGET_RUN_TIME_COUNTER_VALUE() ulMapleRunTimeCounter()
+// !!! Maple
 
 /* Set the following definitions to 1 to include the API function, or zero
 to exclude the API function. */
@@ -101,6 +115,7 @@ to exclude the API function. */
 #define INCLUDE_vTaskSuspend			1
 #define INCLUDE_vTaskDelayUntil			1
 #define INCLUDE_vTaskDelay				1
+#define INCLUDE_uxTaskGetStackHighWaterMark	1
 
 /* This is the raw value as per the Cortex-M3 NVIC.  Values can be 255
 (lowest) to 0 (1?) (highest). */
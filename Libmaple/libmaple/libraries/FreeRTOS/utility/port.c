@@ -81,6 +81,21 @@ FreeRTOS.org versions prior to V4.4.0 did not include this definition. */
 /* Constants required to set up the initial stack. */
 #define portINITIAL_XPSR			( 0x01000000 )
 
+// !!! Maple
+/* The STM32F2 family builds cover the Cortex-M4F parts (STM32F4).  Code built
+with the FPU enabled can have a floating point context in every task, so the
+context switch has to save s16-s31 and the EXC_RETURN value of each task as
+the ARM_CM4F port does.  The FPU itself is enabled by the startup code. */
+#if defined(STM32F2)
+	#define portSAVE_FPU_CONTEXT		1
+	#define portINITIAL_EXEC_RETURN		( 0xfffffffd )
+	#define portFPCCR					( ( volatile unsigned long * ) 0xe000ef34 )
+	#define portASPEN_AND_LSPEN_BITS	( 0x3UL << 30UL )
+#else
+	#define portSAVE_FPU_CONTEXT		0
+#endif
+// !!! Maple
+
 /* The priority used by the kernel is assigned to a variable to make access
 from inline assembler easier. */
 const unsigned long ulKernelPriority = configKERNEL_INTERRUPT_PRIORITY;
@@ -123,6 +138,11 @@ portSTACK_TYPE *pxPortInitialiseStack( portSTACK_TYPE *pxTopOfStack, pdTASK_CODE
 	*pxTopOfStack = 0;	/* LR */
 	pxTopOfStack -= 5;	/* R12, R3, R2 and R1. */
 	*pxTopOfStack = ( portSTACK_TYPE ) pvParameters;	/* R0 */
+	#if portSAVE_FPU_CONTEXT == 1
+		/* A task starts without a floating point context. */
+		pxTopOfStack--;
+		*pxTopOfStack = portINITIAL_EXEC_RETURN;
+	#endif
 	pxTopOfStack -= 8;	/* R11, R10, R9, R8, R7, R6, R5 and R4. */
 
 	return pxTopOfStack;
@@ -138,11 +158,17 @@ void __exc_svc( void )
 					"	ldr	r3, pxCurrentTCBConst2		\n" /* Restore the context. */
 					"	ldr r1, [r3]					\n" /* Use pxCurrentTCBConst to get the pxCurrentTCB address. */
 					"	ldr r0, [r1]					\n" /* The first item in pxCurrentTCB is the task top of stack. */
+#if portSAVE_FPU_CONTEXT == 1
+					"	ldmia r0!, {r4-r11, r14}		\n" /* Pop the core registers and the EXC_RETURN value. */
+#else
 					"	ldmia r0!, {r4-r11}				\n" /* Pop the registers that are not automatically saved on exception entry and the critical nesting count. */
+#endif
 					"	msr psp, r0						\n" /* Restore the task stack pointer. */
 					"	mov r0, #0 						\n"
 					"	msr	basepri, r0					\n"
+#if portSAVE_FPU_CONTEXT == 0
 					"	orr r14, #0xd					\n"
+#endif
 					"	bx r14							\n"
 					"									\n"
 					"	.align 2						\n"
@@ -158,6 +184,11 @@ void vPortStartFirstTask( void )
 					" ldr r0, [r0] 			\n"
 					" ldr r0, [r0] 			\n"
 					" msr msp, r0			\n" /* Set the msp back to the start of the stack. */
+#if portSAVE_FPU_CONTEXT == 1
+					" mov r0, #0			\n" /* Clear the FPU in use bit of CONTROL, the setup code may have used the FPU, */
+					" msr control, r0		\n" /* the SVC would else reserve lazy stacking space on the reset msp. */
+					" isb					\n"
+#endif
 					" cpsie i				\n" /* Globally enable interrupts. */
 					" svc 0					\n" /* System call to start first task. */
 					" nop					\n"
@@ -174,6 +205,11 @@ portBASE_TYPE xPortStartScheduler( void )
 	*(portNVIC_SYSPRI2) |= portNVIC_PENDSV_PRI;
 	*(portNVIC_SYSPRI2) |= portNVIC_SYSTICK_PRI;
 
+	#if portSAVE_FPU_CONTEXT == 1
+		/* Automatic and lazy stacking of the floating point registers on exception entry. */
+		*(portFPCCR) |= portASPEN_AND_LSPEN_BITS;
+	#endif
+
 // !!! Maple
 	systick_attach_callback(&xPortSysTickHandler);
 //	/* Start the timer that generates the tick ISR.  Interrupts are disabled
@@ -237,7 +273,15 @@ void __exc_pendsv( void )
 	"	ldr	r3, pxCurrentTCBConst			\n" /* Get the location of the current TCB. */
 	"	ldr	r2, [r3]						\n"
 	"										\n"
+#if portSAVE_FPU_CONTEXT == 1
+	"	.fpu fpv4-sp-d16					\n" /* libmaple itself is built for the Cortex-M3. */
+	"	tst r14, #0x10						\n" /* Is the task using the FPU context?  If so, push the high vfp registers. */
+	"	it eq								\n"
+	"	vstmdbeq r0!, {s16-s31}				\n"
+	"	stmdb r0!, {r4-r11, r14}			\n" /* Save the remaining registers and the EXC_RETURN value. */
+#else
 	"	stmdb r0!, {r4-r11}					\n" /* Save the remaining registers. */
+#endif
 	"	str r0, [r2]						\n" /* Save the new top of stack into the first member of the TCB. */
 	"										\n"
 	"	stmdb sp!, {r3, r14}				\n"
@@ -250,7 +294,14 @@ void __exc_pendsv( void )
 	"										\n"	/* Restore the context, including the critical nesting count. */
 	"	ldr r1, [r3]						\n"
 	"	ldr r0, [r1]						\n" /* The first item in pxCurrentTCB is the task top of stack. */
+#if portSAVE_FPU_CONTEXT == 1
+	"	ldmia r0!, {r4-r11, r14}			\n" /* Pop the registers and the EXC_RETURN value of the new task. */
+	"	tst r14, #0x10						\n" /* Is the task using the FPU context?  If so, pop the high vfp registers too. */
+	"	it eq								\n"
+	"	vldmiaeq r0!, {s16-s31}				\n"
+#else
 	"	ldmia r0!, {r4-r11}					\n" /* Pop the registers. */
+#endif
 	"	msr psp, r0							\n"
 	"	bx r14								\n"
 	"										\n"
@@ -1063,6 +1063,24 @@ void vTaskList( signed char *pcWriteBuffer ) PRIVILEGED_FUNCTION;
  */
 void vTaskGetRunTimeStats( signed char *pcWriteBuffer ) PRIVILEGED_FUNCTION;
 
+// !!! Maple
+/**
+ * task. h
+ * <PRE>unsigned long ulTaskGetRunTimeCounter( xTaskHandle xTask );</PRE>
+ *
+ * configGENERATE_RUN_TIME_STATS must be defined as 1 for this function
+ * to be available.
+ *
+ * Returns the accumulated execution time of xTask in the units of
+ * portGET_RUN_TIME_COUNTER_VALUE(), without the formatting done by
+ * vTaskGetRunTimeStats().  Set xTask to NULL for the calling task.
+ *
+ * \page ulTaskGetRunTimeCounter ulTaskGetRunTimeCounter
+ * \ingroup TaskUtils
+ */
+unsigned long ulTaskGetRunTimeCounter( xTaskHandle xTask ) PRIVILEGED_FUNCTION;
+// !!! Maple
+
 /**
  * task. h
  * <PRE>void vTaskStartTrace( char * pcBuffer, unsigned portBASE_TYPE uxBufferSize );</PRE>
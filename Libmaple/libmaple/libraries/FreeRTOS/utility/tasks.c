@@ -2332,6 +2332,28 @@ tskTCB *pxNewTCB;
 #endif
 /*-----------------------------------------------------------*/
 
+// !!! Maple
+#if ( configGENERATE_RUN_TIME_STATS == 1 )
+
+	unsigned long ulTaskGetRunTimeCounter( xTaskHandle xTask )
+	{
+	tskTCB *pxTCB;
+	unsigned long ulReturn;
+
+		portENTER_CRITICAL();
+		{
+			pxTCB = prvGetTCBFromHandle( xTask );
+			ulReturn = pxTCB->ulRunTimeCounter;
+		}
+		portEXIT_CRITICAL();
+
+		return ulReturn;
+	}
+
+#endif
+/*-----------------------------------------------------------*/
+// !!! Maple
+
 #if ( INCLUDE_uxTaskGetStackHighWaterMark == 1 )
 
 	unsigned portBASE_TYPE uxTaskGetStackHighWaterMark( xTaskHandle xTask )
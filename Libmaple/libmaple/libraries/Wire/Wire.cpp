@@ -130,8 +130,41 @@ void i2c_shift_out(Port port, uint8 val) {
 
 }
 
+/*
+* Returns the I2C peripheral wired to the given pins, NULL if there is none.
+* F1 only offers the fixed PB7/PB6, PB9/PB8 (remapped) and PB11/PB10 pairs,
+* F2/F4 can combine the I2C1 pins freely through the alternate function mux.
+*/
+static i2c_dev *i2c_dev_for_pins(uint8 sda, uint8 scl, uint32 *flags) {
+	if (sda >= BOARD_NR_GPIO_PINS || scl >= BOARD_NR_GPIO_PINS) return NULL;
+	if (PIN_MAP[sda].gpio_device != GPIOB || PIN_MAP[scl].gpio_device != GPIOB) return NULL;
+
+	uint8 sda_bit = PIN_MAP[sda].gpio_bit;
+	uint8 scl_bit = PIN_MAP[scl].gpio_bit;
+	if (sda_bit == 11 && scl_bit == 10) return I2C2;
+#ifdef STM32F2
+	if ((sda_bit == 7 || sda_bit == 9) && (scl_bit == 6 || scl_bit == 8)) {
+		I2C1->sda_pin = sda_bit;
+		I2C1->scl_pin = scl_bit;
+		return I2C1;
+	}
+#else
+	if (sda_bit == 7 && scl_bit == 6) return I2C1;
+	if (sda_bit == 9 && scl_bit == 8) {
+		*flags |= I2C_REMAP;
+		return I2C1;
+	}
+#endif
+	return NULL;
+}
+
 TwoWire::TwoWire() {
 	i2c_delay = 0;
+	dev = NULL;
+	dev_flags = 0;
+	async_busy = false;
+	async_result = SUCCESS;
+	wait_handler = NULL;
 	rx_buf_idx = 0;
 	rx_buf_len = 0;
 	tx_addr = 0;
@@ -149,11 +182,27 @@ void TwoWire::begin() {
 }
 
 /*
-* Joins I2C bus as master on given SDA and SCL pins.
+* Joins I2C bus as master on given SDA and SCL pins. When the pins belong
+* to an I2C peripheral and useHardware is set, the peripheral does the
+* transfers in fast mode (400 kHz) from its interrupt handler, otherwise
+* the pins are bit-banged.
 */
-void TwoWire::begin(uint8 sda, uint8 scl) {
+void TwoWire::begin(uint8 sda, uint8 scl, boolean useHardware) {
 	port.sda = sda;
 	port.scl = scl;
+	if (dev) {
+		i2c_disable(dev);
+		dev = NULL;
+		async_busy = false;
+	}
+	if (useHardware) {
+		dev_flags = I2C_FAST_MODE | I2C_BUS_RESET;
+		dev = i2c_dev_for_pins(sda, scl, &dev_flags);
+		if (dev) {
+			i2c_master_enable(dev, dev_flags);
+			return;
+		}
+	}
 	pinMode(scl, OUTPUT_OPEN_DRAIN);
 	pinMode(sda, OUTPUT_OPEN_DRAIN);
 	digitalWrite(scl, HIGH);
@@ -183,6 +232,20 @@ void TwoWire::beginTransmission(int slave_address) {
 uint8 TwoWire::endTransmission(void) {
 	if (tx_buf_overflow) return EDATA;
 
+	if (dev) {
+		// the peripheral interrupt handler cannot send an address only write
+		if (tx_buf_idx == 0) return EOTHER;
+
+		i2c_msg msg;
+		msg.addr = tx_addr;
+		msg.flags = 0;
+		msg.length = tx_buf_idx;
+		msg.xferred = 0;
+		msg.data = tx_buf;
+		tx_buf_idx = 0;
+		return hardwareTransfer(&msg);
+	}
+
 	i2c_start(port);
 
 	i2c_shift_out(port, (tx_addr << 1) | I2C_WRITE);
@@ -230,6 +293,21 @@ uint8 TwoWire::requestFrom(uint8 address, int num_bytes) {
 	rx_buf_idx = 0;
 	rx_buf_len = 0;
 
+	if (dev) {
+		if (num_bytes <= 0) return 0;
+
+		i2c_msg msg;
+		msg.addr = address;
+		msg.flags = I2C_MSG_READ;
+		msg.length = num_bytes;
+		msg.xferred = 0;
+		msg.data = rx_buf;
+		if (hardwareTransfer(&msg) == SUCCESS) {
+			rx_buf_len = num_bytes;
+		}
+		return rx_buf_len;
+	}
+
 	i2c_start(port);
 
 	i2c_shift_out(port, (address << 1) | I2C_READ);
@@ -304,6 +382,79 @@ uint8 TwoWire::writeOneByte(uint8 byte) {
 	return SUCCESS;
 }
 
+/*
+* Runs one message on the I2C peripheral. The interrupt handler moves the
+* bytes, the wait handler gets the CPU until the transfer is done. A NACK,
+* bus error or timeout leaves the peripheral in error or busy state, so it
+* is enabled again after clocking out any slave still holding the bus.
+*/
+uint8 TwoWire::hardwareTransfer(i2c_msg *msg) {
+	while (asyncTransferStatus() == WIRE_ASYNC_BUSY) {
+		waitForTransfer();
+	}
+	i2c_master_xfer_start(dev, msg, 1);
+	int32 rc;
+	while ((rc = i2c_master_xfer_status(dev, WIRE_HARDWARE_TIMEOUT)) > 0) {
+		waitForTransfer();
+	}
+	if (rc == 0) {
+		return SUCCESS;
+	}
+	return hardwareError(msg);
+}
+
+void TwoWire::waitForTransfer() {
+	if (wait_handler) {
+		wait_handler();
+	}
+}
+
+uint8 TwoWire::hardwareError(i2c_msg *msg) {
+	uint8 ret = EOTHER;
+	if (dev->state == I2C_STATE_ERROR && (dev->error_flags & I2C_SR1_AF)) {
+		ret = msg->xferred == 0 ? ENACKADDR : ENACKTRNS;
+	}
+	i2c_disable(dev);
+	i2c_master_enable(dev, dev_flags);
+	return ret;
+}
+
+boolean TwoWire::beginAsyncTransfer(uint8 address, const uint8 *txData, uint8 txLength, uint8 *rxData, uint8 rxLength) {
+	if (!dev || async_busy || (txLength == 0 && rxLength == 0)) return false;
+
+	uint16 num = 0;
+	if (txLength) {
+		async_msgs[num].addr = address;
+		async_msgs[num].flags = 0;
+		async_msgs[num].length = txLength;
+		async_msgs[num].xferred = 0;
+		async_msgs[num].data = (uint8*)txData;
+		num++;
+	}
+	if (rxLength) {
+		async_msgs[num].addr = address;
+		async_msgs[num].flags = I2C_MSG_READ;
+		async_msgs[num].length = rxLength;
+		async_msgs[num].xferred = 0;
+		async_msgs[num].data = rxData;
+		num++;
+	}
+	async_busy = true;
+	i2c_master_xfer_start(dev, async_msgs, num);
+	return true;
+}
+
+uint8 TwoWire::asyncTransferStatus() {
+	if (!async_busy) return async_result;
+
+	int32 rc = i2c_master_xfer_status(dev, WIRE_HARDWARE_TIMEOUT);
+	if (rc > 0) return WIRE_ASYNC_BUSY;
+
+	async_busy = false;
+	async_result = rc == 0 ? SUCCESS : hardwareError(dev->msg);
+	return async_result;
+}
+
 uint8 TwoWire::readOneByte(uint8 address, uint8 *byte) {
 	i2c_start(port);
 
@@ -28,6 +28,7 @@
  */
 
 #include "wirish.h"
+#include "i2c.h"
 
 #ifndef _WIRE_H_
 #define _WIRE_H_
@@ -53,6 +54,16 @@ typedef struct {
 #define I2C_WRITE 0
 #define I2C_READ  1
 
+/* begin() uses the I2C peripheral when the pins allow it */
+#define WIRE_HARDWARE_I2C
+
+/* bus idle timeout of a hardware transfer, in milliseconds */
+#define WIRE_HARDWARE_TIMEOUT 2
+
+/* hardware transfers can also run in the background, see I2C_Queue.h */
+#define WIRE_ASYNC_TRANSFER
+#define WIRE_ASYNC_BUSY 0xFF
+
 #if (F_CPU == 168000000)
 	#define I2C_DELAY_SCL delay_ns100(6) 
 	#define I2C_DELAY_SDA delay_ns100(2)
@@ -72,12 +83,22 @@ class TwoWire {
     uint8 tx_buf_idx;               /* next idx available in tx_buf, -1 overflow */
     boolean tx_buf_overflow;
     Port port;
+    i2c_dev *dev;                   /* I2C peripheral, NULL when bit-banged */
+    uint32 dev_flags;               /* i2c_master_enable() flags of dev */
+    i2c_msg async_msgs[2];          /* register write and read of a background transfer */
+    boolean async_busy;
+    uint8 async_result;
+    voidFuncPtr wait_handler;       /* called while a synchronous transfer waits */
     uint8 writeOneByte(uint8);
     uint8 readOneByte(uint8, uint8*);
+    uint8 hardwareTransfer(i2c_msg*);
+    uint8 hardwareError(i2c_msg*);
+    void waitForTransfer();
  public:
     TwoWire();
     void begin();
-    void begin(uint8, uint8);
+    void begin(uint8, uint8, boolean useHardware = true);
+    boolean isHardware() { return dev != NULL; };
     void beginTransmission(uint8);
     void beginTransmission(int);
     uint8 endTransmission(void);
@@ -91,6 +112,22 @@ class TwoWire {
     uint8 available();
     uint8 receive();
 
+    /*
+     * Starts a register write and/or read (repeated start in between) on
+     * the I2C peripheral and returns at once, false when Wire is
+     * bit-banged. asyncTransferStatus() returns WIRE_ASYNC_BUSY until the
+     * transfer is done, then its endTransmission() style result.
+     */
+    boolean beginAsyncTransfer(uint8 address, const uint8 *txData, uint8 txLength, uint8 *rxData, uint8 rxLength);
+    uint8 asyncTransferStatus();
+
+    /*
+     * endTransmission() and requestFrom() on the I2C peripheral call
+     * handler over and over until the transfer is done, e.g. to block the
+     * calling RTOS task so the CPU runs other work meanwhile. NULL polls.
+     */
+    void onWait(voidFuncPtr handler) { wait_handler = handler; };
+
     uint8 read() { return receive(); };
     void write(uint8 data) { send(data); };
     void write(uint8* buf, int len) { send(buf, len); };
@@ -195,6 +195,12 @@ public:
      */
     uint8 nssPin(void);
 
+    /**
+     * @brief Get a pointer to the underlying libmaple spi_dev for
+     *        this HardwareSPI instance.
+     */
+    spi_dev* c_dev(void) { return this->spi_d; }
+
     /* -- The following methods are deprecated --------------------------- */
 
     /**
@@ -140,10 +140,40 @@ uint32 HardwareSerial::pending(void) {
     return usart_data_pending(usart_device);
 }
 
+uint32 HardwareSerial::lastReceiveTime(void) {
+    return usart_rx_time(usart_device);
+}
+
+void HardwareSerial::attachRxInterrupt(voidFuncPtr handler) {
+    usart_attach_rx_handler(usart_device, handler);
+}
+
+uint32 HardwareSerial::availableForWrite(void) {
+    return usart_tx_space(usart_device);
+}
+
 void HardwareSerial::write(unsigned char ch) {
     usart_putc(usart_device, ch);
 }
 
+/* Queues the whole buffer in one pass, waits only while the TX buffer is full */
+void HardwareSerial::write(const void *buf, uint32 len) {
+    const uint8 *bytes = (const uint8 *)buf;
+    uint32 txed = usart_tx(usart_device, bytes, len);
+    if (txed < len) {
+        usart_device->tx_overflows++;
+    }
+    while (txed < len) {
+        bytes += txed;
+        len -= txed;
+        txed = usart_tx(usart_device, bytes, len);
+    }
+}
+
+uint32 HardwareSerial::txOverflows(void) {
+    return usart_tx_overflows(usart_device);
+}
+
 void HardwareSerial::flush(void) {
     usart_reset_rx(usart_device);
 }
@@ -60,9 +60,14 @@ public:
     /* I/O */
     uint32 available(void);
     uint32 pending(void);
+    uint32 lastReceiveTime(void);
+    void attachRxInterrupt(voidFuncPtr handler);
+    uint32 availableForWrite(void);
+    uint32 txOverflows(void);
     int read(void);
     void flush(void);
     virtual void write(unsigned char);
+    virtual void write(const void *buf, uint32 len);
     using Print::write;
 
     /* Pin accessors */
@@ -31,7 +31,7 @@ float runTimeAccelBias[3] = {0, 0, 0};
 float accelOneG = 0.0;
 float meterPerSecSec[3] = {0.0,0.0,0.0};
 long accelSample[3] = {0,0,0};
-byte accelSampleCount = 0;
+unsigned int accelSampleCount = 0; // a MPU6000 batch adds up to several hundred samples
   
 void initializeAccel();
 void measureAccel();
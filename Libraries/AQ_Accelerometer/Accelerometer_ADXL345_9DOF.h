@@ -26,6 +26,38 @@
 
 #define ACCEL_ADDRESS 0x53
 
+#ifdef I2C_QUEUE
+  #include <I2C_Queue.h>
+
+  // the output registers are read in the background, measureAccelSum() adds the previous read
+  byte accelI2CData[6];
+  byte accelI2CIndex = 0;
+  struct I2CTransaction accelI2CRead = {ACCEL_ADDRESS, I2C_PRIORITY_HIGH, 1, {0x32}, sizeof(accelI2CData), accelI2CData, NULL};
+
+  int readAccelShortI2C() {
+    int value = (signed short)(accelI2CData[accelI2CIndex] | (accelI2CData[accelI2CIndex + 1] << 8));
+    accelI2CIndex += 2;
+    return value;
+  }
+
+  // blocking read of the output registers
+  void readAccelI2C() {
+    waitI2CTransaction(&accelI2CRead);
+    queueI2CTransaction(&accelI2CRead);
+    waitI2CTransaction(&accelI2CRead);
+    accelI2CIndex = 0;
+  }
+#else
+  int readAccelShortI2C() {
+    return readReverseShortI2C();
+  }
+
+  void readAccelI2C() {
+    sendByteI2C(ACCEL_ADDRESS, 0x32);
+    Wire.requestFrom(ACCEL_ADDRESS, 6);
+  }
+#endif
+
 void initializeAccel() {
 
   if (readWhoI2C(ACCEL_ADDRESS) ==  0xE5) { 		// page 14 of datasheet
@@ -40,23 +72,36 @@ void initializeAccel() {
   
 void measureAccel() {
 
-  sendByteI2C(ACCEL_ADDRESS, 0x32);
-  Wire.requestFrom(ACCEL_ADDRESS, 6);
+  readAccelI2C();
 
-  meterPerSecSec[YAXIS] = readReverseShortI2C() * accelScaleFactor[YAXIS] + runTimeAccelBias[YAXIS];
-  meterPerSecSec[XAXIS] = readReverseShortI2C() * accelScaleFactor[XAXIS] + runTimeAccelBias[XAXIS];
-  meterPerSecSec[ZAXIS] = readReverseShortI2C() * accelScaleFactor[ZAXIS] + runTimeAccelBias[ZAXIS];
+  meterPerSecSec[YAXIS] = readAccelShortI2C() * accelScaleFactor[YAXIS] + runTimeAccelBias[YAXIS];
+  meterPerSecSec[XAXIS] = readAccelShortI2C() * accelScaleFactor[XAXIS] + runTimeAccelBias[XAXIS];
+  meterPerSecSec[ZAXIS] = readAccelShortI2C() * accelScaleFactor[ZAXIS] + runTimeAccelBias[ZAXIS];
 }
 
 void measureAccelSum() {
 
-  sendByteI2C(ACCEL_ADDRESS, 0x32);
-  Wire.requestFrom(ACCEL_ADDRESS, 6);
+  #ifdef I2C_QUEUE
+    processI2CQueue();
+    if (isI2CTransactionPending(&accelI2CRead)) {
+      return; // previous read still on the bus
+    }
+    if (accelI2CRead.status != I2C_DONE) {
+      queueI2CTransaction(&accelI2CRead); // first read, or the previous one failed
+      return;
+    }
+    accelI2CIndex = 0;
+  #else
+    readAccelI2C();
+  #endif
   
-  accelSample[YAXIS] += readReverseShortI2C() ;
-  accelSample[XAXIS] += readReverseShortI2C() ;
-  accelSample[ZAXIS] += readReverseShortI2C() ;
+  accelSample[YAXIS] += readAccelShortI2C() ;
+  accelSample[XAXIS] += readAccelShortI2C() ;
+  accelSample[ZAXIS] += readAccelShortI2C() ;
   accelSampleCount++;
+  #ifdef I2C_QUEUE
+    queueI2CTransaction(&accelI2CRead);
+  #endif
 }
 
 void evaluateMetersPerSec() {
@@ -70,7 +115,13 @@ void evaluateMetersPerSec() {
 
 void computeAccelBias() {
   
+  #ifdef I2C_QUEUE
+    readAccelI2C(); // each measureAccelSum() adds the read before it
+  #endif
   for (int samples = 0; samples < SAMPLECOUNT; samples++) {
+    #ifdef I2C_QUEUE
+      waitI2CTransaction(&accelI2CRead);
+    #endif
     measureAccelSum();
     delayMicroseconds(2500);
   }
@@ -39,14 +39,24 @@ void measureAccel() {
 
 void measureAccelSum() {
   readMPU6000Accel();
-  accelSample[XAXIS] += MPU6000.data.accel.x;
-  accelSample[YAXIS] += MPU6000.data.accel.y;
-  accelSample[ZAXIS] += MPU6000.data.accel.z;
-
-  accelSampleCount++;
+  #ifdef MPU6000_BATCH
+    for (byte axis = XAXIS; axis <= ZAXIS; axis++) {
+      accelSample[axis] += MPU6000Batch.accel[axis];
+    }
+    accelSampleCount += MPU6000Batch.count;
+  #else
+    accelSample[XAXIS] += MPU6000.data.accel.x;
+    accelSample[YAXIS] += MPU6000.data.accel.y;
+    accelSample[ZAXIS] += MPU6000.data.accel.z;
+
+    accelSampleCount++;
+  #endif
 }
 
 void evaluateMetersPerSec() {
+  if (accelSampleCount == 0) {
+    return; // empty batch, e.g. after a FIFO overflow, keep the last value
+  }
   for (byte axis = XAXIS; axis <= ZAXIS; axis++) {
     meterPerSecSec[axis] = (accelSample[axis] / accelSampleCount) * accelScaleFactor[axis] + runTimeAccelBias[axis];
   	accelSample[axis] = 0;
@@ -57,7 +67,9 @@ void evaluateMetersPerSec() {
 void computeAccelBias() {
   for (int samples = 0; samples < SAMPLECOUNT; samples++) {
 	readMPU6000Sensors();
-    measureAccelSum();
+    accelSample[XAXIS] += MPU6000.data.accel.x;
+    accelSample[YAXIS] += MPU6000.data.accel.y;
+    accelSample[ZAXIS] += MPU6000.data.accel.z;
     delayMicroseconds(2500);
   }
 
@@ -47,9 +47,44 @@ float pressureFactor = 1/5.255;
 boolean isReadPressure = false;
 float rawPressureSum = 0;
 byte rawPressureSumCount = 0;
+
+#ifdef I2C_QUEUE
+  #include <I2C_Queue.h>
+
+  // conversions are read and started in the background, the result is used by BMP085ConversionDone()
+  void BMP085ConversionDone(struct I2CTransaction *transaction);
+
+  byte BMP085ConversionData[3]; // a temperature uses the first two bytes
+  byte BMP085ConversionType = TEMPERATURE;
+  struct I2CTransaction BMP085ConversionRead = {BMP085_I2C_ADDRESS, I2C_PRIORITY_LOW, 1, {0xF6}, sizeof(BMP085ConversionData), BMP085ConversionData, BMP085ConversionDone};
+  struct I2CTransaction BMP085Command = {BMP085_I2C_ADDRESS, I2C_PRIORITY_LOW, 2, {0xF4, 0}, 0, NULL, NULL};
+
+  void BMP085ConversionDone(struct I2CTransaction *transaction) {
+    if (transaction->status != I2C_DONE) {
+      return; // keep the last temperature, leave the sample out of the altitude average
+    }
+    if (BMP085ConversionType == PRESSURE) {
+      rawPressureSum += (((unsigned long)BMP085ConversionData[0] << 16) | ((unsigned long)BMP085ConversionData[1] << 8) | BMP085ConversionData[2]) >> (8-overSamplingSetting);
+      rawPressureSumCount++;
+    }
+    else {
+      rawTemperature = ((unsigned int)BMP085ConversionData[0] << 8) | BMP085ConversionData[1];
+    }
+  }
+
+  void BMP085queueConversionRead(byte conversionType) {
+    BMP085ConversionType = conversionType;
+    queueI2CTransaction(&BMP085ConversionRead);
+  }
+#endif
   
 void requestRawPressure() {
-  updateRegisterI2C(BMP085_I2C_ADDRESS, 0xF4, 0x34+(overSamplingSetting<<6));
+  #ifdef I2C_QUEUE
+    BMP085Command.txData[1] = 0x34+(overSamplingSetting<<6);
+    queueI2CTransaction(&BMP085Command);
+  #else
+    updateRegisterI2C(BMP085_I2C_ADDRESS, 0xF4, 0x34+(overSamplingSetting<<6));
+  #endif
 }
   
 long readRawPressure() {
@@ -59,7 +94,12 @@ long readRawPressure() {
 }
 
 void requestRawTemperature() {
-  updateRegisterI2C(BMP085_I2C_ADDRESS, 0xF4, 0x2E);
+  #ifdef I2C_QUEUE
+    BMP085Command.txData[1] = 0x2E;
+    queueI2CTransaction(&BMP085Command);
+  #else
+    updateRegisterI2C(BMP085_I2C_ADDRESS, 0xF4, 0x2E);
+  #endif
 }
   
 unsigned int readRawTemperature() {
@@ -117,15 +157,28 @@ void initializeBaro() {
   
 void measureBaro() {
   measureBaroSum();
+  #ifdef I2C_QUEUE
+    waitI2CTransaction(&BMP085Command); // the caller needs the new altitude
+  #endif
   evaluateBaroAltitude();
 }
 
 void measureBaroSum() {
+  #ifdef I2C_QUEUE
+    processI2CQueue();
+    if (isI2CTransactionPending(&BMP085Command)) {
+      return; // previous read and command still on the bus
+    }
+  #endif
   // switch between pressure and temperature measurements
   // each loop, since it is slow to measure pressure
   if (isReadPressure) {
-    rawPressureSum += readRawPressure();
-    rawPressureSumCount++;
+    #ifdef I2C_QUEUE
+      BMP085queueConversionRead(PRESSURE);
+    #else
+      rawPressureSum += readRawPressure();
+      rawPressureSumCount++;
+    #endif
     if (pressureCount == 4) {
       requestRawTemperature();
       pressureCount = 0;
@@ -137,7 +190,11 @@ void measureBaroSum() {
     pressureCount++;
   } 
   else { // select must equal TEMPERATURE
-    rawTemperature = (long)readRawTemperature();
+    #ifdef I2C_QUEUE
+      BMP085queueConversionRead(TEMPERATURE);
+    #else
+      rawTemperature = (long)readRawTemperature();
+    #endif
     requestRawPressure();
     isReadPressure = true;
   }
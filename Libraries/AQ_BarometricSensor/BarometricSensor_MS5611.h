@@ -142,15 +142,40 @@ unsigned long MS5611readConversion(int addr) {
 }
 
 
+#ifdef I2C_QUEUE
+  #include <I2C_Queue.h>
+
+  // conversions are read and started in the background, the result is used by MS5611ConversionDone()
+  #define MS5611_CONVERSION_TEMPERATURE 0
+  #define MS5611_CONVERSION_PRESSURE    1
+
+  void MS5611ConversionDone(struct I2CTransaction *transaction);
+
+  byte MS5611ConversionData[MS561101BA_D1D2_SIZE];
+  byte MS5611ConversionType = MS5611_CONVERSION_TEMPERATURE;
+  struct I2CTransaction MS5611ConversionRead = {MS5611_I2C_ADDRESS, I2C_PRIORITY_LOW, 1, {0}, MS561101BA_D1D2_SIZE, MS5611ConversionData, MS5611ConversionDone};
+  struct I2CTransaction MS5611Command = {MS5611_I2C_ADDRESS, I2C_PRIORITY_LOW, 1, {0}, 0, NULL, NULL};
+
+  void MS5611queueConversionRead(byte conversionType) {
+    MS5611ConversionType = conversionType;
+    queueI2CTransaction(&MS5611ConversionRead);
+  }
+#endif
+
 void requestRawTemperature() {
-  sendByteI2C(MS5611_I2C_ADDRESS, MS561101BA_D2_Temperature + MS561101BA_OSR_4096);
+  #ifdef I2C_QUEUE
+    MS5611Command.txData[0] = MS561101BA_D2_Temperature + MS561101BA_OSR_4096;
+    queueI2CTransaction(&MS5611Command);
+  #else
+    sendByteI2C(MS5611_I2C_ADDRESS, MS561101BA_D2_Temperature + MS561101BA_OSR_4096);
+  #endif
 }
 
 
-unsigned long readRawTemperature()
+unsigned long evaluateRawTemperature(unsigned long conversion)
 {
   // see datasheet page 7 for formulas
-  MS5611lastRawTemperature = MS5611readConversion(MS5611_I2C_ADDRESS);
+  MS5611lastRawTemperature = conversion;
   int64_t dT     = MS5611lastRawTemperature - (((long)MS5611Prom[5]) << 8);
   MS5611_offset  = (((int64_t)MS5611Prom[2]) << 16) + ((MS5611Prom[4] * dT) >> 7);
   MS5611_sens    = (((int64_t)MS5611Prom[1]) << 15) + ((MS5611Prom[3] * dT) >> 8);
@@ -158,6 +183,11 @@ unsigned long readRawTemperature()
   return MS5611lastRawTemperature;
 }
 
+unsigned long readRawTemperature()
+{
+  return evaluateRawTemperature(MS5611readConversion(MS5611_I2C_ADDRESS));
+}
+
 
 float readTemperature()
 {
@@ -166,16 +196,42 @@ float readTemperature()
 
 void requestRawPressure()
 {
-  sendByteI2C(MS5611_I2C_ADDRESS, MS561101BA_D1_Pressure + MS561101BA_OSR_4096);
+  #ifdef I2C_QUEUE
+    MS5611Command.txData[0] = MS561101BA_D1_Pressure + MS561101BA_OSR_4096;
+    queueI2CTransaction(&MS5611Command);
+  #else
+    sendByteI2C(MS5611_I2C_ADDRESS, MS561101BA_D1_Pressure + MS561101BA_OSR_4096);
+  #endif
 }
 
-float readRawPressure()
+float evaluateRawPressure(unsigned long conversion)
 {
-  MS5611lastRawPressure = MS5611readConversion(MS5611_I2C_ADDRESS);
+  MS5611lastRawPressure = conversion;
 
   return (((( MS5611lastRawPressure * MS5611_sens) >> 21) - MS5611_offset) >> (15-5)) / ((float)(1<<5));
 }
 
+float readRawPressure()
+{
+  return evaluateRawPressure(MS5611readConversion(MS5611_I2C_ADDRESS));
+}
+
+#ifdef I2C_QUEUE
+  void MS5611ConversionDone(struct I2CTransaction *transaction) {
+    if (transaction->status != I2C_DONE) {
+      return; // keep the last temperature, leave the sample out of the altitude average
+    }
+    unsigned long conversion = ((unsigned long)MS5611ConversionData[0] << 16) | (MS5611ConversionData[1] << 8) | MS5611ConversionData[2];
+    if (MS5611ConversionType == MS5611_CONVERSION_PRESSURE) {
+      rawPressureSum += evaluateRawPressure(conversion);
+      rawPressureSumCount++;
+    }
+    else {
+      evaluateRawTemperature(conversion);
+    }
+  }
+#endif
+
 bool baroGroundUpdateDone = false;
 unsigned long baroStartTime;
 
@@ -210,14 +266,27 @@ void initializeBaro() {
 
 void measureBaro() {
   measureBaroSum();
+  #ifdef I2C_QUEUE
+    waitI2CTransaction(&MS5611Command); // the caller needs the new altitude
+  #endif
   evaluateBaroAltitude();
 }
 
 void measureBaroSum() {
+  #ifdef I2C_QUEUE
+    processI2CQueue();
+    if (isI2CTransactionPending(&MS5611Command)) {
+      return; // previous read and command still on the bus
+    }
+  #endif
   // switch between pressure and temperature measurements
   if (isReadPressure) {
-    rawPressureSum += readRawPressure();
-    rawPressureSumCount++;
+    #ifdef I2C_QUEUE
+      MS5611queueConversionRead(MS5611_CONVERSION_PRESSURE);
+    #else
+      rawPressureSum += readRawPressure();
+      rawPressureSumCount++;
+    #endif
     if (pressureCount == 20) {
       requestRawTemperature();
       pressureCount = 0;
@@ -229,7 +298,11 @@ void measureBaroSum() {
     pressureCount++;
   } 
   else { // select must equal TEMPERATURE
-    readRawTemperature();
+    #ifdef I2C_QUEUE
+      MS5611queueConversionRead(MS5611_CONVERSION_TEMPERATURE);
+    #else
+      readRawTemperature();
+    #endif
     requestRawPressure();
     isReadPressure = true;
   }
@@ -23,6 +23,7 @@
 #define _AEROQUAD_COMPASS_H_
 
 #include "Arduino.h"
+#include <FastTrigonometry.h>
 
 float hdgX = 0.0;
 float hdgY = 0.0;
@@ -55,7 +56,7 @@ const int getMagnetometerData(byte axis) {
 
 
 const float getAbsoluteHeading() {
-  float heading = atan2(hdgY, hdgX);
+  float heading = fastAtan2(hdgY, hdgX);
   if (heading < 0) {
 	heading += radians(360);
   }
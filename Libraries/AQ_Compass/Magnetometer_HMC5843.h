@@ -30,9 +30,9 @@
 
 void readSpecificMag(float *rawMag) {
 
-  rawMag[XAXIS] =  readShortI2C();
-  rawMag[YAXIS] = -readShortI2C();
-  rawMag[ZAXIS] = -readShortI2C();
+  rawMag[XAXIS] =  readMagShortI2C();
+  rawMag[YAXIS] = -readMagShortI2C();
+  rawMag[ZAXIS] = -readMagShortI2C();
 }
 
 #endif
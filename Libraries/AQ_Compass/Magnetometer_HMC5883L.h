@@ -35,20 +35,20 @@ void readSpecificMag(float *rawMag) {
     // JI - 11/24/11 - SparkFun DOF on v2p1 Shield Configuration
     // JI - 11/24/11 - 5883L X axis points aft
     // JI - 11/24/11 - 5883L Sensor Orientation 3
-    rawMag[XAXIS] = -readShortI2C();
-    rawMag[ZAXIS] = -readShortI2C();
-    rawMag[YAXIS] =  readShortI2C();
+    rawMag[XAXIS] = -readMagShortI2C();
+    rawMag[ZAXIS] = -readMagShortI2C();
+    rawMag[YAXIS] =  readMagShortI2C();
   #elif defined(SPARKFUN_5883L_BOB)
     // JI - 11/24/11 - Sparkfun 5883L Breakout Board Upside Down on v2p0 shield
     // JI - 11/24/11 - 5883L is upside down, X axis points forward
     // JI - 11/24/11 - 5883L Sensor Orientation 5
-    rawMag[XAXIS] = readShortI2C();
-    rawMag[ZAXIS] = readShortI2C();
-    rawMag[YAXIS] = readShortI2C();
+    rawMag[XAXIS] = readMagShortI2C();
+    rawMag[ZAXIS] = readMagShortI2C();
+    rawMag[YAXIS] = readMagShortI2C();
   #elif defined (HMC5883L)  // baloo
-    rawMag[YAXIS] =  readShortI2C();
-    rawMag[ZAXIS] = -readShortI2C();
-    rawMag[XAXIS] =  readShortI2C();
+    rawMag[YAXIS] =  readMagShortI2C();
+    rawMag[ZAXIS] = -readMagShortI2C();
+    rawMag[XAXIS] =  readMagShortI2C();
   #else 
     #error Define HMC5883L Orientation
   #endif
@@ -39,6 +39,26 @@
 //#define SENSOR_GAIN 0xC0  // +/- 4.5 Ga
 //#define SENSOR_GAIN 0xE0  // +/- 6.5 Ga (not recommended)
 
+#ifdef I2C_QUEUE
+  #include <I2C_Queue.h>
+
+  // the output registers are read in the background, measureMagnetometer() uses the previous read
+  byte magI2CData[6];
+  byte magI2CIndex = 0;
+  struct I2CTransaction magI2CRead = {COMPASS_ADDRESS, I2C_PRIORITY_LOW, 1, {0x03}, sizeof(magI2CData), magI2CData, NULL};
+  struct I2CTransaction magI2CStartConversion = {COMPASS_ADDRESS, I2C_PRIORITY_LOW, 2, {0x02, 0x01}, 0, NULL, NULL};
+
+  int readMagShortI2C() {
+    int value = (signed short)((magI2CData[magI2CIndex] << 8) | magI2CData[magI2CIndex + 1]);
+    magI2CIndex += 2;
+    return value;
+  }
+#else
+  int readMagShortI2C() {
+    return readShortI2C();
+  }
+#endif
+
 void readSpecificMag(float *rawMag);
 
 
@@ -55,17 +75,30 @@ void initializeMagnetometer() {
   updateRegisterI2C(COMPASS_ADDRESS, 0x02, 0x01); // start single conversion
   delay(20);
 
+  #ifdef I2C_QUEUE
+    queueI2CTransaction(&magI2CRead);
+    waitI2CTransaction(&magI2CRead);
+  #endif
   measureMagnetometer(0.0, 0.0);  // Assume 1st measurement at 0 degrees roll and 0 degrees pitch
 }
 
 void measureMagnetometer(float roll, float pitch) {
     
-  sendByteI2C(COMPASS_ADDRESS, 0x03);
-  Wire.requestFrom(COMPASS_ADDRESS, 6);
-
-  readSpecificMag(rawMag);
-
-  updateRegisterI2C(COMPASS_ADDRESS, 0x02, 0x01); // start single conversion
+  #ifdef I2C_QUEUE
+    if (!isI2CTransactionPending(&magI2CRead)) {
+      magI2CIndex = 0;
+      readSpecificMag(rawMag);
+      queueI2CTransaction(&magI2CRead);
+      queueI2CTransaction(&magI2CStartConversion);
+    }
+  #else
+    sendByteI2C(COMPASS_ADDRESS, 0x03);
+    Wire.requestFrom(COMPASS_ADDRESS, 6);
+
+    readSpecificMag(rawMag);
+
+    updateRegisterI2C(COMPASS_ADDRESS, 0x02, 0x01); // start single conversion
+  #endif
 
   measuredMagX = rawMag[XAXIS] + magBias[XAXIS];
   measuredMagY = rawMag[YAXIS] + magBias[YAXIS];
@@ -75,10 +108,10 @@ void measureMagnetometer(float roll, float pitch) {
   measuredMag[YAXIS] = measuredMagY;
   measuredMag[ZAXIS] = measuredMagZ;
   
-  const float cosRoll =  cos(roll);
-  const float sinRoll =  sin(roll);
-  const float cosPitch = cos(pitch);
-  const float sinPitch = sin(pitch);
+  const float cosRoll =  fastCos(roll);
+  const float sinRoll =  fastSin(roll);
+  const float cosPitch = fastCos(pitch);
+  const float sinPitch = fastSin(pitch);
 
   const float magX = (float)measuredMagX * cosPitch + 
                      (float)measuredMagY * sinRoll * sinPitch + 
@@ -87,7 +120,7 @@ void measureMagnetometer(float roll, float pitch) {
   const float magY = (float)measuredMagY * cosRoll - 
                      (float)measuredMagZ * sinRoll;
 
-  const float tmp  = sqrt(magX * magX + magY * magY);
+  const float tmp  = fastSqrt(magX * magX + magY * magY);
    
   hdgX = magX / tmp;
   hdgY = -magY / tmp;
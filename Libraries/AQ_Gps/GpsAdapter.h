@@ -183,9 +183,11 @@ void updateGps() {
          gpsData.state = GPS_NOFIX; // make sure to lose detecting state (state may not have been updated by parser)
       }
       gpsData.idlecount=0;
+      RTOS_LOCK(); // the navigation must not see half of a new position
       currentPosition.latitude=gpsData.lat;
       currentPosition.longitude=gpsData.lon;
       currentPosition.altitude=gpsData.height;
+      RTOS_UNLOCK();
     }
   }
 
@@ -32,7 +32,48 @@ long  gyroSample[3] = {0,0,0};
 float gyroScaleFactor = 0.0;
 float gyroHeading = 0.0;
 unsigned long gyroLastMesuredTime = 0;
-byte gyroSampleCount = 0;
+unsigned int gyroSampleCount = 0; // a MPU6000 batch adds up to several hundred samples
+
+// Zero calibration of the three axes from the same samples. The zero is the mean of the
+// samples, the calibration fails at the first sample that spreads an axis (max - min)
+// over the threshold, so a moving craft doesn't cost the whole sampling time per attempt.
+long gyroCalibrationSum[3];
+int  gyroCalibrationMin[3];
+int  gyroCalibrationMax[3];
+byte gyroCalibrationSamples = 0;
+
+void startGyroCalibration() {
+  gyroCalibrationSamples = 0;
+}
+
+boolean addGyroCalibrationSample(int *sample, int threshold) {
+  for (byte axis = XAXIS; axis <= ZAXIS; axis++) {
+    if (gyroCalibrationSamples == 0) {
+      gyroCalibrationSum[axis] = 0;
+      gyroCalibrationMin[axis] = sample[axis];
+      gyroCalibrationMax[axis] = sample[axis];
+    }
+    else if (sample[axis] < gyroCalibrationMin[axis]) {
+      gyroCalibrationMin[axis] = sample[axis];
+    }
+    else if (sample[axis] > gyroCalibrationMax[axis]) {
+      gyroCalibrationMax[axis] = sample[axis];
+    }
+    if (gyroCalibrationMax[axis] - gyroCalibrationMin[axis] > threshold) {
+      return false; // craft moved
+    }
+    gyroCalibrationSum[axis] += sample[axis];
+  }
+  gyroCalibrationSamples++;
+  return true;
+}
+
+void finishGyroCalibration() {
+  for (byte axis = XAXIS; axis <= ZAXIS; axis++) {
+    long sum = gyroCalibrationSum[axis];
+    gyroZero[axis] = (sum + (sum < 0 ? -gyroCalibrationSamples : gyroCalibrationSamples) / 2) / gyroCalibrationSamples;
+  }
+}
 
 void measureGyroSum();
 void evaluateGyroRate();
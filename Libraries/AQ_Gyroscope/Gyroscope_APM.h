@@ -86,22 +86,19 @@ void evaluateGyroRate() {
 
 boolean calibrateGyro() {
   
-  int findZero[FINDZERO];
-  int diff = 0; 
-  for (byte axis = 0; axis < 3; axis++) {
-    for (int i=0; i<FINDZERO; i++) {
-	  evaluateADC();
-      findZero[i] = readADC(axis);
-      delay(10);
+  int sample[3];
+  startGyroCalibration();
+  for (int i=0; i<FINDZERO; i++) {
+    evaluateADC();
+    for (byte axis = 0; axis < 3; axis++) {
+      sample[axis] = readADC(axis);
     }
-    int tmp = findMedianIntWithDiff(findZero, FINDZERO, &diff);
-	if (diff <= GYRO_CALIBRATION_TRESHOLD) { // 4 = 0.27826087 degrees during 49*10ms measurements (490ms). 0.57deg/s difference between first and last.
-	  gyroZero[axis] = tmp;
-	} 
-	else {
-		return false; //Calibration failed.
-	}
+    if (!addGyroCalibrationSample(sample, GYRO_CALIBRATION_TRESHOLD)) {
+      return false; //Calibration failed.
+    }
+    delay(10);
   }
+  finishGyroCalibration();
   return true;
 }
 
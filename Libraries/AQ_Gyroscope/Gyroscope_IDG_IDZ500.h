@@ -80,25 +80,22 @@ void evaluateGyroRate() {
 }
 
 boolean calibrateGyro() {
-  int findZero[FINDZERO];
+  int sample[3];
   digitalWrite(AZPIN, HIGH);
   delayMicroseconds(750);
   digitalWrite(AZPIN, LOW);
   delay(8);
 
-  int diff = 0;
-  for (byte calAxis = XAXIS; calAxis <= ZAXIS; calAxis++) {
-    for (int i=0; i<FINDZERO; i++) {
-      findZero[i] = analogRead(gyroChannel[calAxis]);
-	}
-	int tmp = findMedianIntWithDiff(findZero, FINDZERO, &diff);
-	if (diff <= GYRO_CALIBRATION_TRESHOLD) { // 4 = 0.27826087 degrees during 49*10ms measurements (490ms). 0.57deg/s difference between first and last.
-	  gyroZero[calAxis] = tmp;
-	} 
-	else {
-		return false; //Calibration failed.
-	}
+  startGyroCalibration();
+  for (int i=0; i<FINDZERO; i++) {
+    for (byte calAxis = XAXIS; calAxis <= ZAXIS; calAxis++) {
+      sample[calAxis] = analogRead(gyroChannel[calAxis]);
+    }
+    if (!addGyroCalibrationSample(sample, GYRO_CALIBRATION_TRESHOLD)) {
+      return false; //Calibration failed.
+    }
   }
+  finishGyroCalibration();
   
   return true;
 }
@@ -27,15 +27,15 @@
 
 void measureSpecificGyroADC(int *gyroADC) {
 
-  gyroADC[XAXIS] = readShortI2C()  - gyroZero[XAXIS];
-  gyroADC[YAXIS] = gyroZero[YAXIS] - readShortI2C();
-  gyroADC[ZAXIS] = gyroZero[ZAXIS] - readShortI2C();
+  gyroADC[XAXIS] = readGyroShortI2C()  - gyroZero[XAXIS];
+  gyroADC[YAXIS] = gyroZero[YAXIS] - readGyroShortI2C();
+  gyroADC[ZAXIS] = gyroZero[ZAXIS] - readGyroShortI2C();
 }
 
 void measureSpecificGyroSum() {
 
   for (byte axis = XAXIS; axis <= ZAXIS; axis++) {
-    gyroSample[axis] += readShortI2C();
+    gyroSample[axis] += readGyroShortI2C();
   }
 }
 
@@ -50,24 +50,20 @@ boolean calibrateGyro() {
   //Finds gyro drift.
   //Returns false if during calibration there was movement of board. 
 
-  int findZero[FINDZERO];
-  int diff = 0;
-
-  for (byte axis = 0; axis < 3; axis++) {
-    for (int i=0; i<FINDZERO; i++) {
-      sendByteI2C(ITG3200_ADDRESS, (axis * 2) + ITG3200_MEMORY_ADDRESS);
-      findZero[i] = readShortI2C(ITG3200_ADDRESS);
-      delay(10);
+  int sample[3];
+  startGyroCalibration();
+  for (int i=0; i<FINDZERO; i++) {
+    readGyroI2C();
+    for (byte axis = 0; axis < 3; axis++) {
+      sample[axis] = readGyroShortI2C();
     }
-
-    int tmp = findMedianIntWithDiff(findZero, FINDZERO, &diff);
-	if (diff <= GYRO_CALIBRATION_TRESHOLD) { // 4 = 0.27826087 degrees during 49*10ms measurements (490ms). 0.57deg/s difference between first and last.
-	  gyroZero[axis] = tmp;
-	} 
-	else {
-		return false; //Calibration failed.
-	}
+    // 4 = 0.27826087 degrees during 49*10ms measurements (490ms). 0.57deg/s difference between first and last.
+    if (!addGyroCalibrationSample(sample, GYRO_CALIBRATION_TRESHOLD)) {
+      return false; //Calibration failed.
+    }
+    delay(10);
   }
+  finishGyroCalibration();
 
   return true; //Calibration successfull.
 }
@@ -46,6 +46,39 @@
 
 
 float gyroTempBias[3] = {0.0,0.0,0.0};
+
+#ifdef I2C_QUEUE
+  #include <I2C_Queue.h>
+
+  // the rate registers are read in the background, measureGyroSum() adds the previous read
+  byte gyroI2CData[ITG3200_BUFFER_SIZE];
+  byte gyroI2CIndex = 0;
+  struct I2CTransaction gyroI2CRead = {ITG3200_ADDRESS, I2C_PRIORITY_HIGH, 1, {ITG3200_MEMORY_ADDRESS}, ITG3200_BUFFER_SIZE, gyroI2CData, NULL};
+
+  int readGyroShortI2C() {
+    int value = (signed short)((gyroI2CData[gyroI2CIndex] << 8) | gyroI2CData[gyroI2CIndex + 1]);
+    gyroI2CIndex += 2;
+    return value;
+  }
+
+  // blocking read of the rate registers for the init and calibration code
+  void readGyroI2C() {
+    waitI2CTransaction(&gyroI2CRead);
+    queueI2CTransaction(&gyroI2CRead);
+    waitI2CTransaction(&gyroI2CRead);
+    gyroI2CIndex = 0;
+  }
+#else
+  int readGyroShortI2C() {
+    return readShortI2C();
+  }
+
+  void readGyroI2C() {
+    sendByteI2C(ITG3200_ADDRESS, ITG3200_MEMORY_ADDRESS);
+    Wire.requestFrom(ITG3200_ADDRESS, ITG3200_BUFFER_SIZE);
+  }
+#endif
+
 void measureSpecificGyroADC(int *gyroADC);
 void measureSpecificGyroSum();
 void evaluateSpecificGyroRate(int *gyroADC);
@@ -62,8 +95,7 @@ void initializeGyro() {
 }
 
 void measureGyro() {
-  sendByteI2C(ITG3200_ADDRESS, ITG3200_MEMORY_ADDRESS);
-  Wire.requestFrom(ITG3200_ADDRESS, ITG3200_BUFFER_SIZE);
+  readGyroI2C();
 
   int gyroADC[3];
   measureSpecificGyroADC(gyroADC);
@@ -81,12 +113,26 @@ void measureGyro() {
 }
 
 void measureGyroSum() {
-  sendByteI2C(ITG3200_ADDRESS, ITG3200_MEMORY_ADDRESS);
-  Wire.requestFrom(ITG3200_ADDRESS, ITG3200_BUFFER_SIZE);
+  #ifdef I2C_QUEUE
+    processI2CQueue();
+    if (isI2CTransactionPending(&gyroI2CRead)) {
+      return; // previous read still on the bus
+    }
+    if (gyroI2CRead.status != I2C_DONE) {
+      queueI2CTransaction(&gyroI2CRead); // first read, or the previous one failed
+      return;
+    }
+    gyroI2CIndex = 0;
+  #else
+    readGyroI2C();
+  #endif
   
   measureSpecificGyroSum();
   
   gyroSampleCount++;
+  #ifdef I2C_QUEUE
+    queueI2CTransaction(&gyroI2CRead);
+  #endif
 }
 
 void evaluateGyroRate() {
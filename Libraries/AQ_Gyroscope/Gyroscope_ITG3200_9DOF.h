@@ -25,15 +25,15 @@
 #include <Gyroscope_ITG3200Common.h>
 
 void measureSpecificGyroADC(int *gyroADC) {
-  gyroADC[YAXIS] = readShortI2C()  - gyroZero[YAXIS];
-  gyroADC[XAXIS] = readShortI2C()  - gyroZero[XAXIS];
-  gyroADC[ZAXIS] = gyroZero[ZAXIS] - readShortI2C();
+  gyroADC[YAXIS] = readGyroShortI2C()  - gyroZero[YAXIS];
+  gyroADC[XAXIS] = readGyroShortI2C()  - gyroZero[XAXIS];
+  gyroADC[ZAXIS] = gyroZero[ZAXIS] - readGyroShortI2C();
 }
 
 void measureSpecificGyroSum() {
-  gyroSample[YAXIS] += readShortI2C();
-  gyroSample[XAXIS] += readShortI2C();
-  gyroSample[ZAXIS] += readShortI2C();
+  gyroSample[YAXIS] += readGyroShortI2C();
+  gyroSample[XAXIS] += readGyroShortI2C();
+  gyroSample[ZAXIS] += readGyroShortI2C();
 }
 
 void evaluateSpecificGyroRate(int *gyroADC) {
@@ -47,44 +47,24 @@ boolean calibrateGyro() {
   //Finds gyro drift.
   //Returns false if during calibration there was movement of board. 
 
-  int findZero[FINDZERO];
-  int diff = 0;
-
-  for (byte axis = 0; axis < 3; axis++) {
-    for (int i=0; i<FINDZERO; i++) {
-      sendByteI2C(ITG3200_ADDRESS, (axis * 2) + ITG3200_MEMORY_ADDRESS);
-      findZero[i] = readShortI2C(ITG3200_ADDRESS);
-      delay(10);
-    }
-
-	if (axis == XAXIS) {
-	  int tmp = findMedianIntWithDiff(findZero, FINDZERO, &diff);
-	  if (diff <= GYRO_CALIBRATION_TRESHOLD) { // 4 = 0.27826087 degrees during 49*10ms measurements (490ms). 0.57deg/s difference between first and last.
-	    gyroZero[YAXIS] = tmp;
-  	  } 
-	  else {
-	    return false; //Calibration failed.
-	  }
-    }
-    else if (axis == YAXIS) {
-	  int tmp = findMedianIntWithDiff(findZero, FINDZERO, &diff);
-	  if (diff <= GYRO_CALIBRATION_TRESHOLD) { // 4 = 0.27826087 degrees during 49*10ms measurements (490ms). 0.57deg/s difference between first and last.
-	    gyroZero[XAXIS] = tmp;
-  	  } 
-	  else {
-	    return false; //Calibration failed.
-	  }
+  int sample[3];
+  startGyroCalibration();
+  for (int i=0; i<FINDZERO; i++) {
+    readGyroI2C();
+    for (byte axis = 0; axis < 3; axis++) {
+      sample[axis] = readGyroShortI2C();
     }
-    else {
-	  int tmp = findMedianIntWithDiff(findZero, FINDZERO, &diff);
-	  if (diff <= GYRO_CALIBRATION_TRESHOLD) { // 4 = 0.27826087 degrees during 49*10ms measurements (490ms). 0.57deg/s difference between first and last.
-	    gyroZero[ZAXIS] = tmp;
-  	  } 
-	  else {
-		return false; //Calibration failed.
-	  }
+    // the sensor X and Y axes are the board Y and X axes
+    int sensorX = sample[XAXIS];
+    sample[XAXIS] = sample[YAXIS];
+    sample[YAXIS] = sensorX;
+    // 4 = 0.27826087 degrees during 49*10ms measurements (490ms). 0.57deg/s difference between first and last.
+    if (!addGyroCalibrationSample(sample, GYRO_CALIBRATION_TRESHOLD)) {
+      return false; //Calibration failed.
     }
+    delay(10);
   }
+  finishGyroCalibration();
 
   return true; //Calibration successfull.
 }
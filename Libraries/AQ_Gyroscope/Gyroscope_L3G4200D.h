@@ -140,23 +140,20 @@ void evaluateGyroRate() {
 
 boolean calibrateGyro() {
 
-  int findZero[FINDZERO];
-  int diff = 0; 
-  for (byte axis = XAXIS; axis <= ZAXIS; axis++) {
-    for (int i=0; i<FINDZERO; i++) {
+  int sample[3];
+  startGyroCalibration();
+  for (int i=0; i<FINDZERO; i++) {
+    for (byte axis = XAXIS; axis <= ZAXIS; axis++) {
       sendByteI2C(GYRO_ADDRESS, 0x80 | (0x28+axis*2));
       Wire.requestFrom(GYRO_ADDRESS,2);
-      findZero[i] = readReverseShortI2C();
-      delay(10);
+      sample[axis] = readReverseShortI2C();
+    }
+    if (!addGyroCalibrationSample(sample, GYRO_CALIBRATION_TRESHOLD)) {
+      return false; //Calibration failed.
     }
-    int tmp = findMedianIntWithDiff(findZero, FINDZERO, &diff);
-	if (diff <= GYRO_CALIBRATION_TRESHOLD) { // 4 = 0.27826087 degrees during 49*10ms measurements (490ms). 0.57deg/s difference between first and last.
-	  gyroZero[axis] = tmp;
-	} 
-	else {
-		return false; //Calibration failed.
-	}
+    delay(10);
   }
+  finishGyroCalibration();
   return true;
 }
 #endif
\ No newline at end of file
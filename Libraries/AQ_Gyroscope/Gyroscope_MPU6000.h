@@ -37,7 +37,11 @@ void initializeGyro() {
 
 void gyroUpdateHeading()
 {
-  long int currentTime = micros();
+  #ifdef MPU6000_BATCH
+    long int currentTime = MPU6000Batch.time; // newest sample of the batch
+  #else
+    long int currentTime = micros();
+  #endif
   if (gyroRate[ZAXIS] > (float)radians(1.0) || gyroRate[ZAXIS] < (float)radians(-1.0)) {
     gyroHeading += gyroRate[ZAXIS] * ((currentTime - gyroLastMesuredTime) / 1000000.0);
   }
@@ -61,14 +65,27 @@ void measureGyro() {
 
 void measureGyroSum() {
   readMPU6000Gyro();
-  gyroSample[XAXIS] += (gyroRaw[XAXIS]=MPU6000.data.gyro.x);
-  gyroSample[YAXIS] += (gyroRaw[YAXIS]=MPU6000.data.gyro.y);
-  gyroSample[ZAXIS] += (gyroRaw[ZAXIS]=MPU6000.data.gyro.z);
-
-  gyroSampleCount++;
+  #ifdef MPU6000_BATCH
+    for (byte axis = 0; axis <= ZAXIS; axis++) {
+      gyroSample[axis] += MPU6000Batch.gyro[axis];
+    }
+    gyroRaw[XAXIS] = MPU6000.data.gyro.x;
+    gyroRaw[YAXIS] = MPU6000.data.gyro.y;
+    gyroRaw[ZAXIS] = MPU6000.data.gyro.z;
+    gyroSampleCount += MPU6000Batch.count;
+  #else
+    gyroSample[XAXIS] += (gyroRaw[XAXIS]=MPU6000.data.gyro.x);
+    gyroSample[YAXIS] += (gyroRaw[YAXIS]=MPU6000.data.gyro.y);
+    gyroSample[ZAXIS] += (gyroRaw[ZAXIS]=MPU6000.data.gyro.z);
+
+    gyroSampleCount++;
+  #endif
 }
 
 void evaluateGyroRate() {
+  if (gyroSampleCount == 0) {
+    return; // empty batch, e.g. after a FIFO overflow, keep the last rate
+  }
   int gyroADC[3];
   gyroADC[XAXIS] = (gyroSample[XAXIS] / gyroSampleCount) - gyroZero[XAXIS];
   gyroADC[YAXIS] = gyroZero[YAXIS] - (gyroSample[YAXIS] / gyroSampleCount);
@@ -89,30 +106,19 @@ void evaluateGyroRate() {
 
 boolean calibrateGyro() {
   
-  int findZero[FINDZERO];
-  int diff = 0; 
-  for (byte axis = 0; axis < 3; axis++) {
-    for (int i=0; i<FINDZERO; i++) {
-      readMPU6000Sensors();
-      if(axis == XAXIS) {
-    	findZero[i] = MPU6000.data.gyro.x;
-      } 
-	  else if(axis == YAXIS) {
-    	findZero[i] = MPU6000.data.gyro.y;
-      } 
-	  else {
-    	findZero[i] = MPU6000.data.gyro.z;
-      }
-      delay(10);
+  int sample[3];
+  startGyroCalibration();
+  for (int i=0; i<FINDZERO; i++) {
+    readMPU6000Sensors();
+    sample[XAXIS] = MPU6000.data.gyro.x;
+    sample[YAXIS] = MPU6000.data.gyro.y;
+    sample[ZAXIS] = MPU6000.data.gyro.z;
+    if (!addGyroCalibrationSample(sample, GYRO_CALIBRATION_TRESHOLD)) {
+      return false; //Calibration failed.
     }
-    int tmp = findMedianIntWithDiff(findZero, FINDZERO, &diff);
-	if (diff <= GYRO_CALIBRATION_TRESHOLD) { 
-	  gyroZero[axis] = tmp;
-	} 
-	else {
-		return false; //Calibration failed.
-	}
+    delay(10);
   }
+  finishGyroCalibration();
   return true;
 }
 
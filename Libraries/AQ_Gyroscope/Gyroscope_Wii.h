@@ -107,22 +107,19 @@ void evaluateGyroRate() {
 
 boolean calibrateGyro() {
   
-  int findZero[FINDZERO];
-  int diff = 0;
-  for (byte axis = XAXIS; axis <= ZAXIS; axis++) {
-    for (int i=0; i<FINDZERO; i++) {
-	  readWiiSensors();
-      findZero[i] = getWiiGyroADC(axis);
-      delay(5);
+  int sample[3];
+  startGyroCalibration();
+  for (int i=0; i<FINDZERO; i++) {
+    readWiiSensors();
+    for (byte axis = XAXIS; axis <= ZAXIS; axis++) {
+      sample[axis] = getWiiGyroADC(axis);
+    }
+    if (!addGyroCalibrationSample(sample, GYRO_CALIBRATION_TRESHOLD)) {
+      return false; //Calibration failed.
     }
-    int tmp = findMedianIntWithDiff(findZero, FINDZERO, &diff);
-	if (diff <= GYRO_CALIBRATION_TRESHOLD) { // 4 = 0.27826087 degrees during 49*10ms measurements (490ms). 0.57deg/s difference between first and last.
-	  gyroZero[axis] = tmp;
-	} 
-	else {
-		return false; //Calibration failed.
-	}
+    delay(5);
   }
+  finishGyroCalibration();
   
   return true;
 }
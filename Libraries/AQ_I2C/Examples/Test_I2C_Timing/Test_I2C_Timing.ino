@@ -0,0 +1,164 @@
+/*
+  AeroQuad v3.x
+ www.AeroQuad.com
+ Copyright (c) 2012 Ted Carancho.  All rights reserved.
+ An Open Source Arduino based multicopter.
+ 
+ This program is free software: you can redistribute it and/or modify 
+ it under the terms of the GNU General Public License as published by 
+ the Free Software Foundation, either version 3 of the License, or 
+ (at your option) any later version. 
+ 
+ This program is distributed in the hope that it will be useful, 
+ but WITHOUT ANY WARRANTY; without even the implied warranty of 
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the 
+ GNU General Public License for more details. 
+ 
+ You should have received a copy of the GNU General Public License 
+ along with this program. If not, see <http://www.gnu.org/licenses/>. 
+ */
+
+// I2C bus timing benchmark
+// Measures the time of a register read (pointer write + burst read) as done by the sensor libraries.
+// On STM32 each device is measured with the bit-banged Wire and with the I2C peripheral, and as a
+// background transfer of the I2C queue, where the caller only spends the CPU time to start and to
+// complete the read.
+
+#include <Wire.h>
+#include <Device_I2C.h>
+
+#if defined(WIRE_HARDWARE_I2C)
+  #define I2C_SDA Port2Pin('B', 7) // AeroQuad32 I2C1
+  #define I2C_SCL Port2Pin('B', 6)
+#endif
+
+#define READS 200
+
+struct I2CTimingDevice {
+  const char *name;
+  int address;
+  byte dataRegister;
+  byte dataLength;
+};
+
+I2CTimingDevice devices[] = {
+  {"MPU6050 accel/gyro", 0x68, 0x3B, 14},
+  {"HMC5883L mag",       0x1E, 0x03, 6},
+  {"MS5611 PROM",        0x77, 0xA2, 2},
+};
+
+#define NB_DEVICES (sizeof(devices) / sizeof(devices[0]))
+
+// returns the average time of one read in us, 0 when the device does not answer
+float timeDeviceRead(I2CTimingDevice *device) {
+  Wire.beginTransmission(device->address);
+  Wire.write(device->dataRegister);
+  if (Wire.endTransmission() != 0) {
+    return 0.0;
+  }
+
+  unsigned long start = micros();
+  for (int i = 0; i < READS; i++) {
+    sendByteI2C(device->address, device->dataRegister);
+    Wire.requestFrom(device->address, (int)device->dataLength);
+    for (byte b = 0; b < device->dataLength; b++) {
+      readByteI2C();
+    }
+  }
+  return (float)(micros() - start) / READS;
+}
+
+#if defined(WIRE_ASYNC_TRANSFER)
+// returns the average time of one background read in us and its CPU time in cpuTime,
+// 0 when the device does not answer
+float timeDeviceAsyncRead(I2CTimingDevice *device, float *cpuTime) {
+  byte data[14];
+  unsigned long cpu = 0;
+  unsigned long start = micros();
+  for (int i = 0; i < READS; i++) {
+    unsigned long callStart = micros();
+    if (!Wire.beginAsyncTransfer(device->address, &device->dataRegister, 1, data, device->dataLength)) {
+      return 0.0;
+    }
+    cpu += micros() - callStart;
+    byte result;
+    do {
+      callStart = micros();
+      result = Wire.asyncTransferStatus();
+    } while (result == WIRE_ASYNC_BUSY);
+    cpu += micros() - callStart;
+    if (result != 0) {
+      return 0.0;
+    }
+  }
+  *cpuTime = (float)cpu / READS;
+  return (float)(micros() - start) / READS;
+}
+
+void printAsyncTimings() {
+  Serial.println("I2C peripheral, background transfer");
+  for (byte d = 0; d < NB_DEVICES; d++) {
+    Serial.print("  ");
+    Serial.print(devices[d].name);
+    Serial.print(", ");
+    Serial.print((int)devices[d].dataLength);
+    Serial.print(" bytes : ");
+    float cpuTime = 0.0;
+    float readTime = timeDeviceAsyncRead(&devices[d], &cpuTime);
+    if (readTime == 0.0) {
+      Serial.println("not found");
+    }
+    else {
+      Serial.print(readTime);
+      Serial.print(" us, CPU ");
+      Serial.print(cpuTime);
+      Serial.println(" us");
+    }
+  }
+}
+#endif
+
+void printTimings(const char *mode) {
+  Serial.println(mode);
+  for (byte d = 0; d < NB_DEVICES; d++) {
+    Serial.print("  ");
+    Serial.print(devices[d].name);
+    Serial.print(", ");
+    Serial.print((int)devices[d].dataLength);
+    Serial.print(" bytes : ");
+    float readTime = timeDeviceRead(&devices[d]);
+    if (readTime == 0.0) {
+      Serial.println("not found");
+    }
+    else {
+      Serial.print(readTime);
+      Serial.println(" us");
+    }
+  }
+}
+
+void setup() {
+
+  Serial.begin(115200);
+  Serial.println("I2C bus timing benchmark");
+}
+
+void loop() {
+
+  #if defined(WIRE_HARDWARE_I2C)
+    Wire.begin(I2C_SDA, I2C_SCL, false);
+    printTimings("bit-banged Wire");
+    Wire.begin(I2C_SDA, I2C_SCL, true);
+    printTimings(Wire.isHardware() ? "I2C peripheral, 400 kHz" : "I2C peripheral not available on these pins");
+    #if defined(WIRE_ASYNC_TRANSFER)
+      if (Wire.isHardware()) {
+        printAsyncTimings();
+      }
+    #endif
+  #else
+    Wire.begin();
+    printTimings("Wire");
+  #endif
+  Serial.println();
+  delay(5000);
+}
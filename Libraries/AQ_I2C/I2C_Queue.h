@@ -0,0 +1,205 @@
+/*
+  AeroQuad v3.x
+  www.AeroQuad.com
+  Copyright (c) 2012 Ted Carancho.  All rights reserved.
+  An Open Source Arduino based multicopter.
+ 
+  This program is free software: you can redistribute it and/or modify 
+  it under the terms of the GNU General Public License as published by 
+  the Free Software Foundation, either version 3 of the License, or 
+  (at your option) any later version. 
+
+  This program is distributed in the hope that it will be useful, 
+  but WITHOUT ANY WARRANTY; without even the implied warranty of 
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the 
+  GNU General Public License for more details. 
+
+  You should have received a copy of the GNU General Public License 
+  along with this program. If not, see <http://www.gnu.org/licenses/>. 
+*/
+
+// I2C transaction queue shared by the sensors
+// A transaction is a register/command write followed by an optional read. Queued transactions
+// run back-to-back, highest priority first and in queue order within a priority. A low priority
+// transaction that waited longer than I2C_QUEUE_MAX_WAIT is served as high priority, so the
+// baro and mag still get the bus when the gyro/accel reads keep it busy.
+// When Wire can transfer in the background (WIRE_ASYNC_TRANSFER) processI2CQueue() only polls
+// the bus and starts the next transaction, otherwise each transaction is done at once with the
+// blocking Wire calls. The completion callback is called from processI2CQueue().
+
+#ifndef _AEROQUAD_I2C_QUEUE_H_
+#define _AEROQUAD_I2C_QUEUE_H_
+
+#include "Arduino.h"
+#include <Device_I2C.h>
+
+#define I2C_QUEUE_SIZE 8
+#define I2C_QUEUE_MAX_WAIT 20000 // us
+
+#define I2C_PRIORITY_HIGH 0 // gyro, accel
+#define I2C_PRIORITY_LOW  1 // baro, mag
+#define I2C_PRIORITIES    2
+
+// transaction status
+#define I2C_IDLE   0
+#define I2C_QUEUED 1
+#define I2C_ACTIVE 2
+#define I2C_DONE   3
+#define I2C_FAILED 4
+
+#define I2C_MAX_TX 2
+
+struct I2CTransaction {
+  byte address;
+  byte priority;
+  byte txLength;
+  byte txData[I2C_MAX_TX];
+  byte rxLength;
+  byte *rxData;
+  void (*callback)(struct I2CTransaction *transaction);
+  volatile byte status;
+  unsigned long queueTime;
+};
+
+struct I2CQueueStatistics {
+  unsigned long count;
+  unsigned long waitSum;  // us from queued to started
+  unsigned long waitMax;
+  unsigned long promoted; // low priority ones served as high priority
+  unsigned long failed;
+} i2cQueueStatistics[I2C_PRIORITIES];
+
+struct I2CTransaction *i2cQueue[I2C_QUEUE_SIZE];
+byte i2cQueueLength = 0;
+struct I2CTransaction *i2cActiveTransaction = NULL;
+boolean i2cQueueProcessing = false; // a callback may queue the next transaction
+
+boolean isI2CTransactionPending(struct I2CTransaction *transaction) {
+  return transaction->status == I2C_QUEUED || transaction->status == I2C_ACTIVE;
+}
+
+void completeI2CTransaction(byte result) {
+  struct I2CTransaction *transaction = i2cActiveTransaction;
+  i2cActiveTransaction = NULL;
+  if (result == 0) {
+    transaction->status = I2C_DONE;
+  }
+  else {
+    transaction->status = I2C_FAILED;
+    i2cQueueStatistics[transaction->priority].failed++;
+  }
+  if (transaction->callback) {
+    transaction->callback(transaction);
+  }
+}
+
+// blocking fallback, same bus sequence as the Device_I2C functions
+byte runI2CTransaction(struct I2CTransaction *transaction) {
+  if (transaction->txLength) {
+    Wire.beginTransmission(transaction->address);
+    for (byte i = 0; i < transaction->txLength; i++) {
+      Wire.write(transaction->txData[i]);
+    }
+    byte result = Wire.endTransmission();
+    if (result != 0) {
+      return result;
+    }
+  }
+  if (transaction->rxLength) {
+    if (Wire.requestFrom((int)transaction->address, (int)transaction->rxLength) != transaction->rxLength) {
+      return 4;
+    }
+    for (byte i = 0; i < transaction->rxLength; i++) {
+      transaction->rxData[i] = readByteI2C();
+    }
+  }
+  return 0;
+}
+
+// removes and returns the transaction to run next
+struct I2CTransaction *nextI2CTransaction(unsigned long now) {
+  byte next = 0;
+  byte nextPriority = I2C_PRIORITIES;
+  for (byte i = 0; i < i2cQueueLength; i++) {
+    byte priority = i2cQueue[i]->priority;
+    if (now - i2cQueue[i]->queueTime > I2C_QUEUE_MAX_WAIT) {
+      priority = I2C_PRIORITY_HIGH;
+    }
+    if (priority < nextPriority) {
+      next = i;
+      nextPriority = priority;
+    }
+  }
+  struct I2CTransaction *transaction = i2cQueue[next];
+  i2cQueueLength--;
+  for (byte i = next; i < i2cQueueLength; i++) {
+    i2cQueue[i] = i2cQueue[i + 1];
+  }
+
+  struct I2CQueueStatistics *statistics = &i2cQueueStatistics[transaction->priority];
+  unsigned long wait = now - transaction->queueTime;
+  statistics->count++;
+  statistics->waitSum += wait;
+  if (wait > statistics->waitMax) {
+    statistics->waitMax = wait;
+  }
+  if (nextPriority != transaction->priority) {
+    statistics->promoted++;
+  }
+  return transaction;
+}
+
+// Completes the running transaction and starts the queued ones, call it as often as possible
+void processI2CQueue() {
+  if (i2cQueueProcessing) {
+    return;
+  }
+  i2cQueueProcessing = true;
+  if (i2cActiveTransaction) {
+    #if defined(WIRE_ASYNC_TRANSFER)
+      byte result = Wire.asyncTransferStatus();
+      if (result == WIRE_ASYNC_BUSY) {
+        i2cQueueProcessing = false;
+        return;
+      }
+      completeI2CTransaction(result);
+    #endif
+  }
+
+  while (i2cQueueLength > 0) {
+    i2cActiveTransaction = nextI2CTransaction(micros());
+    i2cActiveTransaction->status = I2C_ACTIVE;
+    #if defined(WIRE_ASYNC_TRANSFER)
+      if (Wire.beginAsyncTransfer(i2cActiveTransaction->address,
+                                  i2cActiveTransaction->txData, i2cActiveTransaction->txLength,
+                                  i2cActiveTransaction->rxData, i2cActiveTransaction->rxLength)) {
+        break;
+      }
+    #endif
+    completeI2CTransaction(runI2CTransaction(i2cActiveTransaction));
+  }
+  i2cQueueProcessing = false;
+}
+
+// Queues a transaction and starts it when the bus is free, returns false when it is
+// already pending or the queue is full
+boolean queueI2CTransaction(struct I2CTransaction *transaction) {
+  processI2CQueue();
+  if (isI2CTransactionPending(transaction) || i2cQueueLength >= I2C_QUEUE_SIZE) {
+    return false;
+  }
+  transaction->status = I2C_QUEUED;
+  transaction->queueTime = micros();
+  i2cQueue[i2cQueueLength++] = transaction;
+  processI2CQueue();
+  return true;
+}
+
+// for the init and calibration code that needs the result at once
+void waitI2CTransaction(struct I2CTransaction *transaction) {
+  while (isI2CTransactionPending(transaction)) {
+    processI2CQueue();
+  }
+}
+
+#endif
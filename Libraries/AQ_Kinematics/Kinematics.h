@@ -22,6 +22,7 @@
 #define _AQ_KINEMATICS_
 
 #include "GlobalDefined.h"
+#include <FastTrigonometry.h>
 
 #define CF 0
 #define KF 1
@@ -52,6 +53,8 @@ void calculateKinematics(float rollRate,           float pitchRate,     float ya
                          float longitudinalAccel,  float lateralAccel,  float verticalAccel, 
                          float G_Dt);
 float getGyroUnbias(byte axis);
+// attitude of an axis in radians, read through here, kinematics may compute it on demand
+const float getKinematicsAngle(byte axis);
 void calibrateKinematics();
  
   // returns the kinematicsAngle of a specific axis in SI units (radians)
@@ -69,7 +72,7 @@ void calibrateKinematics();
 const float kinematicsGetDegreesHeading(byte axis) {
   float tDegrees;
     
-  tDegrees = degrees(kinematicsAngle[axis]);
+  tDegrees = degrees(getKinematicsAngle(axis));
   if (tDegrees < 0.0)
     return (tDegrees + 360.0);
   else
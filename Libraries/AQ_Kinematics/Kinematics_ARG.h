@@ -61,6 +61,81 @@ float previousEx = 0.0;
 float previousEy = 0.0;
 float previousEz = 0.0;
 
+#if defined(FixedPointKernels)
+  #include <FixedPoint.h>
+
+  // Q2.30 state of the fixed point argUpdate(), the attitude outputs are computed from
+  // qFixed, q0..q3 aren't used
+  int32_t qFixed[4];
+  int32_t errorIntegralFixed[3];
+  int32_t previousErrorFixed[3];
+  int32_t KpFixed, KiFixed;
+
+  #define ARG_MAX_DT 0.5 // s, longer steps are integrated as this long
+
+  // calculateKinematicsFixed() takes the Q16.16 output of BiquadCascadeFixed
+  #define KINEMATICS_FIXED_ACCEL
+
+////////////////////////////////////////////////////////////////////////////////
+// argUpdate
+////////////////////////////////////////////////////////////////////////////////
+void argUpdate(float gx, float gy, float gz, const int32_t *accelFixed, float G_Dt) {
+
+  int32_t accel[3] = {accelFixed[XAXIS], accelFixed[YAXIS], accelFixed[ZAXIS]};
+  int32_t gyro[3] = {floatToQ24(gx), floatToQ24(gy), floatToQ24(gz)};
+  int32_t vector[3], error[3];
+
+  halfT = G_Dt/2;
+  // half the sample period as a 0.32 fraction of a second
+  int32_t halfTFixed = (int32_t)(constrain(G_Dt, 0.0, ARG_MAX_DT) * 2147483648.0);
+
+  // normalise the measurements
+  fixedNormalize(accel, 3);
+
+  // estimated direction of gravity, the unit quaternion in Q1.15 gives 32 bit products
+  int32_t q15[4];
+  for (byte index = 0; index < 4; index++) {
+    q15[index] = q30ToQ15(qFixed[index]);
+  }
+  vector[XAXIS] = (q15[1] * q15[3] - q15[0] * q15[2]) * 2;
+  vector[YAXIS] = (q15[0] * q15[1] + q15[2] * q15[3]) * 2;
+  vector[ZAXIS] = q15[0] * q15[0] - q15[1] * q15[1] - q15[2] * q15[2] + q15[3] * q15[3];
+
+  // error is cross product between reference direction of fields and direction measured by sensors,
+  // both unit vectors in Q1.15
+  for (byte axis = XAXIS; axis <= ZAXIS; axis++) {
+    vector[axis] = q30ToQ15(vector[axis]);
+    accel[axis] = q30ToQ15(accel[axis]);
+  }
+  error[XAXIS] = vector[YAXIS] * accel[ZAXIS] - vector[ZAXIS] * accel[YAXIS];
+  error[YAXIS] = vector[ZAXIS] * accel[XAXIS] - vector[XAXIS] * accel[ZAXIS];
+  error[ZAXIS] = vector[XAXIS] * accel[YAXIS] - vector[YAXIS] * accel[XAXIS];
+
+  for (byte axis = XAXIS; axis <= ZAXIS; axis++) {
+    // integral error scaled integral gain
+    errorIntegralFixed[axis] += q30Multiply(error[axis], KiFixed);
+    if ((previousErrorFixed[axis] > 0 && error[axis] < 0) || (previousErrorFixed[axis] < 0 && error[axis] > 0)) {
+      errorIntegralFixed[axis] = 0;
+    }
+    previousErrorFixed[axis] = error[axis];
+
+    // adjusted gyroscope measurements, then times halfT in Q2.30
+    gyro[axis] += (q30Multiply(error[axis], KpFixed) + errorIntegralFixed[axis] + (1L << 5)) >> 6;
+    gyro[axis] = multiplyShift(gyro[axis], halfTFixed, 26);
+  }
+
+  // integrate quaternion rate and normalise, the small increments keep the full Q2.30 products
+  int32_t q[4];
+  q[0] = qFixed[0] - q30Multiply(qFixed[1], gyro[XAXIS]) - q30Multiply(qFixed[2], gyro[YAXIS]) - q30Multiply(qFixed[3], gyro[ZAXIS]);
+  q[1] = qFixed[1] + q30Multiply(qFixed[0], gyro[XAXIS]) + q30Multiply(qFixed[2], gyro[ZAXIS]) - q30Multiply(qFixed[3], gyro[YAXIS]);
+  q[2] = qFixed[2] + q30Multiply(qFixed[0], gyro[YAXIS]) - q30Multiply(qFixed[1], gyro[ZAXIS]) + q30Multiply(qFixed[3], gyro[XAXIS]);
+  q[3] = qFixed[3] + q30Multiply(qFixed[0], gyro[ZAXIS]) + q30Multiply(qFixed[1], gyro[YAXIS]) - q30Multiply(qFixed[2], gyro[XAXIS]);
+  fixedNormalize(q, 4);
+  for (byte index = 0; index < 4; index++) {
+    qFixed[index] = q[index];
+  }
+}
+#else
 ////////////////////////////////////////////////////////////////////////////////
 // argUpdate
 ////////////////////////////////////////////////////////////////////////////////
@@ -130,12 +205,104 @@ void argUpdate(float gx, float gy, float gz, float ax, float ay, float az, float
   q2 = q2 / norm;
   q3 = q3 / norm;
 }
+#endif
   
-void eulerAngles()
+////////////////////////////////////////////////////////////////////////////////
+// Attitude outputs
+//
+// The quaternion is the state of the filter. The rotation matrix, the angles and
+// the earth axis accels are computed from it when first asked for after an update
+// and kept until the next one, an attitude hold that reads roll and pitch skips
+// the heading arc tangent, a rate mode cycle reads none of them.
+////////////////////////////////////////////////////////////////////////////////
+
+#define KINEMATICS_MATRIX_VALID      0x01
+#define KINEMATICS_ANGLE_VALID(axis) (0x02 << (axis))
+#define KINEMATICS_EARTH_ACCEL_VALID 0x10
+
+byte kinematicsValid = 0;       // outputs computed since the last update
+float kinematicsMatrix[9];      // body to earth rotation, row major like the dcmMatrix of DCM
+#if defined(FixedPointKernels)
+  int32_t kinematicsBodyAccel[3]; // Q16.16 accelerometer input of the last update
+#else
+  float kinematicsBodyAccel[3];   // accelerometer input of the last update
+#endif
+
+float *getKinematicsMatrix()
 {
-  kinematicsAngle[XAXIS]  = atan2(2 * (q0*q1 + q2*q3), 1 - 2 *(q1*q1 + q2*q2));
-  kinematicsAngle[YAXIS] = asin(2 * (q0*q2 - q1*q3));
-  kinematicsAngle[ZAXIS]   = atan2(2 * (q0*q3 + q1*q2), 1 - 2 *(q2*q2 + q3*q3));
+  if (!(kinematicsValid & KINEMATICS_MATRIX_VALID)) {
+  #if defined(FixedPointKernels)
+    // 32 bit products of the quaternion in Q1.15, one conversion per entry
+    int32_t q[4];
+    for (byte index = 0; index < 4; index++) {
+      q[index] = q30ToQ15(qFixed[index]);
+    }
+    int32_t q0q0 = q[0]*q[0], q1q1 = q[1]*q[1], q2q2 = q[2]*q[2], q3q3 = q[3]*q[3];
+    int32_t q0q1 = q[0]*q[1], q0q2 = q[0]*q[2], q0q3 = q[0]*q[3];
+    int32_t q1q2 = q[1]*q[2], q1q3 = q[1]*q[3], q2q3 = q[2]*q[3];
+    kinematicsMatrix[0] = q30ToFloat(q0q0 + q1q1 - q2q2 - q3q3);
+    kinematicsMatrix[1] = q30ToFloat(2 * (q1q2 - q0q3));
+    kinematicsMatrix[2] = q30ToFloat(2 * (q1q3 + q0q2));
+    kinematicsMatrix[3] = q30ToFloat(2 * (q1q2 + q0q3));
+    kinematicsMatrix[4] = q30ToFloat(q0q0 - q1q1 + q2q2 - q3q3);
+    kinematicsMatrix[5] = q30ToFloat(2 * (q2q3 - q0q1));
+    kinematicsMatrix[6] = q30ToFloat(2 * (q1q3 - q0q2));
+    kinematicsMatrix[7] = q30ToFloat(2 * (q2q3 + q0q1));
+    kinematicsMatrix[8] = q30ToFloat(q0q0 - q1q1 - q2q2 + q3q3);
+  #else
+    float q0q0 = q0*q0, q1q1 = q1*q1, q2q2 = q2*q2, q3q3 = q3*q3;
+    float q0q1 = q0*q1, q0q2 = q0*q2, q0q3 = q0*q3;
+    float q1q2 = q1*q2, q1q3 = q1*q3, q2q3 = q2*q3;
+    kinematicsMatrix[0] = q0q0 + q1q1 - q2q2 - q3q3;
+    kinematicsMatrix[1] = 2 * (q1q2 - q0q3);
+    kinematicsMatrix[2] = 2 * (q1q3 + q0q2);
+    kinematicsMatrix[3] = 2 * (q1q2 + q0q3);
+    kinematicsMatrix[4] = q0q0 - q1q1 + q2q2 - q3q3;
+    kinematicsMatrix[5] = 2 * (q2q3 - q0q1);
+    kinematicsMatrix[6] = 2 * (q1q3 - q0q2);
+    kinematicsMatrix[7] = 2 * (q2q3 + q0q1);
+    kinematicsMatrix[8] = q0q0 - q1q1 - q2q2 + q3q3;
+  #endif
+    kinematicsValid |= KINEMATICS_MATRIX_VALID;
+  }
+  return kinematicsMatrix;
+}
+
+const float getKinematicsAngle(byte axis)
+{
+  if (!(kinematicsValid & KINEMATICS_ANGLE_VALID(axis))) {
+    float *matrix = getKinematicsMatrix();
+    if (axis == XAXIS) {
+      kinematicsAngle[XAXIS] = fastAtan2(matrix[7], matrix[8]);
+    }
+    else if (axis == YAXIS) {
+      kinematicsAngle[YAXIS] = -fastAsin(constrain(matrix[6], -1.0, 1.0));
+    }
+    else {
+      kinematicsAngle[ZAXIS] = fastAtan2(matrix[3], matrix[0]);
+    }
+    kinematicsValid |= KINEMATICS_ANGLE_VALID(axis);
+  }
+  return kinematicsAngle[axis];
+}
+
+// acceleration in the earth axes without gravity, m/s^2, with the one G the accelerometer
+// calibration measured
+const float getEarthAccel(byte axis)
+{
+  if (!(kinematicsValid & KINEMATICS_EARTH_ACCEL_VALID)) {
+    float *matrix = getKinematicsMatrix();
+    #if defined(FixedPointKernels)
+      float bodyAccel[3] = {fixedToFloat(kinematicsBodyAccel[XAXIS]), fixedToFloat(kinematicsBodyAccel[YAXIS]), fixedToFloat(kinematicsBodyAccel[ZAXIS])};
+    #else
+      float *bodyAccel = kinematicsBodyAccel;
+    #endif
+    earthAccel[XAXIS] = vectorDotProduct(3, &matrix[0], bodyAccel);
+    earthAccel[YAXIS] = vectorDotProduct(3, &matrix[3], bodyAccel);
+    earthAccel[ZAXIS] = vectorDotProduct(3, &matrix[6], bodyAccel) + fabs(accelOneG);
+    kinematicsValid |= KINEMATICS_EARTH_ACCEL_VALID;
+  }
+  return earthAccel[axis];
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -157,13 +324,50 @@ void initializeKinematics()
   previousEy = 0;
   previousEz = 0;
 
+  kinematicsValid = 0;
+  for (byte axis = XAXIS; axis <= ZAXIS; axis++) {
+    kinematicsBodyAccel[axis] = 0;
+  }
+
   Kp = 0.2; // 2.0;
   Ki = 0.0005; //0.005;
+
+  #if defined(FixedPointKernels)
+    qFixed[0] = Q30_ONE;
+    for (byte index = 1; index < 4; index++) {
+      qFixed[index] = 0;
+    }
+    for (byte axis = XAXIS; axis <= ZAXIS; axis++) {
+      errorIntegralFixed[axis] = 0;
+      previousErrorFixed[axis] = 0;
+    }
+    KpFixed = floatToQ30(Kp);
+    KiFixed = floatToQ30(Ki);
+  #endif
 }
   
 ////////////////////////////////////////////////////////////////////////////////
 // Calculate ARG
 ////////////////////////////////////////////////////////////////////////////////
+#if defined(FixedPointKernels)
+// accel in Q16.16 from BiquadCascadeFixed, it stays in fixed point up to the attitude outputs
+void calculateKinematicsFixed(float rollRate, float pitchRate, float yawRate, const int32_t *accel, float G_DT) {
+
+  argUpdate(rollRate, pitchRate, yawRate, accel, G_Dt);
+  for (byte axis = XAXIS; axis <= ZAXIS; axis++) {
+    kinematicsBodyAccel[axis] = accel[axis];
+  }
+  kinematicsValid = 0;
+}
+
+void calculateKinematics(float rollRate,          float pitchRate,    float yawRate,  
+                         float longitudinalAccel, float lateralAccel, float verticalAccel, 
+                         float G_DT) {
+
+  const int32_t accel[3] = {floatToFixed(longitudinalAccel), floatToFixed(lateralAccel), floatToFixed(verticalAccel)};
+  calculateKinematicsFixed(rollRate, pitchRate, yawRate, accel, G_DT);
+}
+#else
 void calculateKinematics(float rollRate,          float pitchRate,    float yawRate,  
                          float longitudinalAccel, float lateralAccel, float verticalAccel, 
                          float G_DT) {
@@ -171,8 +375,12 @@ void calculateKinematics(float rollRate,          float pitchRate,    float yawR
   argUpdate(rollRate,          pitchRate,    yawRate, 
             longitudinalAccel, lateralAccel, verticalAccel,  
 		    G_Dt);
-  eulerAngles();
+  kinematicsBodyAccel[XAXIS] = longitudinalAccel;
+  kinematicsBodyAccel[YAXIS] = lateralAccel;
+  kinematicsBodyAccel[ZAXIS] = verticalAccel;
+  kinematicsValid = 0;
 }
+#endif
   
 float getGyroUnbias(byte axis) {
   return correctedRateVector[axis];
@@ -57,5 +57,9 @@ float getGyroUnbias(byte axis) {
   return gyroRate[axis];
 }
 
+const float getKinematicsAngle(byte axis) {
+  return kinematicsAngle[axis];
+}
+
 
 #endif
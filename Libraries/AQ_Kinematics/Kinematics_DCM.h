@@ -173,9 +173,9 @@ void driftCorrection(float ax, float ay, float az, float oneG, float magX, float
 
 void eulerAngles(void)
 {
-  kinematicsAngle[XAXIS]  =  atan2(dcmMatrix[7], dcmMatrix[8]);
-  kinematicsAngle[YAXIS] =  -asin(dcmMatrix[6]);
-  trueNorthHeading = kinematicsAngle[ZAXIS]   =  atan2(dcmMatrix[3], dcmMatrix[0]);
+  kinematicsAngle[XAXIS]  =  fastAtan2(dcmMatrix[7], dcmMatrix[8]);
+  kinematicsAngle[YAXIS] =  -fastAsin(dcmMatrix[6]);
+  trueNorthHeading = kinematicsAngle[ZAXIS]   =  fastAtan2(dcmMatrix[3], dcmMatrix[0]);
 } 
   
 ////////////////////////////////////////////////////////////////////////////////
@@ -242,6 +242,10 @@ void calculateKinematics(float rollRate,            float pitchRate,      float
 }
   
 void calibrateKinematics() {};
+
+const float getKinematicsAngle(byte axis) {
+  return kinematicsAngle[axis];
+}
   
 
 
@@ -50,19 +50,88 @@ MedianFilter::MedianFilter() {}
 
 void MedianFilter::initialize() 
 {
+  // window full of zeros, filled into the heaps as median, max, min, max, min...
   for (int index = 0; index < DATASIZE; index++) 
   {
     data[index] = 0;
-    sortData[index] = 0;
+    heapPosition[index] = ((index + 1) / 2) * ((index & 1) ? -1 : 1);
+    heap(heapPosition[index]) = index;
   }
   dataIndex = 0;
 }
+
+// swaps heap nodes i and j when node i is less, keeping heapPosition in step
+boolean MedianFilter::heapExchangeIfLess(int i, int j) 
+{
+  if (!heapLess(i, j)) 
+  {
+    return false;
+  }
+  int temp = heap(i);
+  heap(i) = heap(j);
+  heap(j) = temp;
+  heapPosition[heap(i)] = i;
+  heapPosition[heap(j)] = j;
+  return true;
+}
+
+// restores the min heap below the parent of index
+void MedianFilter::minHeapSortDown(int index) 
+{
+  for (; index <= (DATASIZE - 1) / 2; index *= 2) 
+  {
+    if (index > 1 && index < (DATASIZE - 1) / 2 && heapLess(index + 1, index)) 
+    {
+      index++;
+    }
+    if (!heapExchangeIfLess(index, index / 2)) 
+    {
+      break;
+    }
+  }
+}
+
+// restores the max heap below the parent of index (negative indices)
+void MedianFilter::maxHeapSortDown(int index) 
+{
+  for (; index >= -(DATASIZE / 2); index *= 2) 
+  {
+    if (index < -1 && index > -(DATASIZE / 2) && heapLess(index, index - 1)) 
+    {
+      index--;
+    }
+    if (!heapExchangeIfLess(index / 2, index)) 
+    {
+      break;
+    }
+  }
+}
+
+// restores the min heap above index, returns true when the sample became the median
+boolean MedianFilter::minHeapSortUp(int index) 
+{
+  while (index > 0 && heapExchangeIfLess(index, index / 2)) 
+  {
+    index /= 2;
+  }
+  return index == 0;
+}
+
+// restores the max heap above index, returns true when the sample became the median
+boolean MedianFilter::maxHeapSortUp(int index) 
+{
+  while (index < 0 && heapExchangeIfLess(index / 2, index)) 
+  {
+    index /= 2;
+  }
+  return index == 0;
+}
   
 const float MedianFilter::filter(float newData) 
 {
-  int temp, j; // used to sort array
-
-  // Insert new data into raw data array round robin style
+  // Replace the oldest sample round robin style, it keeps its heap node
+  int position = heapPosition[dataIndex];
+  float oldData = data[dataIndex];
   data[dataIndex] = newData;
   if (dataIndex < (DATASIZE-1)) 
   {
@@ -73,22 +142,35 @@ const float MedianFilter::filter(float newData)
     dataIndex = 0;    
   }
 
-  // Copy raw data to sort data array
-  memcpy(sortData, data, sizeof(data));
-
-  // Insertion Sort
-  for(int i=1; i<=(DATASIZE-1); i++) 
+  // Move the new sample up or down its heap, through the median into the other heap if needed
+  if (position > 0) 
+  {
+    if (oldData < newData) 
+    {
+      minHeapSortDown(position * 2);
+    }
+    else if (minHeapSortUp(position)) 
+    {
+      maxHeapSortDown(-1);
+    }
+  }
+  else if (position < 0) 
   {
-    temp = sortData[i];
-    j = i-1;
-    while(temp<sortData[j] && j>=0) 
-	{
-	  sortData[j+1] = sortData[j];
-	  j = j-1;
+    if (newData < oldData) 
+    {
+      maxHeapSortDown(position * 2);
     }
-    sortData[j+1] = temp;
+    else if (maxHeapSortUp(position)) 
+    {
+      minHeapSortDown(1);
+    }
+  }
+  else 
+  {
+    maxHeapSortDown(-1);
+    minHeapSortDown(1);
   }
-  return data[(DATASIZE)>>1]; // return data value in middle of sorted array
+  return data[heap(0)];
 } 
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -342,82 +424,88 @@ float arctan2(float y, float x)
 // Used for sensor calibration
 // Takes the median of 50 results as zero
 // Thanks ala42! Post: http://aeroquad.com/showthread.php?1369-The-big-enhancement-addition-to-2.0-code/page5
-float findMedianFloat(float *data, int arraySize) 
+// The median is found by Hoare's selection instead of sorting the whole array: partition
+// around the median of the first, middle and last value and keep only the part holding the
+// middle index, O(n) on average. Equal values stop both scans, constant data splits evenly.
+template <typename T> static T selectMedian(T *data, int arraySize) 
 {
-  float temp;
-  boolean done = 0;
-  byte i;
-  
-   // Sorts numbers from lowest to highest
-  while (done != 1) 
-  {        
-    done = 1;
-    for (i=0; i<(arraySize-1); i++) 
-	{
-      if (data[i] > data[i+1]) 
-	  {     // numbers are out of order - swap
-        temp = data[i+1];
-        data[i+1] = data[i];
-        data[i] = temp;
-        done = 0;
+  int middle = arraySize / 2;
+  int left = 0;
+  int right = arraySize - 1;
+  T temp;
+
+  while (left < right) 
+  {
+    // median of three as pivot: when both outer values are on the same side of the
+    // middle one, the nearer outer value is the median
+    T pivot = data[middle];
+    if ((data[left] < pivot) == (data[right] < pivot)) 
+    {
+      pivot = ((data[left] < data[right]) == (data[left] < pivot)) ? data[right] : data[left];
+    }
+
+    int i = left;
+    int j = right;
+    do 
+    {
+      while (data[i] < pivot) 
+      {
+        i++;
+      }
+      while (pivot < data[j]) 
+      {
+        j--;
+      }
+      if (i <= j) 
+      {
+        temp = data[i];
+        data[i] = data[j];
+        data[j] = temp;
+        i++;
+        j--;
       }
+    } while (i <= j);
+
+    if (j < middle) 
+    {
+      left = i;
+    }
+    if (middle < i) 
+    {
+      right = j;
     }
   }
-  
-  return data[arraySize/2]; // return the median value
+  return data[middle]; // return the median value
 }
 
+float findMedianFloat(float *data, int arraySize) 
+{
+  return selectMedian(data, arraySize);
+}
 
 int findMedianInt(int *data, int arraySize) 
 {
-  int temp;
-  boolean done = 0;
-  byte i;
-  
-   // Sorts numbers from lowest to highest
-  while (done != 1) 
-  {        
-    done = 1;
-    for (i=0; i<(arraySize-1); i++) 
-	{
-      if (data[i] > data[i+1]) 
-	  {     // numbers are out of order - swap
-        temp = data[i+1];
-        data[i+1] = data[i];
-        data[i] = temp;
-        done = 0;
-      }
-    }
-  }
-  
-  return data[arraySize/2]; // return the median value
+  return selectMedian(data, arraySize);
 }
 
 int findMedianIntWithDiff(int *data, int arraySize, int * diff) 
 {
-  int temp;
-  boolean done = 0;
-  byte i;
-  
-   // Sorts numbers from lowest to highest
-  while (done != 1) 
-  {        
-    done = 1;
-    for (i=0; i<(arraySize-1); i++) 
-	{
-      if (data[i] > data[i+1]) 
-	  {     // numbers are out of order - swap
-        temp = data[i+1];
-        data[i+1] = data[i];
-        data[i] = temp;
-        done = 0;
-      }
+  int minimum = data[0];
+  int maximum = data[0];
+  for (int i = 1; i < arraySize; i++) 
+  {
+    if (data[i] < minimum) 
+    {
+      minimum = data[i];
+    }
+    else if (data[i] > maximum) 
+    {
+      maximum = data[i];
     }
   }
-
-  *diff = abs(data[0] - data[arraySize-1]);
+  *diff = maximum - minimum;
   
-  return data[arraySize/2]; // return the median value
+  return selectMedian(data, arraySize);
 }
 
 
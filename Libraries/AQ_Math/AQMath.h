@@ -21,7 +21,9 @@
 #ifndef _AQ_MATH_H_
 #define _AQ_MATH_H_
 
-#define DATASIZE 25
+#ifndef DATASIZE
+  #define DATASIZE 25 // samples in the window of MedianFilter
+#endif
 
 #include "Arduino.h"
 
@@ -37,17 +39,32 @@ float filterSmoothWithTime(float currentData, float previousData, float smoothFa
 // ***********************************************************************
 // Median filter currently not used, but kept if needed for the future
 // To declare use: MedianFilter filterSomething;
+// Median of the last DATASIZE samples in O(log DATASIZE) per sample: the window is kept
+// as a max heap of the lower half, the median and a min heap of the upper half
 
 class MedianFilter 
 {
 public: 
-  float data[DATASIZE], sortData[DATASIZE];
+  float data[DATASIZE];
   int dataIndex;
   MedianFilter();
 
   void initialize();
   
   const float filter(float newData);
+
+private:
+  // heap index -DATASIZE/2..-1 max heap, 0 median, 1..(DATASIZE-1)/2 min heap
+  int heapStorage[DATASIZE];   // index into data[] of each heap node
+  int heapPosition[DATASIZE];  // heap index of each data[] sample
+
+  int &heap(int index) { return heapStorage[index + DATASIZE / 2]; }
+  boolean heapLess(int i, int j) { return data[heap(i)] < data[heap(j)]; }
+  boolean heapExchangeIfLess(int i, int j);
+  void minHeapSortDown(int index);
+  void maxHeapSortDown(int index);
+  boolean minHeapSortUp(int index);
+  boolean maxHeapSortUp(int index);
 };
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -162,10 +179,12 @@ void matrixInverse3x3(float matrixC[9], float matrixA[9]);
 
 
 // Alternate method to calculate arctangent from: http://www.dspguru.com/comp.dsp/tricks/alg/fxdatan2.htm
+// Up to 0.07 rad off, fastAtan2() of FastTrigonometry.h is the accurate one
 float arctan2(float y, float x);
 
 // Used for sensor calibration
 // Takes the median of 50 results as zero
+// Selection in O(n) average, the order of data is changed
 float findMedianFloat(float *data, int arraySize);
 int findMedianInt(int *data, int arraySize); 
 int findMedianIntWithDiff(int *data, int arraySize, int * diff); 
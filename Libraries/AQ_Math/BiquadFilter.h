@@ -0,0 +1,195 @@
+/*
+  AeroQuad v3.0.1 - February 2012
+  www.AeroQuad.com
+  Copyright (c) 2012 Ted Carancho.  All rights reserved.
+  An Open Source Arduino based multicopter.
+ 
+  This program is free software: you can redistribute it and/or modify 
+  it under the terms of the GNU General Public License as published by 
+  the Free Software Foundation, either version 3 of the License, or 
+  (at your option) any later version. 
+
+  This program is distributed in the hope that it will be useful, 
+  but WITHOUT ANY WARRANTY; without even the implied warranty of 
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the 
+  GNU General Public License for more details. 
+
+  You should have received a copy of the GNU General Public License 
+  along with this program. If not, see <http://www.gnu.org/licenses/>. 
+*/
+
+#ifndef _AQ_BIQUAD_FILTER_H_
+#define _AQ_BIQUAD_FILTER_H_
+
+////////////////////////////////////////////////////////////////////////////////
+//
+// IIR filter as a cascade of second order sections (biquads) in direct form II
+// transposed, filtering CHANNELS signals of the same sample rate together, for
+// instance the three axes of a sensor.
+//
+// The design is a type holding the sections of one filter at one sample rate,
+// a sensor running at another rate needs its own design:
+//
+//   struct SomeLowPass100Hz {
+//     enum { sections = 2 };
+//     static const biquadSection section[sections];
+//   };
+//   const biquadSection SomeLowPass100Hz::section[] = {{b0, b1, b2, a1, a2}, ...};
+//
+//   BiquadCascade<SomeLowPass100Hz, 3> someFilter;
+//
+// The coefficients are constants known where filter() is compiled, so they are
+// folded into the code like the #defines of the fourth order filter this replaces.
+// Each section should have unity gain at DC, steady values then pass every section
+// unchanged and initialize() can start the filter settled on them.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include <GlobalDefined.h>
+
+struct biquadSection
+{
+  float b0, b1, b2; // numerator
+  float a1, a2;     // denominator, a0 = 1
+};
+
+template <class Design, byte CHANNELS> class BiquadCascade 
+{
+public:
+  // state of every section, the channels next to each other
+  float state1[Design::sections][CHANNELS];
+  float state2[Design::sections][CHANNELS];
+
+  // settle every channel on a steady input
+  void initialize(const float *steadyInput) 
+  {
+    for (byte channel = 0; channel < CHANNELS; channel++) 
+    {
+      float value = steadyInput[channel];
+      for (byte index = 0; index < Design::sections; index++) 
+      {
+        const biquadSection &section = Design::section[index];
+        float output = value * (section.b0 + section.b1 + section.b2) / (1.0 + section.a1 + section.a2);
+        state1[index][channel] = output - section.b0 * value;
+        state2[index][channel] = section.b2 * value - section.a2 * output;
+        value = output;
+      }
+    }
+  }
+
+  // filters one sample of each channel, output may be the input array
+  void filter(const float *input, float *output) 
+  {
+    if (output != input) 
+    {
+      for (byte channel = 0; channel < CHANNELS; channel++) 
+      {
+        output[channel] = input[channel];
+      }
+    }
+    for (byte index = 0; index < Design::sections; index++) 
+    {
+      const biquadSection &section = Design::section[index];
+      for (byte channel = 0; channel < CHANNELS; channel++) 
+      {
+        float in = output[channel];
+        float out = section.b0 * in + state1[index][channel];
+        state1[index][channel] = section.b1 * in - section.a1 * out + state2[index][channel];
+        state2[index][channel] = section.b2 * in - section.a2 * out;
+        output[channel] = out;
+      }
+    }
+  }
+};
+
+#if defined(FixedPointKernels)
+  #include "FixedPoint.h"
+
+  // Same filter in fixed point, Q2.30 coefficients on Q16.16 samples. Direct form I
+  // keeps the last two inputs and outputs of every section and sums the five products
+  // with 4 more fraction bits, so a section rounds once, into its output, instead of
+  // into each state.
+  // The output of a section is the input of the next, they share their delay line.
+  template <class Design, byte CHANNELS> class BiquadCascadeFixed 
+  {
+  public:
+    int32_t coefficient[Design::sections][5]; // b0, b1, b2, a1, a2
+    // delay line of the input and of every section output, the channels next to each other
+    int32_t delay1[Design::sections + 1][CHANNELS];
+    int32_t delay2[Design::sections + 1][CHANNELS];
+
+    void initialize(const float *steadyInput) 
+    {
+      for (byte index = 0; index < Design::sections; index++) 
+      {
+        const biquadSection &section = Design::section[index];
+        coefficient[index][0] = floatToQ30(section.b0);
+        coefficient[index][1] = floatToQ30(section.b1);
+        coefficient[index][2] = floatToQ30(section.b2);
+        coefficient[index][3] = floatToQ30(section.a1);
+        coefficient[index][4] = floatToQ30(section.a2);
+      }
+      for (byte channel = 0; channel < CHANNELS; channel++) 
+      {
+        float value = steadyInput[channel];
+        delay1[0][channel] = delay2[0][channel] = floatToFixed(value);
+        for (byte index = 0; index < Design::sections; index++) 
+        {
+          const biquadSection &section = Design::section[index];
+          value = value * (section.b0 + section.b1 + section.b2) / (1.0 + section.a1 + section.a2);
+          delay1[index + 1][channel] = delay2[index + 1][channel] = floatToFixed(value);
+        }
+      }
+    }
+
+    // filters one sample of each channel, output may be the input array
+    void filter(const float *input, float *output) 
+    {
+      for (byte channel = 0; channel < CHANNELS; channel++) 
+      {
+        int32_t in = floatToFixed(input[channel]);
+        for (byte index = 0; index < Design::sections; index++) 
+        {
+          const int32_t *c = coefficient[index];
+          // Q12.20, +-2048 m/s/s
+          int32_t sum = multiplyShift(in, c[0], 26) + 
+                        multiplyShift(delay1[index][channel], c[1], 26) + 
+                        multiplyShift(delay2[index][channel], c[2], 26) - 
+                        multiplyShift(delay1[index + 1][channel], c[3], 26) - 
+                        multiplyShift(delay2[index + 1][channel], c[4], 26);
+          delay2[index][channel] = delay1[index][channel];
+          delay1[index][channel] = in;
+          in = (sum + (1L << 3)) >> 4;
+        }
+        delay2[Design::sections][channel] = delay1[Design::sections][channel];
+        delay1[Design::sections][channel] = in;
+        output[channel] = fixedToFloat(in);
+      }
+    }
+
+    // Q16.16 output of the last filter() call, for the fixed point code it feeds
+    const int32_t *fixedOutput() 
+    {
+      return delay1[Design::sections];
+    }
+  };
+#endif
+
+////////////////////////////////////////////////////////////////////////////////
+// Designs
+////////////////////////////////////////////////////////////////////////////////
+
+// Accelerometer in the 100Hz task: cheby2(4,60,12.5/50), 60dB down from 12.5Hz,
+// the poles and zeros of the former fourth order filter paired into two sections
+struct AccelLowPass100Hz 
+{
+  enum { sections = 2 };
+  static const biquadSection section[sections];
+};
+
+const biquadSection AccelLowPass100Hz::section[AccelLowPass100Hz::sections] = {
+  {0.023546739786407,  0.003720788645001, 0.023546739786407, -1.578690313089090, 0.629504581306904},
+  {0.080418523572378, -0.106999240924550, 0.080418523572378, -1.783566576120232, 0.837404382340438}
+};
+
+#endif
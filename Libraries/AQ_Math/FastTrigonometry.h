@@ -0,0 +1,162 @@
+/*
+  AeroQuad v3.0.1 - February 2012
+  www.AeroQuad.com
+  Copyright (c) 2012 Ted Carancho.  All rights reserved.
+  An Open Source Arduino based multicopter.
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef _AQ_FAST_TRIGONOMETRY_H_
+#define _AQ_FAST_TRIGONOMETRY_H_
+
+////////////////////////////////////////////////////////////////////////////////
+//
+// Trigonometry of the attitude and heading code. With FastTrigonometry defined
+// these are the approximations below, otherwise the libm functions. Largest
+// error against libm in double, measured by AeroQuadSIL/Math/TrigBench.cpp:
+//
+// fastAtan2  1.2e-5 rad  minimax odd polynomial of degree 9 for atan on 0..1,
+//                        the other octants by symmetry, one division
+// fastAsin   4.0e-6 rad  minimax odd polynomial of degree 7 on 0..0.5, then
+//                        pi/2 - sqrt(1 - x) times a minimax cubic on 0.5..1,
+//                        arguments beyond +-1 from rounding give +-pi/2
+// fastSin    9.0e-7      minimax odd polynomial of degree 7 on -pi/2..pi/2
+// fastCos    1.3e-6      after the reduction in float, within two turns
+// fastSqrt   5e-6 rel.   bit trick and two Newton steps on the inverse, libm
+//                        on AVR where sqrt is assembler as fast as a division
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include "Arduino.h"
+#include <math.h>
+
+#if defined(FastTrigonometry)
+
+  inline float fastSqrt(float x)
+  {
+    #if defined(__AVR__)
+      return sqrt(x);
+    #else
+      union {
+        int32_t i;
+        float   f;
+      } conv;
+      conv.f = x;
+      conv.i = 0x5f3759df - (conv.i >> 1);
+      float inverse = conv.f;
+      inverse = inverse * (1.5f - 0.5f * x * inverse * inverse);
+      inverse = inverse * (1.5f - 0.5f * x * inverse * inverse);
+      return x * inverse;
+    #endif
+  }
+
+  // atan of 0..1
+  inline float fastAtanUnit(float x)
+  {
+    float x2 = x * x;
+    return x * (0.99986633f + x2 * (-0.33030480f + x2 * (0.18015930f + x2 * (-0.08515633f + x2 * 0.02084510f))));
+  }
+
+  inline float fastAtan2(float y, float x)
+  {
+    float absX = fabs(x);
+    float absY = fabs(y);
+    float angle;
+    if (absY <= absX)
+    {
+      angle = absX > 0.0f ? fastAtanUnit(absY / absX) : 0.0f;
+    }
+    else
+    {
+      angle = (float)(PI / 2) - fastAtanUnit(absX / absY);
+    }
+    if (x < 0.0f)
+    {
+      angle = (float)PI - angle;
+    }
+    return y < 0.0f ? -angle : angle;
+  }
+
+  inline float fastAsin(float x)
+  {
+    float absX = fabs(x);
+    float angle;
+    if (absX < 0.5f)
+    {
+      float x2 = absX * absX;
+      angle = absX * (0.99999284f + x2 * (0.16703115f + x2 * (0.07006122f + x2 * 0.06830613f)));
+    }
+    else if (absX < 1.0f)
+    {
+      angle = (float)(PI / 2) - fastSqrt(1.0f - absX) * (1.56915762f + absX * (-0.20387446f + absX * (0.06099524f + absX * -0.01207496f)));
+    }
+    else
+    {
+      angle = (float)(PI / 2);
+    }
+    return x < 0.0f ? -angle : angle;
+  }
+
+  inline float fastSin(float x)
+  {
+    // to -pi..pi, then to -pi/2..pi/2 by sin(x) = sin(pi - x)
+    x -= (float)(2 * PI) * floor(x * (float)(1 / (2 * PI)) + 0.5f);
+    if (x > (float)(PI / 2))
+    {
+      x = (float)PI - x;
+    }
+    else if (x < (float)(-PI / 2))
+    {
+      x = (float)-PI - x;
+    }
+    float x2 = x * x;
+    return x * (0.99999662f + x2 * (-0.16664828f + x2 * (0.00830633f + x2 * -0.00018364f)));
+  }
+
+  inline float fastCos(float x)
+  {
+    return fastSin(x + (float)(PI / 2));
+  }
+
+#else
+
+  inline float fastSqrt(float x)
+  {
+    return sqrt(x);
+  }
+
+  inline float fastAtan2(float y, float x)
+  {
+    return atan2(y, x);
+  }
+
+  inline float fastAsin(float x)
+  {
+    return asin(x);
+  }
+
+  inline float fastSin(float x)
+  {
+    return sin(x);
+  }
+
+  inline float fastCos(float x)
+  {
+    return cos(x);
+  }
+
+#endif
+
+#endif
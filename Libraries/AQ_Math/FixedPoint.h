@@ -0,0 +1,226 @@
+/*
+  AeroQuad v3.0.1 - February 2012
+  www.AeroQuad.com
+  Copyright (c) 2012 Ted Carancho.  All rights reserved.
+  An Open Source Arduino based multicopter.
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef _AQ_FIXED_POINT_H_
+#define _AQ_FIXED_POINT_H_
+
+////////////////////////////////////////////////////////////////////////////////
+//
+// Fixed point arithmetic of the kernels selected with FixedPointKernels, for the
+// ATmega boards that run every float operation in software.
+//
+// Q16.16: int32_t with 16 fraction bits, +-32768 with a resolution of 1.5e-5,
+//         for sensor values and stick values
+// Q8.24:  int32_t with 24 fraction bits, +-128 with a resolution of 6.0e-8,
+//         for rotation rates that are integrated over a long time
+// Q2.30:  int32_t with 30 fraction bits, +-2 with a resolution of 9.3e-10,
+//         for unit vectors, quaternions, gains and filter coefficients
+//
+// Products are never formed in 64 bits, a 64 bit multiply is a library call on
+// the ATmega that costs more than the soft-float multiply it replaces. The rounded
+// high part of a product is summed from the four 16x16 bit partial products that
+// the hardware multiplier gives in a few instructions each, or the operands are
+// shifted down to Q1.15 first where their range and the resolution needed allow
+// it. Floats are only converted where a kernel meets the float code around it.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include "Arduino.h"
+
+#define FIXED_ONE 65536L
+#define Q24_ONE   16777216L
+#define Q30_ONE   1073741824L
+
+#ifndef INT32_MAX
+  #define INT32_MAX 0x7FFFFFFFL
+  #define INT32_MIN (-INT32_MAX - 1)
+#endif
+
+// rounds a scaled float to the nearest int32_t, saturated at INT32_MIN and INT32_MAX as the
+// conversion of a float out of range is undefined, a NaN gives INT32_MAX
+inline int32_t roundSaturated(float scaled)
+{
+  if (!(scaled < 2147483648.0))
+  {
+    return INT32_MAX;
+  }
+  if (scaled <= -2147483648.0)
+  {
+    return INT32_MIN;
+  }
+  return (int32_t)(scaled + (scaled < 0 ? -0.5 : 0.5));
+}
+
+inline int32_t floatToFixed(float value)
+{
+  return roundSaturated(value * FIXED_ONE);
+}
+
+inline float fixedToFloat(int32_t value)
+{
+  return value * (1.0 / FIXED_ONE);
+}
+
+inline int32_t floatToQ24(float value)
+{
+  return roundSaturated(value * Q24_ONE);
+}
+
+inline int32_t floatToQ30(float value)
+{
+  return roundSaturated(value * Q30_ONE);
+}
+
+inline float q30ToFloat(int32_t value)
+{
+  return value * (1.0 / Q30_ONE);
+}
+
+// Q2.30 to Q1.15 for values within -1..1, the product of two is a Q2.30 in 32 bits
+inline int32_t q30ToQ15(int32_t value)
+{
+  return (value + (1L << 14)) >> 15;
+}
+
+// a * b / 2^shift rounded to the nearest, for shift 16..31 and a result within 32 bits,
+// from 32 bit partial products only. Every part of the product below the result is
+// summed with the rounding bit before it's shifted out, so it's the same as rounding
+// the full 64 bit product.
+inline int32_t multiplyShift(int32_t a, int32_t b, byte shift)
+{
+  int16_t aHigh = a >> 16, bHigh = b >> 16;
+  uint16_t aLow = a, bLow = b;
+  uint32_t high = (uint32_t)((int32_t)aHigh * bHigh) << (32 - shift);
+  int32_t cross1 = (int32_t)aHigh * bLow;
+  int32_t cross2 = (int32_t)bHigh * aLow;
+  uint32_t low = (uint32_t)aLow * bLow;
+  if (shift == 16)
+  {
+    return (int32_t)(high + cross1 + cross2 + ((low + (1UL << 15)) >> 16));
+  }
+  byte crossShift = shift - 16;
+  uint32_t crossMask = (1UL << crossShift) - 1;
+  uint32_t below = ((uint32_t)cross1 & crossMask) + ((uint32_t)cross2 & crossMask) + (low >> 16) + (1UL << (crossShift - 1));
+  return (int32_t)(high + (cross1 >> crossShift) + (cross2 >> crossShift) + (below >> crossShift));
+}
+
+// any Q * Q2.30 keeping the format of the first
+inline int32_t q30Multiply(int32_t a, int32_t b)
+{
+  return multiplyShift(a, b, 30);
+}
+
+// Q16.16 copy of a float that the configuration may change at any time. The float
+// is converted again only when its bits changed, a compare instead of a soft-float
+// multiply and conversion on every use.
+struct fixedCache
+{
+  int32_t bits;
+  int32_t value;
+};
+
+inline int32_t cachedFloatToFixed(float value, struct fixedCache *cache)
+{
+  union {
+    int32_t i;
+    float   f;
+  } conv;
+  conv.f = value;
+  if (conv.i != cache->bits)
+  {
+    cache->bits = conv.i;
+    cache->value = floatToFixed(value);
+  }
+  return cache->value;
+}
+
+// Scales a vector of any length and format to a Q2.30 unit vector. The vector is
+// shifted until its largest element is within 0.5..1, then multiplied by the inverse
+// square root of the sum of squares from two Newton steps on a linear first guess
+// per octave, 2e-5 relative at worst and exact to the last bit near a length of 1.
+void fixedNormalize(int32_t *vector, byte length)
+{
+  int32_t largest = 0;
+  for (byte index = 0; index < length; index++)
+  {
+    int32_t magnitude = vector[index] < 0 ? -vector[index] : vector[index];
+    if (magnitude > largest)
+    {
+      largest = magnitude;
+    }
+  }
+  if (largest == 0)
+  {
+    return;
+  }
+  byte shift = 0;
+  while ((largest << shift) < (Q30_ONE / 2))
+  {
+    shift++;
+  }
+  while (largest >= Q30_ONE)
+  {
+    largest >>= 1;
+    for (byte index = 0; index < length; index++)
+    {
+      vector[index] >>= 1;
+    }
+  }
+
+  // sum of squares in Q3.29, 0.25..length
+  int32_t square = 0;
+  for (byte index = 0; index < length; index++)
+  {
+    vector[index] <<= shift;
+    square += multiplyShift(vector[index], vector[index], 31);
+  }
+
+  // first guess 1 - (m - 1) * (1 - 1/sqrt(2)) for the mantissa m in 1..2 of the sum, scaled
+  // by 1/sqrt(2) per octave, in Q3.29
+  int32_t mantissa = square;
+  int32_t scale = 1L << 29;
+  while (mantissa >= (1L << 30))
+  {
+    mantissa >>= 1;
+    scale = q30Multiply(scale, 759250125L); // 1/sqrt(2)
+  }
+  while (mantissa < (1L << 29))
+  {
+    mantissa <<= 1;
+    scale = q30Multiply(scale, 1518500250L); // sqrt(2)
+  }
+  int32_t guess = (1L << 29) - q30Multiply(mantissa - (1L << 29), 314491699L); // 1 - 1/sqrt(2)
+  int32_t inverse = multiplyShift(guess, scale, 29);
+
+  // y = y * (3 - x * y * y) / 2, all of them within 0.25..4 in Q3.29
+  for (byte step = 0; step < 2; step++)
+  {
+    int32_t inverseSquare = multiplyShift(inverse, inverse, 29);
+    int32_t product = multiplyShift(square, inverseSquare, 29);
+    inverse = multiplyShift(inverse, (3L << 29) - product, 30);
+  }
+
+  for (byte index = 0; index < length; index++)
+  {
+    vector[index] = multiplyShift(vector[index], inverse, 29);
+  }
+}
+
+#endif
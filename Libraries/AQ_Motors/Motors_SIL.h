@@ -0,0 +1,55 @@
+/*
+  AeroQuad v3.x
+  www.AeroQuad.com
+  Copyright (c) 2012 Ted Carancho.  All rights reserved.
+  An Open Source Arduino based multicopter.
+ 
+  This program is free software: you can redistribute it and/or modify 
+  it under the terms of the GNU General Public License as published by 
+  the Free Software Foundation, either version 3 of the License, or 
+  (at your option) any later version. 
+
+  This program is distributed in the hope that it will be useful, 
+  but WITHOUT ANY WARRANTY; without even the implied warranty of 
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the 
+  GNU General Public License for more details. 
+
+  You should have received a copy of the GNU General Public License 
+  along with this program. If not, see <http://www.gnu.org/licenses/>. 
+*/
+
+#ifndef _AEROQUAD_MOTORS_SIL_H_
+#define _AEROQUAD_MOTORS_SIL_H_
+
+#if defined(AeroQuadSIL)
+
+#include "Motors.h"
+
+// Motor outputs of the Linux host build.
+// writeMotors() latches the commands the way the PWM timers do on the real
+// boards, the test harness reads them back from silMotorOutput[]
+
+int silMotorOutput[8] = {0,0,0,0,0,0,0,0};
+unsigned long silMotorWriteCount = 0;
+static int _sil_motor_number = 0;
+
+void initializeMotors(NB_Motors numbers) {
+  _sil_motor_number = numbers;
+  commandAllMotors(1000);
+}
+
+void writeMotors() {
+  for (int motor = 0; motor < _sil_motor_number; motor++) {
+    silMotorOutput[motor] = motorCommand[motor];
+  }
+  silMotorWriteCount++;
+}
+
+void commandAllMotors(int command) {
+  for (int motor = 0; motor < _sil_motor_number; motor++) {
+    silMotorOutput[motor] = command;
+  }
+}
+
+#endif
+#endif
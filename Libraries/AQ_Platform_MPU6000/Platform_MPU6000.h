@@ -31,6 +31,29 @@
 
 //#define MPU6000_I2C	// insert this define before #include <Platform_MPU6000.h> when you use a I2C based MPU6050
 
+// FIFO mode, the MPU6000 samples at 1kHz on its own and the gyro/accel sums get all samples of
+// the batch. On I2C the whole FIFO is read once per control cycle, on SPI the FIFO is drained in
+// the background by DMA bursts, see pollMPU6000Fifo()
+//#define MPU6000_FIFO	// insert this define before #include <Platform_MPU6000.h> to use the FIFO
+
+// Data ready interrupt mode (SPI only), each sample is read by the EXTI handler of the MPU6000 INT
+// pin and summed into one half of a double buffer, the flight loop takes the other half once per
+// control cycle
+//#define MPU6000_INT_PIN	// define as the pin the MPU6000 INT output is wired to
+
+#if defined(MPU6000_INT_PIN) && defined(MPU6000_I2C)
+  #error "MPU6000_INT_PIN needs the MPU6000 on SPI"
+#endif
+#if defined(MPU6000_INT_PIN) && defined(MPU6000_FIFO)
+  #error "MPU6000_INT_PIN and MPU6000_FIFO are exclusive"
+#endif
+#if defined(MPU6000_INT_PIN) || defined(MPU6000_FIFO)
+  #define MPU6000_BATCH	// several samples per control cycle, see MPU6000Batch
+#endif
+#if defined(MPU6000_FIFO) && !defined(MPU6000_I2C)
+  #define MPU6000_FIFO_DMA
+#endif
+
 // MPU 6000 registers
 #define MPUREG_WHOAMI			0x75
 #define MPUREG_SMPLRT_DIV		0x19
@@ -88,6 +111,14 @@
 #define BIT_RAW_RDY_EN			0x01
 #define BIT_I2C_IF_DIS          0x10
 #define BIT_INT_STATUS_DATA		0x01
+#define BIT_FIFO_EN				0x40
+#define BIT_FIFO_RESET			0x04
+#define BITS_FIFO_ACCEL_GYRO	0x78	// XG, YG, ZG and ACCEL, no temperature
+
+#define MPU6000_FIFO_SIZE			1024
+#define MPU6000_FIFO_SAMPLE_SIZE	12	// accel x,y,z then gyro x,y,z
+#define MPU6000_FIFO_MAX_SAMPLES	16	// samples per burst
+#define MPU6000_I2C_CHUNK			24	// fits into the Wire buffer
 
 
 typedef struct {
@@ -97,8 +128,8 @@ typedef struct {
 } tAxis;
 
 union uMPU6000 {
-  unsigned char rawByte[];
-  unsigned short rawWord[];
+  unsigned char rawByte[14];
+  unsigned short rawWord[7];
   struct {
 	tAxis accel;
 	short temperature;
@@ -106,11 +137,38 @@ union uMPU6000 {
   } data;
 } MPU6000;
 
+#ifdef MPU6000_BATCH
+  // sums of the samples taken since the last control cycle, MPU6000.data holds the newest sample
+  struct tMPU6000Batch {
+    long accel[3];
+    long gyro[3];
+    unsigned int count; // several hundred when the flight loop did not take a batch for a while
+    unsigned long time; // micros() of the newest sample
+  } MPU6000Batch;
+#endif
+
 
 #ifdef MPU6000_I2C
   #ifndef MPU6000_I2C_ADDRESS
 	#define MPU6000_I2C_ADDRESS 0x68
   #endif
+  #ifdef I2C_QUEUE
+    #include <I2C_Queue.h>
+
+    byte MPU6000I2CData[sizeof(MPU6000)];
+
+    void MPU6000I2CReadDone(struct I2CTransaction *transaction) {
+      if (transaction->status == I2C_DONE) {
+        for (byte i = 0; i < sizeof(MPU6000)/sizeof(short); i++) {
+          MPU6000.rawWord[i] = (MPU6000I2CData[2*i] << 8) | MPU6000I2CData[2*i+1];
+        }
+      }
+    }
+
+    struct I2CTransaction MPU6000I2CRead = {MPU6000_I2C_ADDRESS, I2C_PRIORITY_HIGH, 1, {MPUREG_ACCEL_XOUT_H}, sizeof(MPU6000), MPU6000I2CData, MPU6000I2CReadDone};
+    // register and length are set by MPU6000_ReadBurst()
+    struct I2CTransaction MPU6000I2CBurst = {MPU6000_I2C_ADDRESS, I2C_PRIORITY_HIGH, 1, {0}, 0, NULL, NULL};
+  #endif
 #else
   #include <HardwareSPIExt.h>
   HardwareSPIExt spiMPU6000(4);
@@ -153,6 +211,46 @@ byte MPU6000_ReadReg(int addr)
   return data;
 }
 
+// flight loop read of several registers or the FIFO, no delay
+void MPU6000_ReadBurst(byte addr, byte *data, int dataLen)
+{
+  #if defined(MPU6000_I2C) && defined(I2C_QUEUE) && defined(WIRE_ASYNC_TRANSFER)
+    MPU6000I2CBurst.txData[0] = addr;
+    MPU6000I2CBurst.rxData = data;
+    MPU6000I2CBurst.rxLength = dataLen;
+    queueI2CTransaction(&MPU6000I2CBurst);
+    waitI2CTransaction(&MPU6000I2CBurst);
+  #elif defined(MPU6000_I2C)
+    // the register is sent again for each chunk, MPUREG_FIFO_R_W is not incremented
+    while (dataLen > 0) {
+      byte chunk = min(dataLen, MPU6000_I2C_CHUNK);
+      sendByteI2C(MPU6000_I2C_ADDRESS, addr);
+      Wire.requestFrom(MPU6000_I2C_ADDRESS, (int)chunk);
+      for (byte i = 0; i < chunk; i++) {
+        *data++ = readByteI2C();
+      }
+      dataLen -= chunk;
+    }
+  #else
+    spiMPU6000.Read(addr, data, dataLen);
+  #endif
+}
+
+void MPU6000_ResetFifo()
+{
+  byte userCtrl = BIT_FIFO_EN | BIT_FIFO_RESET;
+  #ifdef MPU6000_I2C
+    updateRegisterI2C(MPU6000_I2C_ADDRESS, MPUREG_USER_CTRL, userCtrl);
+  #else
+    userCtrl |= BIT_I2C_IF_DIS;
+    spiMPU6000.Write(MPUREG_USER_CTRL, userCtrl);
+  #endif
+}
+
+#ifdef MPU6000_INT_PIN
+  void initializeMPU6000Interrupt();
+#endif
+
 bool initializeMPU6000SensorsDone = false;
 void initializeMPU6000Sensors()
 {
@@ -195,9 +293,17 @@ void initializeMPU6000Sensors()
   MPU6000_WriteReg(MPUREG_GYRO_CONFIG,BITS_FS_1000DPS);  // Gyro scale 1000/s
   MPU6000_WriteReg(MPUREG_ACCEL_CONFIG,0x08);   // Accel scale +-4g (4096LSB/g)
 
+  #ifdef MPU6000_FIFO
+    MPU6000_WriteReg(MPUREG_FIFO_EN, BITS_FIFO_ACCEL_GYRO);
+    MPU6000_ResetFifo();
+  #endif
 
   // switch to high clock rate
   MPU6000_SpiHighSpeed();
+
+  #ifdef MPU6000_INT_PIN
+    initializeMPU6000Interrupt();
+  #endif
 }
 
 
@@ -212,9 +318,75 @@ void MPU6000SwapData(unsigned char *data, int datalen)
   }
 }
 
+#ifdef MPU6000_INT_PIN
+  // double buffer written by the data ready handler, MPU6000WriteBuffer is the half it fills.
+  // The handler cannot be interrupted by the flight loop, so flipping the index is enough to
+  // hand over a complete half without locking.
+  struct tMPU6000Batch MPU6000Buffers[2];
+  volatile byte MPU6000WriteBuffer = 0;
+  union uMPU6000 MPU6000Latest;
+  volatile unsigned long MPU6000InterruptSamples = 0;
+
+  void MPU6000DataReady()
+  {
+    struct tMPU6000Batch *buffer = &MPU6000Buffers[MPU6000WriteBuffer];
+    // reading the data registers clears the interrupt, see BIT_INT_ANYRD_2CLEAR
+    spiMPU6000.Read(MPUREG_ACCEL_XOUT_H, MPU6000Latest.rawByte, sizeof(MPU6000Latest));
+    MPU6000SwapData(MPU6000Latest.rawByte, sizeof(MPU6000Latest));
+    buffer->accel[0] += MPU6000Latest.data.accel.x;
+    buffer->accel[1] += MPU6000Latest.data.accel.y;
+    buffer->accel[2] += MPU6000Latest.data.accel.z;
+    buffer->gyro[0] += MPU6000Latest.data.gyro.x;
+    buffer->gyro[1] += MPU6000Latest.data.gyro.y;
+    buffer->gyro[2] += MPU6000Latest.data.gyro.z;
+    buffer->count++;
+    buffer->time = micros();
+    MPU6000InterruptSamples++;
+  }
+
+  void initializeMPU6000Interrupt()
+  {
+    MPU6000_WriteReg(MPUREG_INT_PIN_CFG, BIT_INT_ANYRD_2CLEAR);
+    MPU6000_WriteReg(MPUREG_INT_ENABLE, BIT_RAW_RDY_EN);
+    pinMode(MPU6000_INT_PIN, INPUT);
+    attachInterrupt(MPU6000_INT_PIN, MPU6000DataReady, RISING);
+  }
+
+  // takes the half filled since the last call
+  void swapMPU6000Buffers()
+  {
+    byte readBuffer = MPU6000WriteBuffer;
+    MPU6000WriteBuffer = readBuffer ^ 1;
+    struct tMPU6000Batch *buffer = &MPU6000Buffers[readBuffer];
+    unsigned long previousTime = MPU6000Batch.time;
+    MPU6000Batch = *buffer;
+    memset(buffer, 0, sizeof(*buffer));
+    if (MPU6000Batch.count == 0) {
+      MPU6000Batch.time = previousTime; // no sample since the last call, the newest is still the previous one
+    }
+
+    noInterrupts();
+    MPU6000 = MPU6000Latest;
+    interrupts();
+  }
+#endif
+
 void readMPU6000Sensors()
 {
-  #ifdef MPU6000_I2C
+  #if defined(MPU6000_INT_PIN)
+    // the bus belongs to the data ready handler once it runs
+    if (MPU6000InterruptSamples > 0) {
+      noInterrupts();
+      MPU6000 = MPU6000Latest;
+      interrupts();
+      return;
+    }
+    spiMPU6000.Read(MPUREG_ACCEL_XOUT_H, MPU6000.rawByte, sizeof(MPU6000));
+    MPU6000SwapData(MPU6000.rawByte, sizeof(MPU6000));
+  #elif defined(MPU6000_I2C) && defined(I2C_QUEUE)
+    queueI2CTransaction(&MPU6000I2CRead);
+    waitI2CTransaction(&MPU6000I2CRead);
+  #elif defined(MPU6000_I2C)
     sendByteI2C(MPU6000_I2C_ADDRESS, MPUREG_ACCEL_XOUT_H);
     Wire.requestFrom(MPU6000_I2C_ADDRESS, sizeof(MPU6000));
     for(byte i=0; i<sizeof(MPU6000)/sizeof(short); i++) {
@@ -226,6 +398,153 @@ void readMPU6000Sensors()
   #endif
 }
 
+#ifdef MPU6000_FIFO
+  unsigned long MPU6000FifoSamples = 0;
+  unsigned long MPU6000FifoOverflows = 0;
+
+  byte MPU6000FifoData[MPU6000_FIFO_MAX_SAMPLES * MPU6000_FIFO_SAMPLE_SIZE];
+
+  // number of whole samples in the FIFO
+  int readMPU6000FifoCount()
+  {
+    byte countBytes[2];
+    MPU6000_ReadBurst(MPUREG_FIFO_COUNTH, countBytes, 2);
+    int fifoCount = (countBytes[0] << 8) | countBytes[1];
+    if (fifoCount > MPU6000_FIFO_SIZE - MPU6000_FIFO_SAMPLE_SIZE) {
+      // full, old samples were overwritten and the sample boundaries are lost
+      MPU6000_ResetFifo();
+      MPU6000FifoOverflows++;
+      return 0;
+    }
+    return fifoCount / MPU6000_FIFO_SAMPLE_SIZE;
+  }
+
+  void addMPU6000FifoSamples(struct tMPU6000Batch *batch, byte samples)
+  {
+    byte *sample = MPU6000FifoData;
+    for (byte i = 0; i < samples; i++) {
+      for (byte word = 0; word < MPU6000_FIFO_SAMPLE_SIZE/2; word++) {
+        short value = (sample[2*word] << 8) | sample[2*word+1];
+        if (word < 3) {
+          batch->accel[word] += value;
+          MPU6000.rawWord[word] = value;
+        }
+        else {
+          batch->gyro[word - 3] += value;
+          MPU6000.rawWord[word + 1] = value; // skip temperature
+        }
+      }
+      sample += MPU6000_FIFO_SAMPLE_SIZE;
+    }
+    batch->count += samples;
+    MPU6000FifoSamples += samples;
+  }
+
+  #ifdef MPU6000_FIFO_DMA
+    struct tMPU6000Batch MPU6000FifoBatch; // bursts received since the last control cycle
+    byte MPU6000FifoBurst = 0;             // samples of the running burst
+    unsigned long MPU6000FifoBurstTime = 0;
+    unsigned long MPU6000FifoErrors = 0;
+
+    // takes a finished burst and starts the next one, never waits for the SPI bus.
+    // Call it about every 1 ms from the flight loop so the burst of the control cycle is short.
+    void pollMPU6000Fifo()
+    {
+      if (MPU6000FifoBurst > 0) {
+        byte status = spiMPU6000.ReadDMAStatus();
+        if (status == SPI_DMA_BUSY) {
+          return;
+        }
+        if (status == SPI_DMA_DONE) {
+          addMPU6000FifoSamples(&MPU6000FifoBatch, MPU6000FifoBurst);
+          MPU6000FifoBatch.time = MPU6000FifoBurstTime;
+        }
+        else {
+          // cut short, the sample boundaries are lost like in a full FIFO
+          MPU6000_ResetFifo();
+          MPU6000FifoErrors++;
+        }
+        MPU6000FifoBurst = 0;
+      }
+
+      int samples = readMPU6000FifoCount();
+      if (samples > 0) {
+        MPU6000FifoBurst = min(samples, MPU6000_FIFO_MAX_SAMPLES);
+        MPU6000FifoBurstTime = micros();
+        spiMPU6000.ReadDMAStart(MPUREG_FIFO_R_W, MPU6000FifoData, MPU6000FifoBurst * MPU6000_FIFO_SAMPLE_SIZE);
+      }
+    }
+
+    // takes the bursts received since the last call, a burst still running goes into the next batch
+    void readMPU6000Fifo()
+    {
+      pollMPU6000Fifo();
+      unsigned long previousTime = MPU6000Batch.time;
+      MPU6000Batch = MPU6000FifoBatch;
+      memset(&MPU6000FifoBatch, 0, sizeof(MPU6000FifoBatch));
+      if (MPU6000Batch.count == 0) {
+        MPU6000Batch.time = previousTime; // no sample since the last call, the newest is still the previous one
+      }
+    }
+  #else
+    void readMPU6000Fifo()
+    {
+      for (byte axis = 0; axis < 3; axis++) {
+        MPU6000Batch.accel[axis] = 0;
+        MPU6000Batch.gyro[axis] = 0;
+      }
+      MPU6000Batch.count = 0;
+
+      int samples = readMPU6000FifoCount();
+      while (samples > 0) {
+        byte burst = min(samples, MPU6000_FIFO_MAX_SAMPLES);
+        MPU6000_ReadBurst(MPUREG_FIFO_R_W, MPU6000FifoData, burst * MPU6000_FIFO_SAMPLE_SIZE);
+        addMPU6000FifoSamples(&MPU6000Batch, burst);
+        samples -= burst;
+      }
+      if (MPU6000Batch.count > 0) {
+        MPU6000Batch.time = micros();
+      }
+    }
+  #endif
+#endif
+
+// flight loop read, with the I2C queue it only starts the next read and the data
+// of the previous one is used
+void requestMPU6000Sensors()
+{
+  #if defined(MPU6000_FIFO)
+    readMPU6000Fifo();
+  #elif defined(MPU6000_INT_PIN)
+    swapMPU6000Buffers();
+  #elif defined(MPU6000_I2C) && defined(I2C_QUEUE)
+    queueI2CTransaction(&MPU6000I2CRead);
+  #else
+    readMPU6000Sensors();
+  #endif
+}
+
+#ifdef MPU6000_BATCH
+  // drops the samples taken during the setup delays, call it right before the first control cycle
+  void resetMPU6000Batch()
+  {
+    #if defined(MPU6000_FIFO_DMA)
+      spiMPU6000.ReadDMAWait();
+      MPU6000FifoBurst = 0;
+      memset(&MPU6000FifoBatch, 0, sizeof(MPU6000FifoBatch));
+      MPU6000_ResetFifo();
+    #elif defined(MPU6000_FIFO)
+      MPU6000_ResetFifo();
+    #elif defined(MPU6000_INT_PIN)
+      noInterrupts();
+      memset(MPU6000Buffers, 0, sizeof(MPU6000Buffers));
+      interrupts();
+    #endif
+    memset(&MPU6000Batch, 0, sizeof(MPU6000Batch));
+    MPU6000Batch.time = micros();
+  }
+#endif
+
 int readMPU6000Count=0;
 int readMPU6000AccelCount=0;
 int readMPU6000GyroCount=0;
@@ -234,7 +553,7 @@ void readMPU6000Accel()
 {
   readMPU6000AccelCount++;
   if(readMPU6000AccelCount != readMPU6000Count) {
-    readMPU6000Sensors();
+    requestMPU6000Sensors();
     readMPU6000Count++;
   }
 }
@@ -243,8 +562,8 @@ void readMPU6000Gyro()
 {
   readMPU6000GyroCount++;
   if(readMPU6000GyroCount != readMPU6000Count) {
-    readMPU6000Sensors();
-    readMPU6000GyroCount++;
+    requestMPU6000Sensors();
+    readMPU6000Count++;
   }
 }
 #endif
@@ -84,15 +84,135 @@ void initializeReceiverParam(int nbChannel = 6) {
   
 int getRawChannelValue(byte channel);  
 void readReceiver();
+
+// readReceiver() runs at the control rate, the smooth factors are tuned for one read per 50Hz frame
+#define RECEIVER_SMOOTH_RATE 50.0
+unsigned long receiverReadTime = 0;
+
+#if defined (ReceiverInterpolation)
+  // A receiver frame shows as a change of the stick channels. From there the stick commands ramp
+  // from their last value to the new frame over one frame period, measured between frames, so
+  // that a control rate above the frame rate sees a slope instead of steps.
+  #define RECEIVER_MAX_FRAME_PERIOD 0.04 // s, longer gaps are sticks that did not move
+
+  int receiverFrameStart[THROTTLE + 1];
+  int receiverFrameTarget[THROTTLE + 1];
+  int receiverStick[THROTTLE + 1];
+  unsigned long receiverFrameTime = 0;
+  float receiverFramePeriod = 0.0; // s, no ramp until the sticks moved over two frames
+
+  void interpolateReceiverSticks(unsigned long now, float readDt) {
+    if (receiverFrameTime == 0) {
+      for (byte channel = XAXIS; channel <= THROTTLE; channel++) {
+        receiverFrameTarget[channel] = receiverStick[channel] = receiverData[channel];
+      }
+      receiverFrameTime = now;
+      return;
+    }
+
+    bool newFrame = false;
+    for (byte channel = XAXIS; channel <= THROTTLE; channel++) {
+      if (receiverData[channel] != receiverFrameTarget[channel]) {
+        newFrame = true;
+      }
+    }
+    if (newFrame) {
+      float interval = (now - receiverFrameTime) / 1000000.0;
+      if (interval < RECEIVER_MAX_FRAME_PERIOD) {
+        receiverFramePeriod = receiverFramePeriod > 0.0 ? filterSmooth(interval, receiverFramePeriod, 0.1) : interval;
+      }
+      receiverFrameTime = now;
+      for (byte channel = XAXIS; channel <= THROTTLE; channel++) {
+        receiverFrameStart[channel] = receiverStick[channel];
+        receiverFrameTarget[channel] = receiverData[channel];
+      }
+    }
+
+    // the frame came in during the last read interval, so the ramp is one read further
+    float ramp = (now - receiverFrameTime) / 1000000.0 + readDt;
+    for (byte channel = XAXIS; channel <= THROTTLE; channel++) {
+      if (ramp < receiverFramePeriod) {
+        receiverStick[channel] = receiverFrameStart[channel] + (receiverFrameTarget[channel] - receiverFrameStart[channel]) * ramp / receiverFramePeriod;
+      }
+      else {
+        receiverStick[channel] = receiverFrameTarget[channel];
+      }
+      receiverData[channel] = receiverStick[channel];
+    }
+  }
+#endif
   
+#if defined(FixedPointKernels)
+  #include <FixedPoint.h>
+
+  // Q16.16 copies of the calibration, converted again when the configuration changes
+  struct fixedCache receiverSlopeFixed[MAX_NB_CHANNEL];
+  struct fixedCache receiverOffsetFixed[MAX_NB_CHANNEL];
+  struct fixedCache receiverSmoothFactorFixed[MAX_NB_CHANNEL];
+  struct fixedCache receiverXmitFactorFixed;
+
+// Same processing with the integer results truncated like the float version does
 void readReceiver()
 {
+  const unsigned long smoothPeriod = 1000000 / (unsigned long)RECEIVER_SMOOTH_RATE;
+  unsigned long now = micros();
+  unsigned long readMicros = receiverReadTime ? now - receiverReadTime : smoothPeriod;
+  receiverReadTime = now;
+  // Q2.14 so that its product with a smooth factor within -1..1 stays in 32 bits
+  int32_t smoothTimeScale = readMicros < smoothPeriod ? (int32_t)((readMicros << 14) / smoothPeriod) : (1L << 14);
+
   for(byte channel = XAXIS; channel < lastReceiverChannel; channel++) {
+    // Apply receiver calibration adjustment
+    receiverData[channel] = (cachedFloatToFixed(receiverSlope[channel], &receiverSlopeFixed[channel]) * (int32_t)getRawChannelValue(channel) + 
+                             cachedFloatToFixed(receiverOffset[channel], &receiverOffsetFixed[channel])) >> 16;
+  }
+
+  #if defined (ReceiverInterpolation)
+    interpolateReceiverSticks(now, readMicros / 1000000.0);
+  #endif
+
+  for(byte channel = XAXIS; channel < lastReceiverChannel; channel++) {
+    // Smooth the flight control receiver inputs
+    int32_t smoothFactor = cachedFloatToFixed(receiverSmoothFactor[channel], &receiverSmoothFactorFixed[channel]);
+    if (smoothFactor == FIXED_ONE) {
+      receiverCommandSmooth[channel] = receiverData[channel];
+    }
+    else {
+      int32_t smoothScale = (constrain(smoothFactor, -FIXED_ONE, FIXED_ONE) * smoothTimeScale + (1L << 13)) >> 14;
+      receiverCommandSmooth[channel] += ((int32_t)(receiverData[channel] - receiverCommandSmooth[channel]) * smoothScale) >> 16;
+    }
+  }
+  
+  // Reduce receiver commands using receiverXmitFactor and center around 1500
+  int32_t xmitFactor = cachedFloatToFixed(receiverXmitFactor, &receiverXmitFactorFixed);
+  for (byte channel = XAXIS; channel < THROTTLE; channel++) {
+    receiverCommand[channel] = (((int32_t)(receiverCommandSmooth[channel] - receiverZero[channel]) * xmitFactor) >> 16) + receiverZero[channel];
+  }	
+  // No xmitFactor reduction applied for throttle, mode and AUX
+  for (byte channel = THROTTLE; channel < lastReceiverChannel; channel++) {
+    receiverCommand[channel] = receiverCommandSmooth[channel];
+  }
+}
+#else
+void readReceiver()
+{
+  unsigned long now = micros();
+  float readDt = receiverReadTime ? (now - receiverReadTime) / 1000000.0 : 1.0 / RECEIVER_SMOOTH_RATE;
+  receiverReadTime = now;
+  float smoothTimeScale = readDt < 1.0 / RECEIVER_SMOOTH_RATE ? readDt * RECEIVER_SMOOTH_RATE : 1.0;
 
+  for(byte channel = XAXIS; channel < lastReceiverChannel; channel++) {
     // Apply receiver calibration adjustment
     receiverData[channel] = (receiverSlope[channel] * getRawChannelValue(channel)) + receiverOffset[channel];
+  }
+
+  #if defined (ReceiverInterpolation)
+    interpolateReceiverSticks(now, readDt);
+  #endif
+
+  for(byte channel = XAXIS; channel < lastReceiverChannel; channel++) {
     // Smooth the flight control receiver inputs
-    receiverCommandSmooth[channel] = filterSmooth(receiverData[channel], receiverCommandSmooth[channel], receiverSmoothFactor[channel]);
+    receiverCommandSmooth[channel] = filterSmoothWithTime(receiverData[channel], receiverCommandSmooth[channel], receiverSmoothFactor[channel], smoothTimeScale);
   }
   
   // Reduce receiver commands using receiverXmitFactor and center around 1500
@@ -104,6 +224,7 @@ void readReceiver()
     receiverCommand[channel] = receiverCommandSmooth[channel];
   }
 }
+#endif
 
 
 void setChannelValue(byte channel,int value);
@@ -32,9 +32,19 @@
 #include "Receiver.h"
 
 #define SBUS_SYNCBYTE 0x0F // some sites say 0xF0
+#define SBUS_FRAME_SIZE 25
+#define SBUS_CHANNELS 16
   
 #define SERIAL_SBUS Serial3  
 
+// on STM32 the frames are decoded from the RX interrupt as soon as the line goes idle,
+// elsewhere when the receiver is read
+#if defined (AeroQuadSTM32)
+  #define SBUS_RECEIVE_TIME() SERIAL_SBUS.lastReceiveTime()
+#else
+  #define SBUS_RECEIVE_TIME() micros()
+#endif
+
 // 16 analog, 2 digital channels
 static unsigned int rcChannel[18] = {XAXIS,YAXIS,THROTTLE,ZAXIS,MODE,AUX1,AUX2,AUX3,AUX4,AUX5,10,11,12,13,14,15,16,17};
 static unsigned int sbusIndex = 0;
@@ -44,18 +54,46 @@ static unsigned int sbusIndex = 0;
   static unsigned short sbusRate = 0;
 #endif
 
-void initializeReceiver(int nbChannel = 10) {
-  initializeReceiverParam(nbChannel);
-  #if defined (AeroQuadSTM32)
-    pinMode(BOARD_SPI2_NSS_PIN, OUTPUT);
-    digitalWrite(BOARD_SPI2_NSS_PIN,HIGH); // GPIO PB12 /Libmaple/libmaple/wirish/boards/aeroquad32.h line 69
-  #endif
-  SERIAL_SBUS.begin(100000);
+// rcChannel entry of each SBUS channel
+static const byte sbusChannelMap[SBUS_CHANNELS] = {XAXIS,YAXIS,THROTTLE,ZAXIS,MODE,AUX1,AUX2,AUX3,AUX4,AUX5,10,11,12,13,14,15};
+
+// first frame byte and bit of each 11 bit channel, channel n starts at bit 11 * n of byte 1
+struct sbusChannelBits {
+  byte offset;
+  byte shift;
+};
+static const sbusChannelBits sbusUnpack[SBUS_CHANNELS] = {
+  {1,0}, {2,3}, {3,6}, {5,1}, {6,4}, {7,7}, {9,2}, {10,5},
+  {12,0}, {13,3}, {14,6}, {16,1}, {17,4}, {18,7}, {20,2}, {21,5}
+};
+
+// decoded frames, the decoder fills the one that is not in front and then swaps
+static volatile unsigned int sbusFrames[2][SBUS_CHANNELS];
+static volatile byte sbusFrontFrame = 0;
+static volatile byte sbusFrameSequence = 0;
+static volatile bool sbusFrameReceived = false;
+volatile unsigned long sbusFrameTime = 0; // micros() when the last good frame was complete
+
+void decodeSBUSFrame(const byte *sbus) {
+  byte back = sbusFrontFrame ^ 1;
+  for (byte channel = 0; channel < SBUS_CHANNELS; channel++) {
+    const byte *bits = &sbus[sbusUnpack[channel].offset];
+    byte shift = sbusUnpack[channel].shift;
+    unsigned int value = (bits[0] | ((unsigned int)bits[1] << 8)) >> shift;
+    if (shift > 5) {
+      value |= (unsigned int)bits[2] << (16 - shift);
+    }
+    sbusFrames[back][channel] = value & 0x07FF;
+  }
+  sbusFrameTime = SBUS_RECEIVE_TIME();
+  sbusFrontFrame = back;
+  sbusFrameSequence++;
+  sbusFrameReceived = true;
 }
 
 void readSBUS() {
 
-  static byte sbus[25] = {0};
+  static byte sbus[SBUS_FRAME_SIZE] = {0};
   while(SERIAL_SBUS.available()) {
   
     int val = SERIAL_SBUS.read();
@@ -65,25 +103,13 @@ void readSBUS() {
 	
     sbus[sbusIndex] = val;
     sbusIndex++;
-    if (sbusIndex == 25) {
+    if (sbusIndex == SBUS_FRAME_SIZE) {
 	
       sbusIndex = 0;
       // check stop bit before updating buffers
       if (sbus[24] == 0x0) {
 	  
-        rcChannel[XAXIS]	= ((sbus[1]     | sbus[2]<<8)  & 0x07FF);					// pitch
-        rcChannel[YAXIS]	= ((sbus[2]>>3  | sbus[3]<<5)  & 0x07FF);					// roll
-        rcChannel[THROTTLE] = ((sbus[3]>>6  | sbus[4]<<2   | sbus[5]<<10) & 0x07FF);	// throttle
-        rcChannel[ZAXIS]	= ((sbus[5]>>1  | sbus[6]<<7)  & 0x07FF);					// yaw
-        rcChannel[MODE]		= ((sbus[6]>>4  | sbus[7]<<4)  & 0x07FF);
-        rcChannel[AUX1]		= ((sbus[7]>>7  | sbus[8]<<1   | sbus[9]<<9) & 0x07FF);
-        rcChannel[AUX2]		= ((sbus[9]>>2  | sbus[10]<<6) & 0x07FF);
-        rcChannel[AUX3]		= ((sbus[10]>>5 | sbus[11]<<3) & 0x07FF);
-        rcChannel[AUX4]		= ((sbus[12]    | sbus[13]<<8) & 0x07FF);
-        rcChannel[AUX5]		= ((sbus[13]>>3 | sbus[14]<<5) & 0x07FF);
-        //rcChannel[AUX6]		= ((sbus[14]>>6 | sbus[15]<<2|sbus[16]<<10) & 0x07FF);
-        //rcChannel[AUX7]		= ((sbus[16]>>1 | sbus[17]<<7) & 0x07FF);
-
+        decodeSBUSFrame(sbus);
 
 	   #ifdef UseSBUSRSSIReader
 		if (sbusRate == 0) {
@@ -102,9 +128,39 @@ void readSBUS() {
   }
 }
 
+void initializeReceiver(int nbChannel = 10) {
+  initializeReceiverParam(nbChannel);
+  #if defined (AeroQuadSTM32)
+    pinMode(BOARD_SPI2_NSS_PIN, OUTPUT);
+    digitalWrite(BOARD_SPI2_NSS_PIN,HIGH); // GPIO PB12 /Libmaple/libmaple/wirish/boards/aeroquad32.h line 69
+  #endif
+  SERIAL_SBUS.begin(100000);
+  #if defined (AeroQuadSTM32)
+    SERIAL_SBUS.attachRxInterrupt(readSBUS);
+  #endif
+}
+
+// copy the front frame into rcChannel, again if a new frame came in meanwhile
+void latchSBUSFrame() {
+  if (!sbusFrameReceived) {
+    return;
+  }
+  byte sequence;
+  do {
+    sequence = sbusFrameSequence;
+    const volatile unsigned int *frame = sbusFrames[sbusFrontFrame];
+    for (byte channel = 0; channel < SBUS_CHANNELS; channel++) {
+      rcChannel[sbusChannelMap[channel]] = frame[channel];
+    }
+  } while (sequence != sbusFrameSequence);
+}
+
 int getRawChannelValue(byte channel) {
     if (channel == XAXIS) {
-	  readSBUS();
+      #if !defined (AeroQuadSTM32)
+	    readSBUS();
+      #endif
+      latchSBUSFrame();
 	}
 	return rcChannel[channel];
 }
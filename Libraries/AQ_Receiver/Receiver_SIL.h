@@ -0,0 +1,48 @@
+/*
+  AeroQuad v3.x
+  www.AeroQuad.com
+  Copyright (c) 2012 Ted Carancho.  All rights reserved.
+  An Open Source Arduino based multicopter.
+ 
+  This program is free software: you can redistribute it and/or modify 
+  it under the terms of the GNU General Public License as published by 
+  the Free Software Foundation, either version 3 of the License, or 
+  (at your option) any later version. 
+
+  This program is distributed in the hope that it will be useful, 
+  but WITHOUT ANY WARRANTY; without even the implied warranty of 
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the 
+  GNU General Public License for more details. 
+
+  You should have received a copy of the GNU General Public License 
+  along with this program. If not, see <http://www.gnu.org/licenses/>. 
+*/
+
+#ifndef _AEROQUAD_RECEIVER_SIL_H_
+#define _AEROQUAD_RECEIVER_SIL_H_
+
+#if defined(AeroQuadSIL)
+
+#include "Arduino.h"
+#include "Receiver.h"
+
+// Receiver input of the Linux host build.
+// The test harness writes pulse widths in us to silReceiverInput[],
+// default is sticks centered with throttle, mode and AUX low
+
+int silReceiverInput[MAX_NB_CHANNEL] = {1500,1500,1500,1000,1000,1000,1000,1000,1000,1000};
+
+void initializeReceiver(int nbChannel = 8) {
+
+  initializeReceiverParam(nbChannel);
+}
+
+int getRawChannelValue(byte channel) {
+  return silReceiverInput[channel];
+}
+
+void setChannelValue(byte channel,int value) {
+}
+
+#endif
+#endif
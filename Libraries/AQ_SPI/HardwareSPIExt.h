@@ -7,16 +7,54 @@
 // used by the MPU6000 library
 
 #include <HardwareSPI.h>
+#ifdef STM32F2
+  #include <dma.h>
+#endif
 
 #define SPI_READ_FLAG  0x80
 #define SPI_MULTI_FLAG 0x40
 #define SetPin digitalWrite
 
+#ifdef STM32F2
+// DMA streams of the SPI peripherals (RM0090 DMA request mapping). They are looked up by the
+// register base, libmaple's SPI4 is SPI3 on other pins and needs the SPI3 streams.
+struct SPIDMAStreams {
+	spi_reg_map *regs;
+	dma_dev **dev;
+	dma_stream rxStream;
+	dma_stream txStream;
+	uint32 channel;
+};
+
+static const SPIDMAStreams spiDMAStreams[] = {
+	{SPI1_BASE, &DMA2, DMA_STREAM0, DMA_STREAM3, DMA_CR_CH3},
+	{SPI2_BASE, &DMA1, DMA_STREAM3, DMA_STREAM4, DMA_CR_CH0},
+	{SPI3_BASE, &DMA1, DMA_STREAM0, DMA_STREAM7, DMA_CR_CH0},
+};
+
+#define SPI_DMA_TIMEOUT 2000 // us
+#endif
+
+// state of the last ReadDMAStart()
+#define SPI_DMA_IDLE  0
+#define SPI_DMA_BUSY  1
+#define SPI_DMA_DONE  2
+#define SPI_DMA_ERROR 3 // transfer error or timeout, the data is incomplete
+
 class HardwareSPIExt : public HardwareSPI {
 public:
 	HardwareSPIExt(uint32 spiPortNumber) : HardwareSPI(spiPortNumber) {
 		SetCS(nssPin());
 		fSpiMultiFlag = 0;
+		fDMAStatus = SPI_DMA_IDLE;
+#ifdef STM32F2
+		fDMAStreams = NULL;
+		for (unsigned int i = 0; i < sizeof(spiDMAStreams)/sizeof(spiDMAStreams[0]); i++) {
+			if (spiDMAStreams[i].regs == c_dev()->regs) {
+				fDMAStreams = &spiDMAStreams[i];
+			}
+		}
+#endif
 	}
 
 	void SetCS(int aCS)
@@ -38,6 +76,7 @@ public:
 
 	void Read(int addr, unsigned char *data, int dataLen)
 	{
+		ReadDMAWait();
 		SetPin(fCS, 0);
 		transfer(addr | SPI_READ_FLAG | fSpiMultiFlag);
 		while(dataLen-- > 0) {
@@ -54,8 +93,76 @@ public:
 		return data;
 	}
 
+	// Burst read where the data bytes are clocked by DMA instead of one transfer() per byte.
+	// It only starts the transfer, poll ReadDMAStatus() until it is no longer SPI_DMA_BUSY before
+	// the data is used. Without DMA streams for the port the data is read by Read() right away.
+	void ReadDMAStart(int addr, unsigned char *data, int dataLen)
+	{
+		ReadDMAWait();
+#ifdef STM32F2
+		if (fDMAStreams != NULL) {
+			dma_dev *dma = *fDMAStreams->dev;
+			spi_dev *spi = c_dev();
+			const uint32 flags = fDMAStreams->channel | DMA_CR_MSIZE_8BITS | DMA_CR_PSIZE_8BITS;
+
+			dma_init(dma);
+			SetPin(fCS, 0);
+			transfer(addr | SPI_READ_FLAG | fSpiMultiFlag);
+
+			// RX first so no byte is missed, TX sends the same dummy byte over and over
+			fDummy = 0;
+			dma_setup_transfer(dma, fDMAStreams->rxStream, &spi->regs->DR, data, NULL,
+			                   flags | DMA_CR_PL_VERY_HIGH | DMA_CR_MINC | DMA_CR_DIR_P2M, 0);
+			dma_set_num_transfers(dma, fDMAStreams->rxStream, dataLen);
+			dma_setup_transfer(dma, fDMAStreams->txStream, &spi->regs->DR, &fDummy, NULL,
+			                   flags | DMA_CR_PL_HIGH | DMA_CR_DIR_M2P, 0);
+			dma_set_num_transfers(dma, fDMAStreams->txStream, dataLen);
+			dma_clear_isr_bits(dma, fDMAStreams->rxStream);
+			dma_clear_isr_bits(dma, fDMAStreams->txStream);
+			dma_enable(dma, fDMAStreams->rxStream);
+			dma_enable(dma, fDMAStreams->txStream);
+			spi_rx_dma_enable(spi);
+			spi_tx_dma_enable(spi);
+			fDMAStart = micros();
+			fDMAStatus = SPI_DMA_BUSY;
+			return;
+		}
+#endif
+		Read(addr, data, dataLen);
+		fDMAStatus = SPI_DMA_DONE;
+	}
+
+	// does not wait, ends the transfer once the last byte is received
+	uint8 ReadDMAStatus()
+	{
+#ifdef STM32F2
+		if (fDMAStatus == SPI_DMA_BUSY) {
+			uint8 bits = dma_get_isr_bits(*fDMAStreams->dev, fDMAStreams->rxStream);
+			if (bits & 0x08) {
+				ReadDMAEnd(SPI_DMA_ERROR); // transfer error
+			}
+			else if (bits & 0x02) {
+				ReadDMAEnd(SPI_DMA_DONE);
+			}
+			else if (micros() - fDMAStart > SPI_DMA_TIMEOUT) {
+				ReadDMAEnd(SPI_DMA_ERROR);
+			}
+		}
+#endif
+		return fDMAStatus;
+	}
+
+	// the bus is not shared with a running burst, Read() and Write() wait for its end
+	uint8 ReadDMAWait()
+	{
+		while (ReadDMAStatus() == SPI_DMA_BUSY)
+			;
+		return fDMAStatus;
+	}
+
 	void Write(int addr, unsigned char *data, int dataLen)
 	{
+		ReadDMAWait();
 		SetPin(fCS, 0);
 		transfer(addr | fSpiMultiFlag);
 		while(dataLen-- > 0) {
@@ -71,8 +178,26 @@ public:
 
 
 private:
+#ifdef STM32F2
+	void ReadDMAEnd(uint8 status)
+	{
+		dma_dev *dma = *fDMAStreams->dev;
+		spi_dev *spi = c_dev();
+		spi_tx_dma_disable(spi);
+		spi_rx_dma_disable(spi);
+		dma_disable(dma, fDMAStreams->txStream);
+		dma_disable(dma, fDMAStreams->rxStream);
+		SetPin(fCS, 1);
+		fDMAStatus = status;
+	}
+
+	const SPIDMAStreams *fDMAStreams;
+	uint32 fDMAStart;
+#endif
 	int fCS;
 	unsigned char fSpiMultiFlag;
+	unsigned char fDummy;
+	uint8 fDMAStatus;
 };
 
 #endif
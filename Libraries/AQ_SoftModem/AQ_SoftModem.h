@@ -19,7 +19,7 @@
   Uses 
   - DAC channel 1 to pin PA4
   - Timers 6 and 7
-  - DMA1 Stream 5
+  - DMA1 Stream 5 (the RX stream of USART2, which falls back to RX by interrupt)
   
 */
 
@@ -88,6 +88,7 @@ void softmodemInit()
   dac_init(DAC,0); // do not enable yet
   pinMode(SOFTMODEM_PIN, INPUT_ANALOG);
 
+  usart_rx_dma_release(USART2);
   dma_init(DMA1);
   dma_setup_transfer(DMA1, DMA_STREAM5, &DAC->regs->DHR8R1, softmodemDMABuffer, softmodemDMABuffer,
 		     DMA_CR_CH7|DMA_CR_CT1|DMA_CR_DBM|DMA_CR_PL_VERY_HIGH|DMA_CR_MINC|DMA_CR_CIRC|DMA_CR_DIR_M2P,